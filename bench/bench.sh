@@ -0,0 +1,119 @@
+#!/bin/sh
+# time each table of elfy on synthetic elfs (make bench)
+#
+# usage: bench.sh ELFY GENELF
+#
+# every option runs BENCH_RUNS times (default 3) on each file and the best
+# time is kept. Small tables are displayed for the same file given many times
+# (with -j 1), and the time of -h per file (opening and mapping the file) is
+# taken off, so ns/entry and MB/s (of output) are about the dumper alone.
+# BENCH_SIZES picks the files: small, medium, large (the default is all
+# three) and huge (10M symbols, several GB of output)
+
+set -e
+
+elfy=${1:-./elfy}
+genelf=${2:-bench/genelf}
+runs=${BENCH_RUNS:-3}
+sizes=${BENCH_SIZES:-small medium large}
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+# symbols sections dynsyms dynamic relocs phdrs
+size_args() {
+    case $1 in
+        small)  echo 1000 64 1000 100 1000 16 ;;
+        medium) echo 100000 4096 10000 1000 100000 256 ;;
+        large)  echo 1000000 65536 100000 100000 1000000 4096 ;;
+        huge)   echo 10000000 65536 1000000 1000000 10000000 16384 ;;
+        *)      echo "bench.sh: unknown size: $1" >&2; exit 1 ;;
+    esac
+}
+
+now() {
+    date +%s%N
+}
+
+# best time in ns of elfy with the given option on a file given n times, the
+# output is left in $dir/out
+best_time() {
+    option=$1 file=$2 n=$3
+    best=
+    i=0
+
+    files=
+    while [ $i -lt "$n" ]; do
+        files="$files $file"
+        i=$((i + 1))
+    done
+
+    i=0
+    while [ $i -lt "$runs" ]; do
+        start=$(now)
+        "$elfy" --no-color -j 1 "$option" $files > "$dir/out"
+        end=$(now)
+
+        time=$((end - start))
+        if [ -z "$best" ] || [ $time -lt "$best" ]; then
+            best=$time
+        fi
+
+        i=$((i + 1))
+    done
+
+    echo "$best"
+}
+
+printf '%-8s %-16s %10s %10s %10s %10s\n' size option entries ms ns/entry MB/s
+
+for size in $sizes; do
+    set -- $(size_args "$size")
+    symbols=$1 sections=$2 dynsyms=$3 dynamic=$4 relocs=$5 phdrs=$6
+    file=$dir/$size.so
+
+    "$genelf" --symbols="$symbols" --sections="$sections" \
+              --dynsyms="$dynsyms" --dynamic="$dynamic" --relocs="$relocs" \
+              --phdrs="$phdrs" "$file"
+
+    # time per file of everything but the tables
+    base=$(($(best_time -h "$file" 1000) / 1000))
+    printf '%-8s %-16s %10s %10s %10s %10s\n' "$size" -h 1 \
+           "$(awk "BEGIN { printf(\"%.2f\", $base / 1e6) }")" - -
+
+    # option and number of entries it displays (the counts include the
+    # entries genelf always adds)
+    for test in "-p $((phdrs + 3))" \
+                "-s $((sections + 9))" \
+                "-d $((dynamic + 9))" \
+                "--symtab $((symbols + 1))" \
+                "--dyn-syms $((dynsyms + 1))" \
+                "--relocs $relocs" \
+                "--reloc-summary $relocs" \
+                "--hash-stats $dynsyms"; do
+        set -- $test
+        option=$1 entries=$2
+
+        # about a million entries in all
+        n=$((entries < 1000 ? 1000 : 1000000 / entries))
+        n=$((n < 1 ? 1 : n))
+
+        time=$(best_time "$option" "$file" $n)
+        bytes=$(($(wc -c < "$dir/out") / n))
+
+        # what's left of one file after the startup (0 when it's lost in the
+        # noise)
+        time=$((time / n > base ? time / n - base : 0))
+
+        awk -v size="$size" -v option="$option" -v entries="$entries" \
+            -v time="$time" -v bytes="$bytes" 'BEGIN {
+            if(time == 0)
+                printf("%-8s %-16s %10d %10.2f %10s %10s\n", size, option,
+                       entries, 0, "-", "-")
+            else
+                printf("%-8s %-16s %10d %10.2f %10.1f %10.1f\n", size,
+                       option, entries, time / 1e6, time / entries,
+                       bytes / 1048576 / (time / 1e9))
+        }'
+    done
+done
@@ -0,0 +1,527 @@
+// write a synthetic x86-64 shared object of a given scale, for make bench
+//
+// the file holds a symbol table, a dynamic symbol table with its hash table,
+// relocations, a dynamic section and as many (empty) sections and program
+// headers as asked for. Nothing in it is ever loaded or run, each table only
+// has to look like the real thing to the dumpers
+
+#include "../elf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+
+#define PAGE_SIZE 0x1000
+
+// sections that are always there, the filler sections come after them
+enum {
+    SEC_NULL,
+    SEC_DYNSYM,
+    SEC_DYNSTR,
+    SEC_HASH,
+    SEC_RELA,
+    SEC_DYNAMIC,
+    SEC_SYMTAB,
+    SEC_STRTAB,
+    SEC_SHSTRTAB,
+    SEC_NUM
+};
+
+// number of entries of each table (options)
+size_t symbols_num = 1000;
+size_t sections_num = 0;
+size_t dynsyms_num = 1000;
+size_t dynamic_num = 100;
+size_t relocs_num = 1000;
+size_t phdrs_num = 0;
+
+FILE *out;
+char *out_path;
+
+void write_error(void) {
+    fprintf(stderr, "genelf: cannot write %s: %s\n", out_path,
+            strerror(errno));
+    exit(EXIT_FAILURE);
+}
+
+void put(const void *buf, size_t len) {
+    if(fwrite(buf, 1, len, out) != len)
+        write_error();
+}
+
+// write zeros up to offset
+void pad_to(size_t offset) {
+    static const char zeros[64];
+    long pos = ftell(out);
+
+    if(pos < 0)
+        write_error();
+
+    while((size_t) pos < offset) {
+        size_t len = offset - pos < sizeof(zeros) ? offset - pos : sizeof(zeros);
+
+        put(zeros, len);
+        pos += len;
+    }
+}
+
+size_t align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+// name of a symbol, the same in the strtab and dynstr
+int symbol_name(char *buf, size_t size, const char *prefix, size_t index) {
+    return snprintf(buf, size, "%s_%zu", prefix, index);
+}
+
+// size of a string table made of prefix_0 to prefix_(num - 1), after the
+// leading NUL
+size_t names_size(const char *prefix, size_t num) {
+    char name[64];
+    size_t size = 1;
+
+    for(size_t i = 0; i < num; i++)
+        size += symbol_name(name, sizeof(name), prefix, i) + 1;
+
+    return size;
+}
+
+void put_names(const char *prefix, size_t num) {
+    char name[64];
+
+    put("", 1);
+
+    for(size_t i = 0; i < num; i++) {
+        int len = symbol_name(name, sizeof(name), prefix, i);
+
+        put(name, len + 1);
+    }
+}
+
+unsigned long elf_hash(const char *name) {
+    unsigned long h = 0, g;
+
+    while(*name) {
+        h = (h << 4) + (unsigned char) *name++;
+        g = h & 0xf0000000;
+        if(g)
+            h ^= g >> 24;
+        h &= ~g;
+    }
+
+    return h;
+}
+
+void usage(FILE *stream) {
+    fprintf(stream,
+            "Usage: genelf [OPTIONS] FILE\n"
+            "Write a synthetic ELF to FILE\n\n"
+            "  --symbols=N    entries of the symbol table (default 1000)\n"
+            "  --sections=N   empty sections besides the tables (default 0)\n"
+            "  --dynsyms=N    entries of the dynamic symbol table (default 1000)\n"
+            "  --dynamic=N    DT_NEEDED entries of the dynamic section (default 100)\n"
+            "  --relocs=N     relocation entries (default 1000)\n"
+            "  --phdrs=N      PT_LOAD entries besides the needed ones (default 0)\n");
+}
+
+int main(int argc, char **argv) {
+    const struct option long_opts[] = {
+        {"symbols",  required_argument, NULL, 'y'},
+        {"sections", required_argument, NULL, 's'},
+        {"dynsyms",  required_argument, NULL, 'Y'},
+        {"dynamic",  required_argument, NULL, 'd'},
+        {"relocs",   required_argument, NULL, 'r'},
+        {"phdrs",    required_argument, NULL, 'p'},
+        {0,          0,                 0,    0}
+    };
+    size_t shnum, phnum, nbucket, dynstr_size, strtab_size, shstrtab_size;
+    size_t dynamic_entries, needed_offset, filler_names_offset;
+    size_t off_dynsym, off_dynstr, off_hash, off_rela, off_dynamic,
+           off_symtab, off_strtab, off_shstrtab, off_shdrs, end;
+    Elf64_Ehdr ehdr;
+    Elf64_Shdr shdr;
+    unsigned int *buckets;
+    unsigned int *chains;
+    int opt;
+
+    while((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        char *arg_end;
+        size_t num;
+
+        if(opt == '?') {
+            usage(stderr);
+            exit(EXIT_FAILURE);
+        }
+
+        num = strtoull(optarg, &arg_end, 10);
+        if(*arg_end != '\0' || optarg[0] == '-') {
+            fprintf(stderr, "genelf: invalid number: %s\n", optarg);
+            exit(EXIT_FAILURE);
+        }
+
+        switch(opt) {
+            case 'y':
+                symbols_num = num;
+                break;
+            case 's':
+                sections_num = num;
+                break;
+            case 'Y':
+                dynsyms_num = num;
+                break;
+            case 'd':
+                dynamic_num = num;
+                break;
+            case 'r':
+                relocs_num = num;
+                break;
+            case 'p':
+                phdrs_num = num;
+                break;
+        }
+    }
+
+    if(optind != argc - 1) {
+        usage(stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    // PT_PHDR, PT_LOAD and PT_DYNAMIC come first
+    phnum = 3 + phdrs_num;
+    if(phnum >= PN_XNUM) {
+        fprintf(stderr, "genelf: too many program headers\n");
+        exit(EXIT_FAILURE);
+    }
+
+    shnum = SEC_NUM + sections_num;
+
+    // DT_NEEDED entries, then the tables and DT_NULL
+    dynamic_entries = dynamic_num + 9;
+
+    // the dynstr holds the dynamic symbol names and then lib_N for DT_NEEDED
+    needed_offset = names_size("dsym", dynsyms_num);
+    dynstr_size = needed_offset + names_size("lib", dynamic_num) - 1;
+    strtab_size = names_size("sym", symbols_num);
+
+    // the shstrtab holds the names of the tables and then sec_N
+    filler_names_offset = sizeof("\0.dynsym\0.dynstr\0.hash\0.rela.dyn\0"
+                                 ".dynamic\0.symtab\0.strtab\0.shstrtab");
+    shstrtab_size = filler_names_offset + names_size("sec", sections_num) - 1;
+
+    nbucket = dynsyms_num / 2 + 1;
+
+    off_dynsym = align(sizeof(Elf64_Ehdr) + phnum * sizeof(Elf64_Phdr), 8);
+    off_dynstr = off_dynsym + (dynsyms_num + 1) * sizeof(Elf64_Sym);
+    off_hash = align(off_dynstr + dynstr_size, 8);
+    off_rela = align(off_hash + (2 + nbucket + dynsyms_num + 1) * 4, 8);
+    off_dynamic = off_rela + relocs_num * sizeof(Elf64_Rela);
+    off_symtab = off_dynamic + dynamic_entries * sizeof(Elf64_Dyn);
+    off_strtab = off_symtab + (symbols_num + 1) * sizeof(Elf64_Sym);
+    off_shstrtab = off_strtab + strtab_size;
+    off_shdrs = align(off_shstrtab + shstrtab_size, 8);
+    end = off_shdrs + shnum * sizeof(Elf64_Shdr);
+
+    out_path = argv[optind];
+    out = fopen(out_path, "wb");
+    if(!out)
+        write_error();
+
+    // elf header, the section count goes in the first section header when
+    // it doesn't fit
+    memset(&ehdr, 0, sizeof(ehdr));
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_DYN;
+    ehdr.e_machine = EM_X86_64;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_phoff = sizeof(Elf64_Ehdr);
+    ehdr.e_shoff = off_shdrs;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_phentsize = sizeof(Elf64_Phdr);
+    ehdr.e_phnum = phnum;
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = shnum < SHN_LORESERVE ? shnum : 0;
+    ehdr.e_shstrndx = SEC_SHSTRTAB;
+    put(&ehdr, sizeof(ehdr));
+
+    // program headers, the file is loaded at address 0 as a whole
+    for(size_t i = 0; i < phnum; i++) {
+        Elf64_Phdr phdr;
+
+        memset(&phdr, 0, sizeof(phdr));
+
+        if(i == 0) {
+            phdr.p_type = PT_PHDR;
+            phdr.p_offset = phdr.p_vaddr = phdr.p_paddr = sizeof(Elf64_Ehdr);
+            phdr.p_filesz = phdr.p_memsz = phnum * sizeof(Elf64_Phdr);
+            phdr.p_flags = PF_R;
+            phdr.p_align = 8;
+        } else if(i == 1) {
+            phdr.p_type = PT_LOAD;
+            phdr.p_filesz = phdr.p_memsz = off_shdrs;
+            phdr.p_flags = PF_R | PF_W;
+            phdr.p_align = PAGE_SIZE;
+        } else if(i == 2) {
+            phdr.p_type = PT_DYNAMIC;
+            phdr.p_offset = phdr.p_vaddr = phdr.p_paddr = off_dynamic;
+            phdr.p_filesz = phdr.p_memsz = dynamic_entries * sizeof(Elf64_Dyn);
+            phdr.p_flags = PF_R | PF_W;
+            phdr.p_align = 8;
+        } else {
+            // empty segments one page apart after the file
+            phdr.p_type = PT_LOAD;
+            phdr.p_vaddr = phdr.p_paddr = align(end, PAGE_SIZE) +
+                                          (i - 3) * PAGE_SIZE;
+            phdr.p_memsz = PAGE_SIZE;
+            phdr.p_flags = PF_R;
+            phdr.p_align = PAGE_SIZE;
+        }
+
+        put(&phdr, sizeof(phdr));
+    }
+
+    // dynamic symbols, all global functions
+    pad_to(off_dynsym);
+    for(size_t i = 0, name = 1; i <= dynsyms_num; i++) {
+        Elf64_Sym sym;
+        char buf[64];
+
+        memset(&sym, 0, sizeof(sym));
+
+        if(i > 0) {
+            sym.st_name = name;
+            sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+            sym.st_shndx = SHN_ABS;
+            sym.st_value = 0x10000 + (i - 1) * 16;
+            sym.st_size = 16;
+
+            name += symbol_name(buf, sizeof(buf), "dsym", i - 1) + 1;
+        }
+
+        put(&sym, sizeof(sym));
+    }
+
+    put_names("dsym", dynsyms_num);
+    for(size_t i = 0; i < dynamic_num; i++) {
+        char name[64];
+        int len = symbol_name(name, sizeof(name), "lib", i);
+
+        put(name, len + 1);
+    }
+
+    // sysv hash table of the dynamic symbols
+    buckets = calloc(nbucket, sizeof(*buckets));
+    chains = calloc(dynsyms_num + 1, sizeof(*chains));
+    if(!buckets || !chains) {
+        fprintf(stderr, "genelf: calloc() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    for(size_t i = 1; i <= dynsyms_num; i++) {
+        char name[64];
+        size_t bucket;
+
+        symbol_name(name, sizeof(name), "dsym", i - 1);
+        bucket = elf_hash(name) % nbucket;
+
+        chains[i] = buckets[bucket];
+        buckets[bucket] = i;
+    }
+
+    pad_to(off_hash);
+    {
+        unsigned int header[2] = {nbucket, dynsyms_num + 1};
+
+        put(header, sizeof(header));
+        put(buckets, nbucket * sizeof(*buckets));
+        put(chains, (dynsyms_num + 1) * sizeof(*chains));
+    }
+
+    free(buckets);
+    free(chains);
+
+    // relocations, relative ones and symbol ones in turn
+    pad_to(off_rela);
+    for(size_t i = 0; i < relocs_num; i++) {
+        Elf64_Rela rela;
+
+        rela.r_offset = 0x100000 + i * 8;
+
+        if(i % 2 == 0 || dynsyms_num == 0) {
+            rela.r_info = ELF64_R_INFO(0, R_X86_64_RELATIVE);
+            rela.r_addend = 0x10000 + i;
+        } else {
+            rela.r_info = ELF64_R_INFO(1 + i % dynsyms_num, R_X86_64_GLOB_DAT);
+            rela.r_addend = 0;
+        }
+
+        put(&rela, sizeof(rela));
+    }
+
+    // dynamic section
+    {
+        Elf64_Dyn tables[] = {
+            {DT_HASH, {off_hash}},
+            {DT_STRTAB, {off_dynstr}},
+            {DT_SYMTAB, {off_dynsym}},
+            {DT_STRSZ, {dynstr_size}},
+            {DT_SYMENT, {sizeof(Elf64_Sym)}},
+            {DT_RELA, {off_rela}},
+            {DT_RELASZ, {relocs_num * sizeof(Elf64_Rela)}},
+            {DT_RELAENT, {sizeof(Elf64_Rela)}},
+            {DT_NULL, {0}}
+        };
+        char name[64];
+        size_t name_offset = needed_offset;
+
+        for(size_t i = 0; i < dynamic_num; i++) {
+            Elf64_Dyn dyn = {DT_NEEDED, {name_offset}};
+
+            name_offset += symbol_name(name, sizeof(name), "lib", i) + 1;
+            put(&dyn, sizeof(dyn));
+        }
+
+        put(tables, sizeof(tables));
+    }
+
+    // symbol table, a tenth of local objects and then global functions,
+    // spread over the sections that don't need an extended index
+    for(size_t i = 0, name = 1; i <= symbols_num; i++) {
+        size_t locals = symbols_num / 10;
+        size_t fillers = sections_num < SHN_LORESERVE - SEC_NUM ?
+                         sections_num : SHN_LORESERVE - SEC_NUM;
+        Elf64_Sym sym;
+        char buf[64];
+
+        memset(&sym, 0, sizeof(sym));
+
+        if(i > 0) {
+            sym.st_name = name;
+            sym.st_info = i <= locals ? ELF64_ST_INFO(STB_LOCAL, STT_OBJECT) :
+                                        ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+            sym.st_other = i % 7 == 0 ? STV_HIDDEN : STV_DEFAULT;
+            sym.st_shndx = fillers ? SEC_NUM + i % fillers : SHN_ABS;
+            sym.st_value = 0x200000 + (i - 1) * 32;
+            sym.st_size = 32;
+
+            name += symbol_name(buf, sizeof(buf), "sym", i - 1) + 1;
+        }
+
+        put(&sym, sizeof(sym));
+    }
+
+    put_names("sym", symbols_num);
+
+    // section names (put_names adds the NUL of .shstrtab)
+    put("\0.dynsym\0.dynstr\0.hash\0.rela.dyn\0.dynamic\0.symtab\0.strtab\0"
+        ".shstrtab", filler_names_offset - 1);
+    put_names("sec", sections_num);
+
+    // section headers
+    pad_to(off_shdrs);
+    for(size_t i = 0, name = filler_names_offset; i < shnum; i++) {
+        char buf[64];
+
+        memset(&shdr, 0, sizeof(shdr));
+
+        switch(i) {
+            case SEC_NULL:
+                if(shnum >= SHN_LORESERVE)
+                    shdr.sh_size = shnum;
+                break;
+            case SEC_DYNSYM:
+                shdr.sh_name = 1;
+                shdr.sh_type = SHT_DYNSYM;
+                shdr.sh_flags = SHF_ALLOC;
+                shdr.sh_offset = shdr.sh_addr = off_dynsym;
+                shdr.sh_size = (dynsyms_num + 1) * sizeof(Elf64_Sym);
+                shdr.sh_link = SEC_DYNSTR;
+                shdr.sh_info = 1;
+                shdr.sh_addralign = 8;
+                shdr.sh_entsize = sizeof(Elf64_Sym);
+                break;
+            case SEC_DYNSTR:
+                shdr.sh_name = 9;
+                shdr.sh_type = SHT_STRTAB;
+                shdr.sh_flags = SHF_ALLOC;
+                shdr.sh_offset = shdr.sh_addr = off_dynstr;
+                shdr.sh_size = dynstr_size;
+                shdr.sh_addralign = 1;
+                break;
+            case SEC_HASH:
+                shdr.sh_name = 17;
+                shdr.sh_type = SHT_HASH;
+                shdr.sh_flags = SHF_ALLOC;
+                shdr.sh_offset = shdr.sh_addr = off_hash;
+                shdr.sh_size = (2 + nbucket + dynsyms_num + 1) * 4;
+                shdr.sh_link = SEC_DYNSYM;
+                shdr.sh_addralign = 8;
+                shdr.sh_entsize = 4;
+                break;
+            case SEC_RELA:
+                shdr.sh_name = 23;
+                shdr.sh_type = SHT_RELA;
+                shdr.sh_flags = SHF_ALLOC;
+                shdr.sh_offset = shdr.sh_addr = off_rela;
+                shdr.sh_size = relocs_num * sizeof(Elf64_Rela);
+                shdr.sh_link = SEC_DYNSYM;
+                shdr.sh_addralign = 8;
+                shdr.sh_entsize = sizeof(Elf64_Rela);
+                break;
+            case SEC_DYNAMIC:
+                shdr.sh_name = 33;
+                shdr.sh_type = SHT_DYNAMIC;
+                shdr.sh_flags = SHF_ALLOC | SHF_WRITE;
+                shdr.sh_offset = shdr.sh_addr = off_dynamic;
+                shdr.sh_size = dynamic_entries * sizeof(Elf64_Dyn);
+                shdr.sh_link = SEC_DYNSTR;
+                shdr.sh_addralign = 8;
+                shdr.sh_entsize = sizeof(Elf64_Dyn);
+                break;
+            case SEC_SYMTAB:
+                shdr.sh_name = 42;
+                shdr.sh_type = SHT_SYMTAB;
+                shdr.sh_offset = off_symtab;
+                shdr.sh_size = (symbols_num + 1) * sizeof(Elf64_Sym);
+                shdr.sh_link = SEC_STRTAB;
+                shdr.sh_info = symbols_num / 10 + 1;
+                shdr.sh_addralign = 8;
+                shdr.sh_entsize = sizeof(Elf64_Sym);
+                break;
+            case SEC_STRTAB:
+                shdr.sh_name = 50;
+                shdr.sh_type = SHT_STRTAB;
+                shdr.sh_offset = off_strtab;
+                shdr.sh_size = strtab_size;
+                shdr.sh_addralign = 1;
+                break;
+            case SEC_SHSTRTAB:
+                shdr.sh_name = 58;
+                shdr.sh_type = SHT_STRTAB;
+                shdr.sh_offset = off_shstrtab;
+                shdr.sh_size = shstrtab_size;
+                shdr.sh_addralign = 1;
+                break;
+            default:
+                // empty code sections
+                shdr.sh_name = name;
+                shdr.sh_type = SHT_PROGBITS;
+                shdr.sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+                shdr.sh_offset = off_shstrtab;
+                shdr.sh_addralign = 16;
+
+                name += symbol_name(buf, sizeof(buf), "sec", i - SEC_NUM) + 1;
+                break;
+        }
+
+        put(&shdr, sizeof(shdr));
+    }
+
+    if(fclose(out) != 0)
+        write_error();
+
+    return EXIT_SUCCESS;
+}
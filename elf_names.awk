@@ -0,0 +1,278 @@
+# generate the name tables of the elf.h constants elfy decodes (elf_names.h)
+#
+# each #define of a number becomes an entry of the table of its prefix: value,
+# name, description (the comment, if any), the line elfy prints for it and
+# their lengths, so a constant is decoded with one lookup and one copy instead
+# of a switch
+
+BEGIN {
+    # table, prefix, names to leave out and whether constants of the machine
+    # specific part of elf.h count
+    table("et", "ET_", "", 0)
+    table("em", "EM_", "", 0)
+    table("elfclass", "ELFCLASS", "", 0)
+    table("elfdata", "ELFDATA", "", 0)
+    table("ev", "EV_", "", 0)
+    table("elfosabi", "ELFOSABI_", "", 0)
+    table("pt", "PT_", "", 0)
+    table("sht", "SHT_", "", 0)
+    table("shf", "SHF_", "", 0)
+    table("dt", "DT_", "^DT_ENCODING$", 0)
+    table("df", "DF_", "^DF_(1|P1)_", 0)
+    table("df_1", "DF_1_", "", 0)
+    table("dtf_1", "DTF_1_", "", 0)
+    table("stt", "STT_", "", 0)
+    table("stb", "STB_", "", 0)
+    table("stv", "STV_", "", 0)
+    table("shn", "SHN_", "", 0)
+    table("elfcompress", "ELFCOMPRESS_", "", 0)
+    table("elf_note_os", "ELF_NOTE_OS_", "", 0)
+    table("nt_gnu", "NT_GNU_", "", 0)
+    table("gnu_property", "GNU_PROPERTY_",
+          "UINT32_(AND|OR)_|_(BASELINE|V[0-9]|IBT|SHSTK|BTI|PAC|ACCESS)$", 0)
+    table("gnu_property_x86_isa_1", "GNU_PROPERTY_X86_ISA_1_",
+          "_(USED|NEEDED)$", 0)
+    table("gnu_property_x86_feature_1", "GNU_PROPERTY_X86_FEATURE_1_", "_AND$",
+          0)
+    table("gnu_property_aarch64_feature_1", "GNU_PROPERTY_AARCH64_FEATURE_1_",
+          "_AND$", 0)
+    table("gnu_property_1_needed", "GNU_PROPERTY_1_NEEDED_", "", 0)
+    table("r_x86_64", "R_X86_64_", "", 1)
+    table("r_386", "R_386_", "", 1)
+    table("r_aarch64", "R_AARCH64_", "", 1)
+    table("r_arm", "R_ARM_", "", 1)
+    table("r_riscv", "R_RISCV_", "", 1)
+
+    # only the small values get a slot in the index
+    INDEX_MAX = 4096
+
+    machine_specific = 0
+}
+
+function table(name, prefix, exclude, specific) {
+    tables++
+    table_name[tables] = name
+    table_prefix[tables] = prefix
+    table_exclude[tables] = exclude
+    table_specific[tables] = specific
+    table_num[tables] = 0
+}
+
+# value of a number of elf.h (decimal, hex or a shifted bit), -1 if it isn't
+function number(str,    value, digit, i, c, shift) {
+    gsub(/[uUlL]+$/, "", str)
+
+    if(str ~ /^\(1[uU]? *<< *[0-9]+\)$/) {
+        gsub(/[^0-9<]/, "", str)
+        shift = substr(str, index(str, "<<") + 2) + 0
+        value = 1
+
+        for(i = 0; i < shift; i++)
+            value *= 2
+
+        return value
+    }
+
+    if(str ~ /^0[xX][0-9a-fA-F]+$/) {
+        value = 0
+
+        for(i = 3; i <= length(str); i++) {
+            c = tolower(substr(str, i, 1))
+            digit = index("0123456789abcdef", c) - 1
+            value = value * 16 + digit
+        }
+
+        return value
+    }
+
+    if(str ~ /^[0-9]+$/)
+        return str + 0
+
+    return -1
+}
+
+function c_string(str) {
+    gsub(/\\/, "\\\\", str)
+    gsub(/"/, "\\\"", str)
+    gsub(/\n/, "\\n", str)
+
+    return "\"" str "\""
+}
+
+# the machine specific definitions follow the generic ones
+/^\/\* .* specific definitions/ {
+    machine_specific = 1
+}
+
+/^#[ \t]*define[ \t]/ {
+    line = $0
+
+    # a comment can go on over the next lines
+    if(index(line, "/*") && !index(substr(line, index(line, "/*")), "*/")) {
+        while((getline next_line) > 0) {
+            line = line " " next_line
+
+            if(index(next_line, "*/"))
+                break
+        }
+    }
+
+    sub(/^#[ \t]*define[ \t]+/, "", line)
+
+    name = line
+    sub(/[ \t].*$/, "", name)
+
+    rest = substr(line, length(name) + 1)
+    desc = ""
+
+    if(index(rest, "/*")) {
+        desc = substr(rest, index(rest, "/*") + 2)
+        rest = substr(rest, 1, index(rest, "/*") - 1)
+
+        sub(/\*\/.*$/, "", desc)
+        gsub(/[ \t]+/, " ", desc)
+        sub(/^ /, "", desc)
+        sub(/ $/, "", desc)
+        sub(/\.$/, "", desc)
+    }
+
+    gsub(/^[ \t]+|[ \t]+$/, "", rest)
+
+    # a constant can be defined as another one
+    if(rest in defined)
+        value = defined[rest]
+    else
+        value = number(rest)
+
+    if(value < 0)
+        next
+
+    defined[name] = value
+
+    # ranges, counts and masks aren't values of their own
+    if(name ~ /(LO|HI)(OS|PROC|SUNW|USER|RESERVE)$/ || name ~ /RNG(LO|HI)$/ ||
+       name ~ /(_|CLASS|DATA|TAG|EXTRA|VAL|ADDR)NUM$/ || name ~ /MASK/ ||
+       desc ~ /^Alias/)
+        next
+
+    for(t = 1; t <= tables; t++) {
+        if(index(name, table_prefix[t]) != 1)
+            continue
+        if(table_exclude[t] != "" && name ~ table_exclude[t])
+            continue
+        if(machine_specific && !table_specific[t])
+            continue
+
+        # the first name of a value wins (a big value would become a string
+        # in %g and collide with its neighbours)
+        key = t SUBSEP sprintf("%.0f", value)
+        if(key in seen)
+            continue
+
+        seen[key] = 1
+
+        n = ++table_num[t]
+        entry_value[t, n] = value
+        entry_name[t, n] = name
+        entry_desc[t, n] = desc
+    }
+}
+
+END {
+    print "// generated from elf.h by elf_names.awk, do not edit"
+    print ""
+    print "#include <stddef.h>"
+    print ""
+    print "// name and description of a constant of elf.h"
+    print "struct elf_name {"
+    print "    unsigned long value;"
+    print "    const char *name;"
+    print "    const char *desc;"
+    print "    // name (description)\\n"
+    print "    const char *text;"
+    print "    unsigned short name_len;"
+    print "    unsigned short desc_len;"
+    print "    unsigned short text_len;"
+    print "};"
+    print ""
+    print "// the constants with a prefix sorted by value, the small values are found"
+    print "// through index (position + 1, 0 when the value has no name)"
+    print "struct elf_names {"
+    print "    const struct elf_name *list;"
+    print "    size_t num;"
+    print "    const unsigned short *index;"
+    print "    size_t index_num;"
+    print "};"
+
+    for(t = 1; t <= tables; t++) {
+        num = table_num[t]
+        name = table_name[t]
+
+        # sort by value
+        for(i = 2; i <= num; i++) {
+            v = entry_value[t, i]
+            nm = entry_name[t, i]
+            ds = entry_desc[t, i]
+
+            for(j = i - 1; j >= 1 && entry_value[t, j] > v; j--) {
+                entry_value[t, j + 1] = entry_value[t, j]
+                entry_name[t, j + 1] = entry_name[t, j]
+                entry_desc[t, j + 1] = entry_desc[t, j]
+            }
+
+            entry_value[t, j + 1] = v
+            entry_name[t, j + 1] = nm
+            entry_desc[t, j + 1] = ds
+        }
+
+        print ""
+        print "// " table_prefix[t] "*"
+        print "static const struct elf_name " name "_name_list[] = {"
+
+        index_num = 0
+        for(i = 1; i <= num; i++) {
+            text = entry_name[t, i]
+            if(entry_desc[t, i] != "")
+                text = text " (" entry_desc[t, i] ")"
+
+            printf("    {%.0f, %s, %s, %s, %d, %d, %d},\n", entry_value[t, i],
+                   c_string(entry_name[t, i]), c_string(entry_desc[t, i]),
+                   c_string(text "\n"), length(entry_name[t, i]),
+                   length(entry_desc[t, i]), length(text) + 1)
+
+            if(entry_value[t, i] < INDEX_MAX)
+                index_num = entry_value[t, i] + 1
+        }
+
+        print "};"
+        print ""
+        print "static const unsigned short " name "_name_index[] = {"
+
+        if(index_num == 0)
+            print "    0"
+
+        i = 1
+        for(v = 0; v < index_num; v++) {
+            while(i <= num && entry_value[t, i] < v)
+                i++
+
+            pos = (i <= num && entry_value[t, i] == v) ? i : 0
+
+            if(v % 16 == 0)
+                printf("    ")
+
+            printf("%d,", pos)
+
+            if(v % 16 == 15 || v + 1 == index_num)
+                printf("\n")
+            else
+                printf(" ")
+        }
+
+        print "};"
+        print ""
+        print "const struct elf_names " name "_names = {"
+        print "    " name "_name_list, " num ", " name "_name_index, " index_num
+        print "};"
+    }
+}
@@ -1,13 +1,29 @@
 #include "elf.h"
+#include "elf_names.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
+#include <fnmatch.h>
+#include <regex.h>
 #include <getopt.h>
+#include <setjmp.h>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <ar.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include <libelf.h>
 #include <gelf.h>
 
@@ -19,7 +35,12 @@
 #define C_YELLOW "\033[33m"
 #define C_END    "\033[0m"
 
-#define print_error(...) fprintf(stderr, "elfy: " __VA_ARGS__);
+// flush stdout first so the error shows up after what was already printed
+// (usually followed by fail)
+#define print_error(...) do { \
+    out_flush(); \
+    fprintf(stderr, "elfy: " __VA_ARGS__); \
+} while(0)
 
 int file_header_opt,
     program_headers_opt,
@@ -27,11 +48,37 @@ int file_header_opt,
     dynamic_section_opt,
     symtab_opt,
     dynamic_symtab_opt,
+    relocs_opt,
+    reloc_summary_opt,
+    relr_opt,
+    hash_stats_opt,
+    compression_opt,
+    size_report_opt,
+    notes_opt,
+    build_id_opt,
+    deps_opt,
+    addr2sym_opt,
+    archive_index_opt,
+    diff_opt,
     no_color_opt,
+    no_mmap_opt,
+    stats_opt,
     help_opt,
     version_opt,
     all_opt;
 
+// values returned by getopt_long for the options that take an argument
+enum {
+    FORMAT_OPT = 0x100,
+    LOOKUP_OPT,
+    HEX_DUMP_OPT,
+    CACHE_OPT,
+    SYM_FILTER_OPT,
+    FIELDS_OPT,
+    TOP_OPT,
+    BY_OPT
+};
+
 const struct option long_opts[] = {
     {"file-header",     no_argument, &file_header_opt,     1},
     {"program-headers", no_argument, &program_headers_opt, 1},
@@ -39,2339 +86,9480 @@ const struct option long_opts[] = {
     {"dynamic",         no_argument, &dynamic_section_opt, 1},
     {"symtab",          no_argument, &symtab_opt,          1},
     {"dyn-syms",        no_argument, &dynamic_symtab_opt,  1},
+    {"sym-type",  required_argument, NULL,          SYM_FILTER_OPT},
+    {"sym-bind",  required_argument, NULL,          SYM_FILTER_OPT},
+    {"sym-visibility", required_argument, NULL,     SYM_FILTER_OPT},
+    {"sym-section", required_argument, NULL,        SYM_FILTER_OPT},
+    {"sym-name",  required_argument, NULL,          SYM_FILTER_OPT},
+    {"sym-regex", required_argument, NULL,          SYM_FILTER_OPT},
+    {"sym-value", required_argument, NULL,          SYM_FILTER_OPT},
+    {"sym-size",  required_argument, NULL,          SYM_FILTER_OPT},
+    {"fields",    required_argument, NULL,          FIELDS_OPT},
+    {"top",       required_argument, NULL,          TOP_OPT},
+    {"by",        required_argument, NULL,          BY_OPT},
+    {"relocs",          no_argument, &relocs_opt,          1},
+    {"reloc-summary",   no_argument, &reloc_summary_opt,   1},
+    {"relr",            no_argument, &relr_opt,            1},
+    {"lookup",    required_argument, NULL,          LOOKUP_OPT},
+    {"hash-stats",      no_argument, &hash_stats_opt,      1},
+    {"compression",     no_argument, &compression_opt,     1},
+    {"size-report",     no_argument, &size_report_opt,     1},
+    {"hex-dump",  required_argument, NULL,          HEX_DUMP_OPT},
+    {"notes",           no_argument, &notes_opt,           1},
+    {"build-id",        no_argument, &build_id_opt,        1},
+    {"deps",            no_argument, &deps_opt,            1},
+    {"addr2sym",        no_argument, &addr2sym_opt,        1},
+    {"archive-index",   no_argument, &archive_index_opt,   1},
+    {"diff",            no_argument, &diff_opt,            1},
     {"all",             no_argument, &all_opt,             1},
     {"no-color",        no_argument, &no_color_opt,        1},
+    {"no-mmap",         no_argument, &no_mmap_opt,         1},
+    {"stats",           no_argument, &stats_opt,           1},
+    {"cache",     required_argument, NULL,          CACHE_OPT},
+    {"format",    required_argument, NULL,          FORMAT_OPT},
+    {"jobs",      required_argument, NULL,          'j'},
+    {"recursive", required_argument, NULL,          'r'},
     {"help",            no_argument, &help_opt,            1},
     {"version",         no_argument, &version_opt,         1},
     {0,                 0,           0,                    0}
 };
 
+// number of files displayed at the same time (option -j)
+size_t jobs_opt = 0;
+
 // length of the longest field name (used by print_field)
-int field_max_len = 0;
+__thread int field_max_len = 0;
 
-// add color to the title when needed
-void print_title(char *title, ...) {
-    va_list args;
-    va_start(args, title);
+// size of the output buffer (flushed with a single write(2) when full)
+#define OUT_BUF_SIZE (1 << 20)
 
-    if(!no_color_opt)
-        printf("%s", C_YELLOW);
+// everything printed to stdout goes through this buffer
+__thread char out_buf[OUT_BUF_SIZE];
+__thread size_t out_len = 0;
 
-    vprintf(title, args);
+// a file to display
+struct job {
+    char *filename;
 
-    if(!no_color_opt)
-        printf("%s", C_END);
+    // a member of an archive is read through the archive, from the header at
+    // member_offset (filename is then "archive(member)")
+    char *archive;
+    size_t member_offset;
+
+    // the members of the archive have jobs of their own
+    int members_split;
+
+    // output produced while it wasn't the job's turn to print
+    char *output;
+    size_t output_len;
+    size_t output_cap;
+
+    int done;
+    int failed;
+
+    // something of the job was printed already (see job_json_comma)
+    int printed;
+};
+
+// files to display, in the order their output is printed
+struct job *jobs = NULL;
+size_t jobs_num = 0;
+size_t jobs_cap = 0;
+
+// next job to be picked by a worker and job allowed to print to stdout
+size_t next_job = 0;
+size_t printing_job = 0;
+
+pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// --format=json with several files: the object of each file is an element of
+// a single array, and whether one of them was printed already
+int json_array = 0;
+int json_printed = 0;
+
+// job displayed by the current thread
+__thread struct job *current_job = NULL;
+
+// where display_file resumes when the current file can't be displayed
+__thread jmp_buf *fail_jmp = NULL;
+
+// give up on the current file (after print_error)
+void fail(void) {
+    if(fail_jmp)
+        longjmp(*fail_jmp, 1);
+
+    exit(EXIT_FAILURE);
+}
+
+// where the time goes (option --stats): each thread adds the time since its
+// last stats_enter to the phase it was in. Reading tables on demand inside
+// libelf counts toward the show_* function that asked for them
+enum {
+    STATS_OTHER,
+    STATS_ELF_BEGIN,
+    STATS_CACHE,
+    STATS_FILE_HEADER,
+    STATS_PROGRAM_HEADERS,
+    STATS_SECTION_HEADERS,
+    STATS_DYNAMIC_SECTION,
+    STATS_SYMTAB,
+    STATS_DYNAMIC_SYMTAB,
+    STATS_RELOCS,
+    STATS_RELOC_SUMMARY,
+    STATS_RELR,
+    STATS_LOOKUP,
+    STATS_HASH_TABLE_STATS,
+    STATS_COMPRESSION,
+    STATS_HEX_DUMP,
+    STATS_TOP,
+    STATS_SIZE_REPORT,
+    STATS_NOTES,
+    STATS_BUILD_ID,
+    STATS_DEPS,
+    STATS_ADDR2SYM,
+    STATS_ARCHIVE_INDEX,
+    STATS_DIFF,
+    STATS_OUTPUT,
+    STATS_PHASES_NUM
+};
+
+const char *stats_phase_names[STATS_PHASES_NUM] = {
+    "other",
+    "elf_begin",
+    "cache",
+    "show_file_header",
+    "show_program_headers",
+    "show_section_headers",
+    "show_dynamic_section",
+    "show_symtab",
+    "show_dynamic_symtab",
+    "show_relocs",
+    "show_reloc_summary",
+    "show_relr",
+    "show_lookup",
+    "show_hash_table_stats",
+    "show_compression",
+    "show_hex_dump",
+    "show_top",
+    "show_size_report",
+    "show_notes",
+    "show_build_id",
+    "show_deps",
+    "show_addr2sym",
+    "show_archive_index",
+    "show_diff",
+    "output"
+};
+
+// wall and cpu time of each phase in ns, summed over the threads
+uint64_t stats_wall[STATS_PHASES_NUM];
+uint64_t stats_cpu[STATS_PHASES_NUM];
+
+// bytes written to stdout and bytes of the files mapped
+uint64_t stats_output_bytes = 0;
+uint64_t stats_mapped_bytes = 0;
+
+// phase of the current thread and when it entered it
+__thread int stats_phase = STATS_OTHER;
+__thread uint64_t stats_wall_start = 0;
+__thread uint64_t stats_cpu_start = 0;
+
+uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// switch the current thread to a phase (returns the one it was in, to go
+// back to it)
+int stats_enter(int phase) {
+    int previous = stats_phase;
+    uint64_t wall, cpu;
+
+    if(!stats_opt)
+        return previous;
+
+    wall = clock_ns(CLOCK_MONOTONIC);
+    cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    // a thread starts out of any phase
+    if(stats_wall_start) {
+        __atomic_fetch_add(&stats_wall[previous], wall - stats_wall_start,
+                           __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats_cpu[previous], cpu - stats_cpu_start,
+                           __ATOMIC_RELAXED);
+    }
+
+    stats_phase = phase;
+    stats_wall_start = wall;
+    stats_cpu_start = cpu;
+
+    return previous;
+}
+
+// write len bytes to stdout
+void write_all(const char *buf, size_t len) {
+    size_t done = 0;
+
+    if(stats_opt)
+        __atomic_fetch_add(&stats_output_bytes, len, __ATOMIC_RELAXED);
+
+    while(done < len) {
+        ssize_t ret = write(STDOUT_FILENO, buf + done, len - done);
+
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+
+            // nobody is reading it anymore, drop the output
+            break;
+        }
+
+        done += ret;
+    }
+}
+
+// separate the first output of a job from the elements of the json array the
+// jobs before it printed (with jobs_lock held). Only the printing order tells
+// whether the job has one before it: the jobs before may print nothing
+void job_json_comma(struct job *job) {
+    if(!json_array || job->printed)
+        return;
+
+    job->printed = 1;
+
+    if(json_printed)
+        write_all(",", 1);
+
+    json_printed = 1;
+}
+
+// keep the output of a job that can't print yet (returns 0 when the job can
+// print it right away)
+int job_keep_output(struct job *job, const char *buf, size_t len) {
+    int kept = 0;
+
+    pthread_mutex_lock(&jobs_lock);
+
+    if(job != &jobs[printing_job]) {
+        if(job->output_len + len > job->output_cap) {
+            size_t cap = job->output_cap ? job->output_cap : OUT_BUF_SIZE;
+
+            while(job->output_len + len > cap)
+                cap *= 2;
+
+            // not print_error, it would flush the output again
+            job->output = realloc(job->output, cap);
+            if(!job->output) {
+                fprintf(stderr, "elfy: realloc() failed: %s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+
+            job->output_cap = cap;
+        }
+
+        memcpy(job->output + job->output_len, buf, len);
+        job->output_len += len;
+        kept = 1;
+    } else if(len)
+        job_json_comma(job);
+
+    pthread_mutex_unlock(&jobs_lock);
+
+    return kept;
+}
+
+// print what a job kept so far
+void job_print_output(struct job *job) {
+    int phase = stats_enter(STATS_OUTPUT);
+
+    if(job->output_len)
+        job_json_comma(job);
+
+    write_all(job->output, job->output_len);
+    stats_enter(phase);
+
+    free(job->output);
+    job->output = NULL;
+    job->output_len = 0;
+    job->output_cap = 0;
+}
+
+// mark a job as done and print the output of the jobs that are next in order
+void job_finish(struct job *job) {
+    pthread_mutex_lock(&jobs_lock);
+
+    job->done = 1;
+
+    while(printing_job < jobs_num && jobs[printing_job].done) {
+        job_print_output(&jobs[printing_job]);
+        printing_job++;
+
+        // the next job may be running already, catch up with its output
+        // before it starts printing on its own
+        if(printing_job < jobs_num)
+            job_print_output(&jobs[printing_job]);
+    }
+
+    pthread_mutex_unlock(&jobs_lock);
+}
+
+// temporary file of the cache entry being written (see cache_begin), -1 when
+// there is none
+__thread int cache_fd = -1;
+__thread char cache_tmp[4096];
+
+// copy output to the cache entry being written
+void cache_write(const char *buf, size_t len) {
+    while(len) {
+        ssize_t ret = write(cache_fd, buf, len);
+
+        if(ret < 0 && errno == EINTR)
+            continue;
+
+        // no room left, the entry is dropped
+        if(ret < 0) {
+            close(cache_fd);
+            cache_fd = -1;
+            unlink(cache_tmp);
+            return;
+        }
+
+        buf += ret;
+        len -= ret;
+    }
+}
+
+// write output to stdout (or keep it until it's the turn of the current job
+// to print)
+void out_emit(const char *buf, size_t len) {
+    int phase = stats_enter(STATS_OUTPUT);
+
+    if(cache_fd >= 0)
+        cache_write(buf, len);
+
+    if(!current_job || !job_keep_output(current_job, buf, len))
+        write_all(buf, len);
+
+    stats_enter(phase);
+}
+
+// write the buffered output
+void out_flush(void) {
+    out_emit(out_buf, out_len);
+    out_len = 0;
+}
+
+// append len bytes that don't fit in what is left of the output buffer
+void out_write_slow(const char *str, size_t len) {
+    out_flush();
+
+    // too big to be buffered, write it right away
+    if(len > OUT_BUF_SIZE) {
+        out_emit(str, len);
+        return;
+    }
+
+    memcpy(out_buf, str, len);
+    out_len = len;
+}
+
+// append len bytes to the output
+static inline void out_write(const char *str, size_t len) {
+    if(out_len + len > OUT_BUF_SIZE) {
+        out_write_slow(str, len);
+        return;
+    }
+
+    memcpy(out_buf + out_len, str, len);
+    out_len += len;
+}
+
+// append a nul-terminated string to the output
+static inline void out_str(const char *str) {
+    out_write(str, strlen(str));
+}
+
+// append a single character to the output
+static inline void out_char(char c) {
+    if(out_len == OUT_BUF_SIZE)
+        out_flush();
+
+    out_buf[out_len++] = c;
+}
+
+// append an unsigned integer in decimal (like %lu)
+void out_udec(unsigned long value) {
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while(value);
+
+    out_write(p, tmp + sizeof(tmp) - p);
+}
+
+// append a signed integer in decimal (like %ld)
+void out_dec(long value) {
+    if(value < 0) {
+        out_char('-');
+        out_udec(-(unsigned long) value);
+    } else
+        out_udec(value);
+}
+
+// append an unsigned integer in hexadecimal (like %#lx)
+void out_hex(unsigned long value) {
+    char tmp[18];
+    char *p = tmp + sizeof(tmp);
+
+    if(value == 0) {
+        out_char('0');
+        return;
+    }
+
+    while(value) {
+        *--p = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    }
+
+    *--p = 'x';
+    *--p = '0';
+
+    out_write(p, tmp + sizeof(tmp) - p);
+}
 
-    putchar('\n');
+// append formatted output (slow path for the uncommon formats)
+void out_vprintf(const char *format, va_list args) {
+    va_list copy;
+    size_t room = OUT_BUF_SIZE - out_len;
+    int len;
 
+    va_copy(copy, args);
+    len = vsnprintf(out_buf + out_len, room, format, copy);
+    va_end(copy);
+
+    if(len < 0)
+        return;
+
+    // it didn't fit, make room and try again
+    if((size_t) len >= room) {
+        out_flush();
+
+        if(len >= OUT_BUF_SIZE) {
+            char *tmp = malloc(len + 1);
+
+            if(!tmp)
+                return;
+
+            vsnprintf(tmp, len + 1, format, args);
+            out_write(tmp, len);
+            free(tmp);
+            return;
+        }
+
+        vsnprintf(out_buf, OUT_BUF_SIZE, format, args);
+    }
+
+    out_len += len;
+}
+
+void out_printf(const char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    out_vprintf(format, args);
     va_end(args);
 }
 
-// print field name and its value
-// add spaces between name and value based on field_max_len
-// don't print value if value is NULL
-void print_field(const char *field, char *value, ...) {
-    int len = strlen(field);
+// output formats (option --format)
+#define FORMAT_TEXT   0
+#define FORMAT_JSON   1
+#define FORMAT_NDJSON 2
 
-    if(!no_color_opt)
-        printf(C_RED "%s" C_END TAB "%*s", field, field_max_len - len, "");
-    else
-        printf("%s" TAB "%*s", field, field_max_len - len, "");
+int output_format = FORMAT_TEXT;
 
-    if(value) {
-        va_list args;
-        va_start(args, value);
+// name of the file being displayed
+__thread char *current_file = NULL;
 
-        if(!no_color_opt)
-            printf("%s", C_GREEN);
+// max nesting of json objects and arrays
+#define JSON_MAX_DEPTH 8
 
-        vprintf(value, args);
+// current nesting and whether something was already written at each level
+// (to know when a comma is needed)
+__thread int json_depth = 0;
+__thread int json_not_empty[JSON_MAX_DEPTH];
 
-        if(!no_color_opt)
-            printf("%s", C_END);
+// closing character of each open object or array
+__thread char json_closers[JSON_MAX_DEPTH];
 
-        putchar('\n');
+// write a comma when the current object or array already has something
+void json_next(void) {
+    if(json_not_empty[json_depth])
+        out_char(',');
 
-        va_end(args);
+    json_not_empty[json_depth] = 1;
+}
+
+// open an object ('{') or an array ('[')
+void json_open(char c) {
+    out_char(c);
+    json_not_empty[++json_depth] = 0;
+    json_closers[json_depth] = c == '{' ? '}' : ']';
+}
+
+// close an object ('}') or an array (']')
+void json_close(char c) {
+    out_char(c);
+    json_depth--;
+}
+
+// close everything still open (when a file couldn't be fully displayed)
+void json_close_all(void) {
+    if(!json_depth)
+        return;
+
+    while(json_depth)
+        json_close(json_closers[json_depth]);
+
+    out_char('\n');
+}
+
+// length of the utf-8 sequence a string starts with, 0 when it isn't valid
+// (overlong forms, surrogates and code points past U+10FFFF included)
+size_t utf8_len(const unsigned char *str) {
+    size_t len;
+    uint32_t code;
+
+    if(str[0] < 0x80)
+        return 1;
+    else if(str[0] >= 0xc2 && str[0] <= 0xdf) {
+        len = 2;
+        code = str[0] & 0x1f;
+    } else if(str[0] >= 0xe0 && str[0] <= 0xef) {
+        len = 3;
+        code = str[0] & 0x0f;
+    } else if(str[0] >= 0xf0 && str[0] <= 0xf4) {
+        len = 4;
+        code = str[0] & 0x07;
+    } else
+        return 0;
+
+    // the string ends with a nul, which stops this before going past it
+    for(size_t i = 1; i < len; i++) {
+        if((str[i] & 0xc0) != 0x80)
+            return 0;
+
+        code = code << 6 | (str[i] & 0x3f);
     }
+
+    if((len == 3 && (code < 0x800 || (code >= 0xd800 && code <= 0xdfff))) ||
+       (len == 4 && (code < 0x10000 || code > 0x10ffff)))
+        return 0;
+
+    return len;
 }
 
-// print field value and its info inside parentheses
-// e.g.: ET_DYN (shared object file)
-void print_field_info(char *value, char *info) {
-    if(!no_color_opt)
-        printf(C_GREEN "%s" C_END " (%s)\n", value, info);
+// write a json string, escaping what needs to be escaped (a byte that isn't
+// part of valid utf-8 becomes U+FFFD, so the output stays valid json)
+void json_str(const char *str) {
+    const char *start = str;
+
+    out_char('"');
+
+    for(; *str; str++) {
+        unsigned char c = *str;
+
+        if(c >= 0x80) {
+            size_t len = utf8_len((const unsigned char *) str);
+
+            if(len) {
+                str += len - 1;
+                continue;
+            }
+        } else if(c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        out_write(start, str - start);
+        start = str + 1;
+
+        if(c >= 0x80)
+            out_str("\\ufffd");
+        else if(c == '"' || c == '\\') {
+            out_char('\\');
+            out_char(c);
+        } else {
+            out_str("\\u00");
+            out_char("0123456789abcdef"[c >> 4]);
+            out_char("0123456789abcdef"[c & 0xf]);
+        }
+    }
+
+    out_write(start, str - start);
+    out_char('"');
+}
+
+// write the key of an object member
+void json_key(const char *key) {
+    json_next();
+    out_char('"');
+    out_str(key);
+    out_str("\":");
+}
+
+// write an object member with an unsigned integer value
+void json_field_uint(const char *key, unsigned long value) {
+    json_key(key);
+    out_udec(value);
+}
+
+// write an object member with a signed integer value
+void json_field_int(const char *key, long value) {
+    json_key(key);
+    out_dec(value);
+}
+
+// write an object member with a string value (null when there's no string)
+void json_field_str(const char *key, const char *value) {
+    json_key(key);
+
+    if(value)
+        json_str(value);
     else
-        printf("%s (%s)\n", value, info);
+        out_str("null");
 }
 
-// display the elf file header (option -h)
-void show_file_header(Elf *elf) {
-    GElf_Ehdr ehdr;
+// objects the current job opened for its files (an archive read from a pipe
+// has one per member)
+__thread size_t json_files = 0;
 
-    print_title("File Header\n");
+// open the top-level object of a file, on a line of its own
+void json_file_open(const char *filename) {
+    if(json_files++ && json_array)
+        out_char(',');
 
-    // strlen("EI_ABIVERSION")
-    field_max_len = 13;
+    json_open('{');
+    json_field_str("file", filename);
+}
 
-    // get the elf file header
-    if(!gelf_getehdr(elf, &ehdr)) {
-        print_error("gelf_getehdr() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
+// close the object opened by json_file_open
+void json_file_close(void) {
+    json_close('}');
+    out_char('\n');
+}
+
+// start a table: an array in the top-level object in json, nothing in ndjson
+void json_table_begin(const char *table) {
+    if(output_format != FORMAT_JSON)
+        return;
+
+    json_key(table);
+    json_open('[');
+}
+
+// end a table started by json_table_begin
+void json_table_end(void) {
+    if(output_format == FORMAT_JSON)
+        json_close(']');
+}
+
+// index of the records that aren't part of a numbered table
+#define NO_INDEX ((size_t) -1)
+
+// start a record: an element of its table in json, a line in ndjson
+void json_record_begin(const char *table, size_t index) {
+    if(output_format == FORMAT_JSON) {
+        json_next();
+        json_open('{');
+    } else {
+        json_open('{');
+        json_field_str("file", current_file);
+        json_field_str("table", table);
     }
 
-    print_title("Elf_Ehdr");
+    if(index != NO_INDEX)
+        json_field_uint("index", index);
+}
 
-    // magic number and other info
-    print_field("e_ident", NULL);
+// end a record started by json_record_begin
+void json_record_end(void) {
+    json_close('}');
+
+    if(output_format == FORMAT_NDJSON)
+        out_char('\n');
+}
+
+// read-only mapping of the whole file (NULL when reading with ELF_C_READ)
+__thread char *file_map = NULL;
+__thread size_t file_size = 0;
+
+// offset of the displayed elf in the file (not 0 for archive members)
+__thread size_t file_base = 0;
+
+// tell the kernel how the bytes [offset, offset + size) of the mapped file
+// are about to be accessed
+void advise_range(size_t offset, size_t size, int advice) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t start;
+
+    offset += file_base;
+
+    if(!file_map || offset >= file_size || size == 0)
+        return;
+
+    if(size > file_size - offset)
+        size = file_size - offset;
+
+    // madvise() wants a page-aligned start address
+    start = offset & ~(page - 1);
+    madvise(file_map + start, size + (offset - start), advice);
+}
+
+// same as advise_range but for the contents of a section
+void advise_section(GElf_Shdr *shdr, int advice) {
+    if(shdr->sh_type == SHT_NOBITS)
+        return;
+
+    advise_range(shdr->sh_offset, shdr->sh_size, advice);
+}
+
+// same as advise_section but for the section with the given index
+void advise_section_index(Elf *elf, size_t index, int advice) {
+    Elf_Scn *section;
+    GElf_Shdr shdr;
+
+    if(!file_map)
+        return;
+
+    section = elf_getscn(elf, index);
+    if(section && gelf_getshdr(section, &shdr))
+        advise_section(&shdr, advice);
+}
+
+// add color to the title when needed
+void print_title(char *title, ...) {
+    va_list args;
+    va_start(args, title);
 
     if(!no_color_opt)
-        printf("%s", C_GREEN);
+        out_str(C_YELLOW);
 
-    for(int i = 0; i < EI_NIDENT; i++) {
-        if(i + 1 != EI_NIDENT)
-            printf("%2.2x ", ehdr.e_ident[i]);
-        else
-            printf("%2.2x\n", ehdr.e_ident[i]);
-    }
+    out_vprintf(title, args);
 
     if(!no_color_opt)
-        printf("%s", C_END);
+        out_str(C_END);
 
-    // object file type
-    print_field("e_type", NULL);
-    switch(ehdr.e_type) {
-        case ET_NONE:
-            print_field_info("ET_NONE", "unknown type");
-            break;
-        case ET_REL:
-            print_field_info("ET_REL", "relocatable file");
-            break;
-        case ET_EXEC:
-            print_field_info("ET_EXEC", "executable file");
-            break;
-        case ET_DYN:
-            print_field_info("ET_DYN", "shared object file");
-            break;
-        case ET_CORE:
-            print_field_info("ET_CORE", "core file");
-            break;
-        default:
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, ehdr.e_type);
-            else
-                printf("%#x", ehdr.e_type);
+    out_char('\n');
 
-            if((ehdr.e_type >= ET_LOOS) && (ehdr.e_type <= ET_HIOS))
-                puts(" (os-specific)");
-            else if(ehdr.e_type >= ET_LOPROC)
-                puts(" (processor-specific)");
-            else
-                puts(" (unknown)");
-    }
+    va_end(args);
+}
 
-    // architecture
-    print_field("e_machine", NULL);
-    switch(ehdr.e_machine) {
-        case EM_NONE:
-            print_field_info("EM_NONE", "no machine");
-            break;
-        case EM_M32:
-            print_field_info("EM_M32", "AT&T WE 32100");
-            break;
-        case EM_SPARC:
-            print_field_info("EM_SPARC", "SUN SPARC");
-            break;
+// same as print_title but for the "Elf_Xxx <index>" titles of the tables
+void print_title_index(const char *title, size_t index) {
+    if(!no_color_opt)
+        out_str(C_YELLOW);
+
+    out_str(title);
+    out_char(' ');
+    out_udec(index);
+
+    if(!no_color_opt)
+        out_str(C_END);
+
+    out_char('\n');
+}
+
+// longest prefix print_field can cache: colors, name, TAB and padding
+#define FIELD_PREFIX_SIZE 64
+
+// field name followed by the padding, with or without color, built once for
+// each field name and field_max_len
+struct field_prefix {
+    const char *field;
+    int max_len;
+    int color;
+    size_t len;
+    char text[FIELD_PREFIX_SIZE];
+};
+
+__thread struct field_prefix field_prefixes[64];
+
+// print field name and the spaces up to the value, for names that aren't
+// string literals
+void print_field_name_uncached(const char *field) {
+    int len = strlen(field);
+
+    if(!no_color_opt)
+        out_printf(C_RED "%s" C_END TAB "%*s", field, field_max_len - len, "");
+    else
+        out_printf("%s" TAB "%*s", field, field_max_len - len, "");
+}
+
+// print field name and the spaces up to the value
+void print_field_name(const char *field) {
+    struct field_prefix *prefix;
+    size_t len;
+
+    // field names are string literals, their address is a good enough key
+    prefix = &field_prefixes[((unsigned long) field >> 3) % 64];
+
+    if(prefix->field == field && prefix->max_len == field_max_len &&
+       prefix->color == !no_color_opt) {
+        out_write(prefix->text, prefix->len);
+        return;
+    }
+
+    len = strlen(field);
+    if(len + field_max_len + sizeof(C_RED C_END TAB) > FIELD_PREFIX_SIZE) {
+        print_field_name_uncached(field);
+        return;
+    }
+
+    if(!no_color_opt)
+        prefix->len = sprintf(prefix->text, C_RED "%s" C_END TAB "%*s", field,
+                              (int) (field_max_len - len), "");
+    else
+        prefix->len = sprintf(prefix->text, "%s" TAB "%*s", field,
+                              (int) (field_max_len - len), "");
+
+    prefix->field = field;
+    prefix->max_len = field_max_len;
+    prefix->color = !no_color_opt;
+
+    out_write(prefix->text, prefix->len);
+}
+
+// print field name and its value
+// add spaces between name and value based on field_max_len
+// don't print value if value is NULL
+void print_field(const char *field, char *value, ...) {
+    print_field_name(field);
+
+    if(value) {
+        va_list args;
+        va_start(args, value);
+
+        if(!no_color_opt)
+            out_str(C_GREEN);
+
+        out_vprintf(value, args);
+
+        if(!no_color_opt)
+            out_str(C_END);
+
+        out_char('\n');
+
+        va_end(args);
+    }
+}
+
+// print a value in hexadecimal (e.g. 0x1000) without the newline
+void print_value_hex(unsigned long value) {
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    out_hex(value);
+
+    if(!no_color_opt)
+        out_str(C_END);
+}
+
+// print a value in decimal without the newline
+void print_value_dec(long value) {
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    out_dec(value);
+
+    if(!no_color_opt)
+        out_str(C_END);
+}
+
+// same as print_field(field, "%#lx", value)
+void print_field_hex(const char *field, unsigned long value) {
+    print_field_name(field);
+    print_value_hex(value);
+    out_char('\n');
+}
+
+// same as print_field(field, "%ld", value)
+void print_field_dec(const char *field, long value) {
+    print_field_name(field);
+    print_value_dec(value);
+    out_char('\n');
+}
+
+// print a name as the value (e.g. DT_VERSYM) and end the line
+void print_value_name(const char *name) {
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    out_str(name);
+
+    if(!no_color_opt)
+        out_str(C_END);
+
+    out_char('\n');
+}
+
+// print a name inside parentheses after a value, or just end the line when
+// there is no name
+void print_name_info(const char *name) {
+    if(!name || *name == '\0') {
+        out_char('\n');
+        return;
+    }
+
+    out_str(" (");
+    out_str(name);
+    out_str(")\n");
+}
+
+// print field value and its info inside parentheses
+// e.g.: ET_DYN (shared object file)
+void print_field_info(char *value, char *info) {
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    out_str(value);
+
+    if(!no_color_opt)
+        out_str(C_END);
+
+    out_str(" (");
+    out_str(info);
+    out_str(")\n");
+}
+
+// find a constant in its name table (NULL when elf.h doesn't name it)
+const struct elf_name *elf_name(const struct elf_names *names,
+                                unsigned long value) {
+    size_t low = 0;
+    size_t high = names->num;
+
+    // small values are one load away
+    if(value < names->index_num) {
+        unsigned short i = names->index[value];
+
+        return i ? &names->list[i - 1] : NULL;
+    }
+
+    while(low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        if(names->list[mid].value < value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if(low < names->num && names->list[low].value == value)
+        return &names->list[low];
+
+    return NULL;
+}
+
+// name of a constant (NULL when elf.h doesn't name it)
+const char *elf_name_str(const struct elf_names *names, unsigned long value) {
+    const struct elf_name *name = elf_name(names, value);
+
+    return name ? name->name : NULL;
+}
+
+// print the name of a constant, returns 0 when it has none
+int out_elf_name(const struct elf_names *names, unsigned long value) {
+    const struct elf_name *name = elf_name(names, value);
+
+    if(!name)
+        return 0;
+
+    out_write(name->name, name->name_len);
+    return 1;
+}
+
+// print a constant as field value with its description, returns 0 when it
+// has no name
+// e.g.: ET_DYN (Shared object file)
+int print_elf_name(const struct elf_names *names, unsigned long value) {
+    const struct elf_name *name = elf_name(names, value);
+
+    if(!name)
+        return 0;
+
+    // the whole line is ready, only the colors go in between
+    if(no_color_opt) {
+        out_write(name->text, name->text_len);
+        return 1;
+    }
+
+    out_str(C_GREEN);
+    out_write(name->name, name->name_len);
+    out_str(C_END);
+    out_write(name->text + name->name_len, name->text_len - name->name_len);
+
+    return 1;
+}
+
+// print the names of the flags set in a value as field value
+// e.g.: SHF_WRITE | SHF_ALLOC
+void print_flag_names(const struct elf_names *names, unsigned long flags) {
+    int first = 1;
+
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    if(flags == 0)
+        out_hex(flags);
+
+    while(flags) {
+        unsigned long flag;
+
+        flag = flags & -flags;
+        flags &= ~flag;
+
+        if(first)
+            first = 0;
+        else
+            out_str(" | ");
+
+        // the flag is unknown
+        if(!out_elf_name(names, flag))
+            out_hex(flag);
+    }
+
+    if(!no_color_opt)
+        out_str(C_END);
+
+    out_char('\n');
+}
+
+// name of a relocation type of the given machine (NULL when unknown)
+const char *reloc_type_name(GElf_Half machine, GElf_Word type) {
+    switch(machine) {
+        case EM_X86_64:
+            return elf_name_str(&r_x86_64_names, type);
         case EM_386:
-            print_field_info("EM_386", "Intel 80386");
-            break;
-        case EM_68K:
-            print_field_info("EM_68K", "Motorola m68k family");
-            break;
-        case EM_88K:
-            print_field_info("EM_88K", "Motorola m88k family");
-            break;
-        case EM_IAMCU:
-            print_field_info("EM_IAMCU", "Intel MCU");
-            break;
-        case EM_860:
-            print_field_info("EM_860", "Intel 80860");
-            break;
-        case EM_MIPS:
-            print_field_info("EM_MIPS", "MIPS R3000 big-endian");
-            break;
-        case EM_S370:
-            print_field_info("EM_S370", "IBM System/370");
-            break;
-        case EM_MIPS_RS3_LE:
-            print_field_info("EM_MIPS_RS3_LE", "MIPS R3000 little-endian");
-            break;
-        case EM_PARISC:
-            print_field_info("EM_PARISC", "HPPA");
-            break;
-        case EM_VPP500:
-            print_field_info("EM_VPP500", "Fujitsu VPP500");
-            break;
-        case EM_SPARC32PLUS:
-            print_field_info("EM_SPARC32PLUS", "Sun's \"v8plus\"");
-            break;
-        case EM_960:
-            print_field_info("EM_960", "Intel 80960");
-            break;
-        case EM_PPC:
-            print_field_info("EM_PPC", "PowerPC");
-            break;
-        case EM_PPC64:
-            print_field_info("EM_PPC64", "PowerPC 64-bit");
-            break;
-        case EM_S390:
-            print_field_info("EM_S390", "IBM S390");
-            break;
-        case EM_SPU:
-            print_field_info("EM_SPU", "IBM SPU/SPC");
-            break;
-        case EM_V800:
-            print_field_info("EM_V800", "NEC V800 series");
-            break;
-        case EM_FR20:
-            print_field_info("EM_FR20", "Fujitsu FR20");
-            break;
-        case EM_RH32:
-            print_field_info("EM_RH32", "TRW RH-32");
-            break;
-        case EM_RCE:
-            print_field_info("EM_RCE", "Motorola RCE");
-            break;
+            return elf_name_str(&r_386_names, type);
+        case EM_AARCH64:
+            return elf_name_str(&r_aarch64_names, type);
         case EM_ARM:
-            print_field_info("EM_ARM", "ARM");
-            break;
-        case EM_FAKE_ALPHA:
-            print_field_info("EM_FAKE_ALPHA", "Digital Alpha");
-            break;
-        case EM_SH:
-            print_field_info("EM_SH", "Hitachi SH");
-            break;
-        case EM_SPARCV9:
-            print_field_info("EM_SPARCV9", "SPARC v9 64-bit");
-            break;
-        case EM_TRICORE:
-            print_field_info("EM_TRICORE", "Siemens Tricore");
-            break;
-        case EM_ARC:
-            print_field_info("EM_ARC", "Argonaut RISC Core");
-            break;
-        case EM_H8_300:
-            print_field_info("EM_H8_300", "Hitachi H8/300");
-            break;
-        case EM_H8_300H:
-            print_field_info("EM_H8_300H", "Hitachi H8/300H");
-            break;
-        case EM_H8S:
-            print_field_info("EM_H8S", "Hitachi H8S");
-            break;
-        case EM_H8_500:
-            print_field_info("EM_H8_500", "Hitachi H8/500");
-            break;
-        case EM_IA_64:
-            print_field_info("EM_IA_64", "Intel Merced");
-            break;
-        case EM_MIPS_X:
-            print_field_info("EM_MIPS_X", "Stanford MIPS-X");
-            break;
-        case EM_COLDFIRE:
-            print_field_info("EM_COLDFIRE", "Motorola Coldfire");
-            break;
-        case EM_68HC12:
-            print_field_info("EM_68HC12", "Motorola M68HC12");
-            break;
-        case EM_MMA:
-            print_field_info("EM_MMA", "Fujitsu MMA Multimedia Accelerator");
-            break;
-        case EM_PCP:
-            print_field_info("EM_PCP", "Siemens PCP");
-            break;
-        case EM_NCPU:
-            print_field_info("EM_NCPU", "Sony nCPU embeeded RISC");
-            break;
-        case EM_NDR1:
-            print_field_info("EM_NDR1", "Denso NDR1 microprocessor");
-            break;
-        case EM_STARCORE:
-            print_field_info("EM_STARCORE", "Motorola Start*Core processor");
-            break;
-        case EM_ME16:
-            print_field_info("EM_ME16", "Toyota ME16 processor");
-            break;
-        case EM_ST100:
-            print_field_info("EM_ST100", "STMicroelectronic ST100 processor");
-            break;
-        case EM_TINYJ:
-            print_field_info("EM_TINYJ", "Advanced Logic Corp. Tinyj emb.fam");
-            break;
-        case EM_X86_64:
-            print_field_info("EM_X86_64", "AMD x86-64 architecture");
-            break;
-        case EM_PDSP:
-            print_field_info("EM_PDSP", "Sony DSP Processor");
-            break;
-        case EM_PDP10:
-            print_field_info("EM_PDP10", "Digital PDP-10");
-            break;
-        case EM_PDP11:
-            print_field_info("EM_PDP11", "Digital PDP-11");
-            break;
-        case EM_FX66:
-            print_field_info("EM_FX66", "Siemens FX66 microcontroller");
-            break;
-        case EM_ST9PLUS:
-            print_field_info("EM_ST9PLUS", "STMicroelectronics ST9+ 8/16 mc");
-            break;
-        case EM_ST7:
-            print_field_info("EM_ST7", "STmicroelectronics ST7 8 bit mc");
-            break;
-        case EM_68HC16:
-            print_field_info("EM_68HC16", "Motorola MC68HC16 microcontroller");
-            break;
-        case EM_68HC11:
-            print_field_info("EM_68HC11", "Motorola MC68HC11 microcontroller");
-            break;
-        case EM_68HC08:
-            print_field_info("EM_68HC08", "Motorola MC68HC08 microcontroller");
-            break;
-        case EM_68HC05:
-            print_field_info("EM_68HC05", "Motorola MC68HC05 microcontroller");
-            break;
-        case EM_SVX:
-            print_field_info("EM_SVX", "Silicon Graphics SVx");
-            break;
-        case EM_ST19:
-            print_field_info("EM_ST19", "STMicroelectronics ST19 8 bit mc");
-            break;
-        case EM_VAX:
-            print_field_info("EM_VAX", "Digital VAX");
-            break;
-        case EM_CRIS:
-            print_field_info("EM_CRIS", "Axis Communications 32-bit emb.proc");
-            break;
-        case EM_JAVELIN:
-            print_field_info("EM_JAVELIN", "Infineon Technologies 32-bit emb.proc");
-            break;
-        case EM_FIREPATH:
-            print_field_info("EM_FIREPATH", "Element 14 64-bit DSP Processor");
-            break;
-        case EM_ZSP:
-            print_field_info("EM_ZSP", "LSI Logic 16-bit DSP Processor");
-            break;
-        case EM_MMIX:
-            print_field_info("EM_MMIX", "Donald Knuth's educational 64-bit proc");
-            break;
-        case EM_HUANY:
-            print_field_info("EM_HUANY", "Harvard University machine-independent object files");
-            break;
-        case EM_PRISM:
-            print_field_info("EM_PRISM", "SiTera Prism");
-            break;
-        case EM_AVR:
-            print_field_info("EM_AVR", "Atmel AVR 8-bit microcontroller");
-            break;
-        case EM_FR30:
-            print_field_info("EM_FR30", "Fujitsu FR30");
-            break;
-        case EM_D10V:
-            print_field_info("EM_D10V", "Mitsubishi D10V");
-            break;
-        case EM_D30V:
-            print_field_info("EM_D30V", "Mitsubishi D30V");
-            break;
-        case EM_V850:
-            print_field_info("EM_V850", "NEC v850");
-            break;
-        case EM_M32R:
-            print_field_info("EM_M32R", "Mitsubishi M32R");
-            break;
-        case EM_MN10300:
-            print_field_info("EM_MN10300", "Matsushita MN10300");
-            break;
-        case EM_MN10200:
-            print_field_info("EM_MN10200", "Matsushita MN10200");
-            break;
-        case EM_PJ:
-            print_field_info("EM_PJ", "picoJava");
-            break;
-        case EM_OPENRISC:
-            print_field_info("EM_OPENRISC", "OpenRISC 32-bit embedded processor");
-            break;
-        case EM_ARC_COMPACT:
-            print_field_info("EM_ARC_COMPACT", "ARC International ARCompact");
-            break;
-        case EM_XTENSA:
-            print_field_info("EM_XTENSA", "Tensilica Xtensa Architecture");
-            break;
-        case EM_VIDEOCORE:
-            print_field_info("EM_VIDEOCORE", "Alphamosaic VideoCore");
-            break;
-        case EM_TMM_GPP:
-            print_field_info("EM_TMM_GPP", "Thompson Multimedia General Purpose Proc");
-            break;
-        case EM_NS32K:
-            print_field_info("EM_NS32K", "National Semi. 32000");
-            break;
-        case EM_TPC:
-            print_field_info("EM_TPC", "Tenor Network TPC");
-            break;
-        case EM_SNP1K:
-            print_field_info("EM_SNP1K", "Trebia SNP 1000");
-            break;
-        case EM_ST200:
-            print_field_info("EM_ST200", "STMicroelectronics ST200");
-            break;
-        case EM_IP2K:
-            print_field_info("EM_IP2K", "Ubicom IP2xxx");
-            break;
-        case EM_MAX:
-            print_field_info("EM_MAX", "MAX processor");
-            break;
-        case EM_CR:
-            print_field_info("EM_CR", "National Semi. CompactRISC");
-            break;
-        case EM_F2MC16:
-            print_field_info("EM_F2MC16", "Fujitsu F2MC16");
-            break;
-        case EM_MSP430:
-            print_field_info("EM_MSP430", "Texas Instruments msp430");
-            break;
-        case EM_BLACKFIN:
-            print_field_info("EM_BLACKFIN", "Analog Devices Blackfin DSP");
-            break;
-        case EM_SE_C33:
-            print_field_info("EM_SE_C33", "Seiko Epson S1C33 family");
-            break;
-        case EM_SEP:
-            print_field_info("EM_SEP", "Sharp embedded microprocessor");
-            break;
-        case EM_ARCA:
-            print_field_info("EM_ARCA", "Arca RISC");
-            break;
-        case EM_UNICORE:
-            print_field_info("EM_UNICORE", "PKU-Unity & MPRC Peking Uni. mc series");
-            break;
-        case EM_EXCESS:
-            print_field_info("EM_EXCESS", "eXcess configurable cpu");
-            break;
-        case EM_DXP:
-            print_field_info("EM_DXP", "Icera Semi. Deep Execution Processor");
-            break;
-        case EM_ALTERA_NIOS2:
-            print_field_info("EM_ALTERA_NIOS2", "Altera Nios II");
-            break;
-        case EM_CRX:
-            print_field_info("EM_CRX", "National Semi. CompactRISC CRX");
-            break;
-        case EM_XGATE:
-            print_field_info("EM_XGATE", "Motorola XGATE");
-            break;
-        case EM_C166:
-            print_field_info("EM_C166", "Infineon C16x/XC16x");
-            break;
-        case EM_M16C:
-            print_field_info("EM_M16C", "Renesas M16C");
-            break;
-        case EM_DSPIC30F:
-            print_field_info("EM_DSPIC30F", "Microchip Technology dsPIC30F");
-            break;
-        case EM_CE:
-            print_field_info("EM_CE", "Freescale Communication Engine RISC");
-            break;
-        case EM_M32C:
-            print_field_info("EM_M32C", "Renesas M32C");
-            break;
-        case EM_TSK3000:
-            print_field_info("EM_TSK3000", "Altium TSK3000");
-            break;
-        case EM_RS08:
-            print_field_info("EM_RS08", "Freescale RS08");
-            break;
-        case EM_SHARC:
-            print_field_info("EM_SHARC", "Analog Devices SHARC family");
-            break;
-        case EM_ECOG2:
-            print_field_info("EM_ECOG2", "Cyan Technology eCOG2");
-            break;
-        case EM_SCORE7:
-            print_field_info("EM_SCORE7", "Sunplus S+core7 RISC");
-            break;
-        case EM_DSP24:
-            print_field_info("EM_DSP24", "New Japan Radio (NJR) 24-bit DSP");
-            break;
-        case EM_VIDEOCORE3:
-            print_field_info("EM_VIDEOCORE3", "Broadcom VideoCore III");
-            break;
-        case EM_LATTICEMICO32:
-            print_field_info("EM_LATTICEMICO32", "RISC for Lattice FPGA");
-            break;
-        case EM_SE_C17:
-            print_field_info("EM_SE_C17", "Seiko Epson C17");
-            break;
-        case EM_TI_C6000:
-            print_field_info("EM_TI_C6000", "Texas Instruments TMS320C6000 DSP");
-            break;
-        case EM_TI_C2000:
-            print_field_info("EM_TI_C2000", "Texas Instruments TMS320C2000 DSP");
-            break;
-        case EM_TI_C5500:
-            print_field_info("EM_TI_C5500", "Texas Instruments TMS320C55x DSP");
-            break;
-        case EM_TI_ARP32:
-            print_field_info("EM_TI_ARP32", "Texas Instruments App. Specific RISC");
-            break;
-        case EM_TI_PRU:
-            print_field_info("EM_TI_PRU", "Texas Instruments Prog. Realtime Unit");
-            break;
-        case EM_MMDSP_PLUS:
-            print_field_info("EM_MMDSP_PLUS", "STMicroelectronics 64bit VLIW DSP");
-            break;
-        case EM_CYPRESS_M8C:
-            print_field_info("EM_CYPRESS_M8C", "Cypress M8C");
-            break;
-        case EM_R32C:
-            print_field_info("EM_R32C", "Renesas R32C");
-            break;
-        case EM_TRIMEDIA:
-            print_field_info("EM_TRIMEDIA", "NXP Semi. TriMedia");
-            break;
-        case EM_QDSP6:
-            print_field_info("EM_QDSP6", "QUALCOMM DSP6");
-            break;
-        case EM_8051:
-            print_field_info("EM_8051", "Intel 8051 and variants");
-            break;
-        case EM_STXP7X:
-            print_field_info("EM_STXP7X", "STMicroelectronics STxP7x");
-            break;
-        case EM_NDS32:
-            print_field_info("EM_NDS32", "Andes Tech. compact code emb. RISC");
-            break;
-        case EM_ECOG1X:
-            print_field_info("EM_ECOG1X", "Cyan Technology eCOG1X");
-            break;
-        case EM_MAXQ30:
-            print_field_info("EM_MAXQ30", "Dallas Semi. MAXQ30 mc");
-            break;
-        case EM_XIMO16:
-            print_field_info("EM_XIMO16", "New Japan Radio (NJR) 16-bit DSP");
-            break;
-        case EM_MANIK:
-            print_field_info("EM_MANIK", "M2000 Reconfigurable RISC");
-            break;
-        case EM_CRAYNV2:
-            print_field_info("EM_CRAYNV2", "Cray NV2 vector architecture");
-            break;
-        case EM_RX:
-            print_field_info("EM_RX", "Renesas RX");
-            break;
-        case EM_METAG:
-            print_field_info("EM_METAG", "Imagination Tech. META");
-            break;
-        case EM_MCST_ELBRUS:
-            print_field_info("EM_MCST_ELBRUS", "MCST Elbrus");
-            break;
-        case EM_ECOG16:
-            print_field_info("EM_ECOG16", "Cyan Technology eCOG16");
-            break;
-        case EM_CR16:
-            print_field_info("EM_CR16", "National Semi. CompactRISC CR16");
-            break;
-        case EM_ETPU:
-            print_field_info("EM_ETPU", "Freescale Extended Time Processing Unit");
-            break;
-        case EM_SLE9X:
-            print_field_info("EM_SLE9X", "Infineon Tech. SLE9X");
-            break;
-        case EM_L10M:
-            print_field_info("EM_L10M", "Intel L10M");
-            break;
-        case EM_K10M:
-            print_field_info("EM_K10M", "Intel K10M");
-            break;
-        case EM_AARCH64:
-            print_field_info("EM_AARCH64", "ARM AARCH64");
-            break;
-        case EM_AVR32:
-            print_field_info("EM_AVR32", "Amtel 32-bit microprocessor");
-            break;
-        case EM_STM8:
-            print_field_info("EM_STM8", "STMicroelectronics STM8");
-            break;
-        case EM_TILE64:
-            print_field_info("EM_TILE64", "Tilera TILE64");
-            break;
-        case EM_TILEPRO:
-            print_field_info("EM_TILEPRO", "Tilera TILEPro");
-            break;
-        case EM_MICROBLAZE:
-            print_field_info("EM_MICROBLAZE", "Xilinx MicroBlaze");
-            break;
-        case EM_CUDA:
-            print_field_info("EM_CUDA", "NVIDIA CUDA");
-            break;
-        case EM_TILEGX:
-            print_field_info("EM_TILEGX", "Tilera TILE-Gx");
-            break;
-        case EM_CLOUDSHIELD:
-            print_field_info("EM_CLOUDSHIELD", "CloudShield");
-            break;
-        case EM_COREA_1ST:
-            print_field_info("EM_COREA_1ST", "KIPO-KAIST Core-A 1st gen");
-            break;
-        case EM_COREA_2ND:
-            print_field_info("EM_COREA_2ND", "KIPO-KAIST Core-A 2nd gen");
-            break;
-        case EM_ARCV2:
-            print_field_info("EM_ARCV2", "Synopsys ARCv2 ISA");
-            break;
-        case EM_OPEN8:
-            print_field_info("EM_OPEN8", "Open8 RISC");
-            break;
-        case EM_RL78:
-            print_field_info("EM_RL78", "Renesas RL78");
-            break;
-        case EM_VIDEOCORE5:
-            print_field_info("EM_VIDEOCORE5", "Broadcom VideoCore V");
-            break;
-        case EM_78KOR:
-            print_field_info("EM_78KOR", "Renesas 78KOR");
-            break;
-        case EM_56800EX:
-            print_field_info("EM_56800EX", "Freescale 56800EX DSC");
-            break;
-        case EM_BA1:
-            print_field_info("EM_BA1", "Beyond BA1");
-            break;
-        case EM_BA2:
-            print_field_info("EM_BA2", "Beyond BA2");
-            break;
-        case EM_XCORE:
-            print_field_info("EM_XCORE", "XMOS xCORE");
-            break;
-        case EM_MCHP_PIC:
-            print_field_info("EM_MCHP_PIC", "Microchip 8-bit PIC(r)");
-            break;
-        case EM_INTELGT:
-            print_field_info("EM_INTELGT", "Intel Graphics Technology");
-            break;
-        case EM_KM32:
-            print_field_info("EM_KM32", "KM211 KM32");
-            break;
-        case EM_KMX32:
-            print_field_info("EM_KMX32", "KM211 KMX32");
-            break;
-        case EM_EMX16:
-            print_field_info("EM_EMX16", "KM211 KMX16");
-            break;
-        case EM_EMX8:
-            print_field_info("EM_EMX8", "KM211 KMX8");
-            break;
-        case EM_KVARC:
-            print_field_info("EM_KVARC", "KM211 KVARC");
-            break;
-        case EM_CDP:
-            print_field_info("EM_CDP", "Paneve CDP");
-            break;
-        case EM_COGE:
-            print_field_info("EM_COGE", "Cognitive Smart Memory Processor");
-            break;
-        case EM_COOL:
-            print_field_info("EM_COOL", "Bluechip CoolEngine");
-            break;
-        case EM_NORC:
-            print_field_info("EM_NORC", "Nanoradio Optimized RISC");
-            break;
-        case EM_CSR_KALIMBA:
-            print_field_info("EM_CSR_KALIMBA", "CSR Kalimba");
-            break;
-        case EM_Z80:
-            print_field_info("EM_Z80", "Zilog Z80");
-            break;
-        case EM_VISIUM:
-            print_field_info("EM_VISIUM", "Controls and Data Services VISIUMcore");
-            break;
-        case EM_FT32:
-            print_field_info("EM_FT32", "FTDI Chip FT32");
-            break;
-        case EM_MOXIE:
-            print_field_info("EM_MOXIE", "Moxie processor");
-            break;
-        case EM_AMDGPU:
-            print_field_info("EM_AMDGPU", "AMD GPU");
-            break;
+            return elf_name_str(&r_arm_names, type);
         case EM_RISCV:
-            print_field_info("EM_RISCV", "RISC-V");
-            break;
-        case EM_BPF:
-            print_field_info("EM_BPF", "Linux BPF -- in-kernel virtual machine");
-            break;
-        case EM_CSKY:
-            print_field_info("EM_CSKY", "C-SKY");
-            break;
-        case EM_ALPHA:
-            print_field_info("EM_ALPHA", "Alpha");
-            break;
+            return elf_name_str(&r_riscv_names, type);
         default:
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, ehdr.e_machine);
-            else
-                printf("%#x", ehdr.e_machine);
+            return NULL;
+    }
+}
+
+// whether a relocation type only adds the load base (e.g. R_X86_64_RELATIVE)
+int is_relative_reloc(GElf_Half machine, GElf_Word type) {
+    const char *name = reloc_type_name(machine, type);
+    size_t len;
+
+    if(!name)
+        return 0;
+
+    // R_*_RELATIVE and R_*_RELATIVE64, but not R_*_IRELATIVE
+    len = strlen(name);
+    return (len > 9 && !strcmp(name + len - 9, "_RELATIVE")) ||
+           (len > 11 && !strcmp(name + len - 11, "_RELATIVE64"));
+}
+
+// section header and name, indexed by section index
+struct section {
+    Elf_Scn *scn;
+    GElf_Shdr shdr;
+    char *name;
+
+    // symbol names by index when it's a symbol table (see load_symbol_names)
+    char **sym_names;
+    size_t sym_names_num;
+};
+
+// section table of the current elf (built once by load_sections)
+__thread struct section *sections = NULL;
+__thread size_t sections_num = 0;
+
+// read every section header and look up its name only once, so the dumpers
+// can resolve a section index with a single array access
+void load_sections(Elf *elf) {
+    size_t shstrndx;
+
+    if(sections)
+        return;
+
+    // get the number of section headers
+    if(elf_getshdrnum(elf, &sections_num) != 0) {
+        print_error("elf_getshdrnum() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    // get the section index of the strtab
+    if(elf_getshdrstrndx(elf, &shstrndx) != 0) {
+        print_error("elf_getshdrstrndx() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    // section names are looked up all over the shstrtab
+    advise_section_index(elf, shstrndx, MADV_WILLNEED);
+
+    sections = calloc(sections_num + 1, sizeof(*sections));
+    if(!sections) {
+        print_error("calloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    for(size_t i = 0; i < sections_num; i++) {
+        struct section *section = &sections[i];
+
+        // get the section
+        section->scn = elf_getscn(elf, i);
+        if(!section->scn) {
+            print_error("elf_getscn() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        // get the section header
+        if(!gelf_getshdr(section->scn, &section->shdr)) {
+            print_error("gelf_getshdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        // NULL when the name is not in the strtab
+        section->name = elf_strptr(elf, shstrndx, section->shdr.sh_name);
+    }
+}
+
+// release the section table of the current elf
+void free_sections(void) {
+    for(size_t i = 0; i < sections_num; i++)
+        free(sections[i].sym_names);
+
+    free(sections);
+    sections = NULL;
+    sections_num = 0;
+}
+
+// a symbol table and its strtab, used in place
+struct sym_table {
+    const void *syms;
+    size_t num;
+    int is_64;
+    char *strtab;
+    // every offset below it is followed by a nul in the strtab
+    size_t strtab_size;
+};
+
+// get the entries of a symbol table as an array of host structures: a file
+// in the host byte order is used as it is, the others go through libelf
+void load_sym_table(Elf *elf, size_t index, struct sym_table *table) {
+    struct section *section = &sections[index];
+    char *ident = elf_getident(elf, NULL);
+    Elf_Data *data = NULL;
+    size_t entsize;
+    int native;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    native = ident && ident[EI_DATA] == ELFDATA2LSB;
+#else
+    native = ident && ident[EI_DATA] == ELFDATA2MSB;
+#endif
+
+    table->is_64 = gelf_getclass(elf) == ELFCLASS64;
+    entsize = table->is_64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+
+    // the raw data needs no conversion, unless it isn't aligned
+    if(native) {
+        data = elf_rawdata(section->scn, NULL);
+        if(data && data->d_buf &&
+           (uintptr_t) data->d_buf % (table->is_64 ? 8 : 4))
+            data = NULL;
+    }
+
+    if(!data) {
+        data = elf_getdata(section->scn, NULL);
+        if(!data) {
+            print_error("elf_getdata() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+    }
+
+    table->syms = data->d_buf;
+    table->num = data->d_buf ? data->d_size / entsize : 0;
+    table->strtab = NULL;
+    table->strtab_size = 0;
+
+    if(section->shdr.sh_link == 0 || section->shdr.sh_link >= sections_num ||
+       sections[section->shdr.sh_link].shdr.sh_type != SHT_STRTAB)
+        return;
+
+    data = elf_getdata(sections[section->shdr.sh_link].scn, NULL);
+    if(!data) {
+        print_error("elf_getdata() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    table->strtab = data->d_buf;
+    table->strtab_size = data->d_buf ? data->d_size : 0;
+
+    // the last string has to end in the section too
+    while(table->strtab_size && table->strtab[table->strtab_size - 1] != '\0')
+        table->strtab_size--;
+}
+
+// get the i-th symbol of an elf64 symbol table
+static inline void get_sym64(const struct sym_table *table, size_t i,
+                             GElf_Sym *sym) {
+    *sym = ((const Elf64_Sym *) table->syms)[i];
+}
+
+// get the i-th symbol of an elf32 symbol table
+static inline void get_sym32(const struct sym_table *table, size_t i,
+                             GElf_Sym *sym) {
+    const Elf32_Sym *sym32 = (const Elf32_Sym *) table->syms + i;
+
+    sym->st_name = sym32->st_name;
+    sym->st_info = sym32->st_info;
+    sym->st_other = sym32->st_other;
+    sym->st_shndx = sym32->st_shndx;
+    sym->st_value = sym32->st_value;
+    sym->st_size = sym32->st_size;
+}
+
+// get the i-th symbol of a symbol table (for single lookups, the loops over
+// a table use SYM_LOOP)
+static inline void get_sym(const struct sym_table *table, size_t i,
+                           GElf_Sym *sym) {
+    if(table->is_64)
+        get_sym64(table, i, sym);
+    else
+        get_sym32(table, i, sym);
+}
+
+// run the statements given for each symbol i (from start) of a table, read
+// into sym: the loop is built once for each class and the class of the table
+// picks one, so it isn't checked for every symbol
+#define SYM_LOOP(table, start, i, sym, ...)                         \
+    do {                                                            \
+        if((table)->is_64) {                                        \
+            for(size_t i = (start); i < (table)->num; i++) {        \
+                GElf_Sym sym;                                       \
+                                                                    \
+                get_sym64((table), i, &sym);                        \
+                __VA_ARGS__                                         \
+            }                                                       \
+        } else {                                                    \
+            for(size_t i = (start); i < (table)->num; i++) {        \
+                GElf_Sym sym;                                       \
+                                                                    \
+                get_sym32((table), i, &sym);                        \
+                __VA_ARGS__                                         \
+            }                                                       \
+        }                                                           \
+    } while(0)
+
+// get the name of a symbol (NULL when it isn't in the strtab)
+static inline char *get_sym_name(const struct sym_table *table,
+                                 GElf_Sym *sym) {
+    if(sym->st_name >= table->strtab_size)
+        return NULL;
+
+    return table->strtab + sym->st_name;
+}
+
+// look up the names of every symbol of a symbol table once, so the tables
+// that refer to symbols by index can resolve them with a single array access
+// (returns NULL when index isn't a symbol table)
+char **load_symbol_names(Elf *elf, size_t index) {
+    struct section *section;
+    struct sym_table table;
+
+    if(index == 0 || index >= sections_num)
+        return NULL;
+
+    section = &sections[index];
+
+    if(section->sym_names)
+        return section->sym_names;
+
+    if(section->shdr.sh_type != SHT_SYMTAB && section->shdr.sh_type != SHT_DYNSYM)
+        return NULL;
+
+    load_sym_table(elf, index, &table);
+
+    section->sym_names_num = table.num;
+
+    section->sym_names = calloc(section->sym_names_num + 1, sizeof(char *));
+    if(!section->sym_names) {
+        print_error("calloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    SYM_LOOP(&table, 0, i, sym,
+        section->sym_names[i] = get_sym_name(&table, &sym);
+    );
+
+    return section->sym_names;
+}
+
+// get the name of the section with the given index (NULL when unknown)
+char *section_name(size_t index) {
+    if(index >= sections_num)
+        return NULL;
+
+    return sections[index].name;
+}
+
+// display the elf file header as json
+void json_file_header(Elf *elf) {
+    GElf_Ehdr ehdr;
+    size_t phnum;
+
+    // get the elf file header
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    // handles phnum too large to fit into e_phnum
+    if(elf_getphdrnum(elf, &phnum) != 0) {
+        print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    // the file header is a single object rather than a table
+    if(output_format == FORMAT_JSON) {
+        json_key("file_header");
+        json_open('{');
+    } else
+        json_record_begin("file_header", NO_INDEX);
+
+    json_field_uint("ei_class", ehdr.e_ident[EI_CLASS]);
+    json_field_str("ei_class_name",
+                   elf_name_str(&elfclass_names, ehdr.e_ident[EI_CLASS]));
+    json_field_uint("ei_data", ehdr.e_ident[EI_DATA]);
+    json_field_str("ei_data_name",
+                   elf_name_str(&elfdata_names, ehdr.e_ident[EI_DATA]));
+    json_field_uint("ei_version", ehdr.e_ident[EI_VERSION]);
+    json_field_uint("ei_osabi", ehdr.e_ident[EI_OSABI]);
+    json_field_str("ei_osabi_name",
+                   elf_name_str(&elfosabi_names, ehdr.e_ident[EI_OSABI]));
+    json_field_uint("ei_abiversion", ehdr.e_ident[EI_ABIVERSION]);
+    json_field_uint("e_type", ehdr.e_type);
+    json_field_str("e_type_name", elf_name_str(&et_names, ehdr.e_type));
+    json_field_uint("e_machine", ehdr.e_machine);
+    json_field_str("e_machine_name", elf_name_str(&em_names, ehdr.e_machine));
+    json_field_uint("e_version", ehdr.e_version);
+    json_field_uint("e_entry", ehdr.e_entry);
+    json_field_uint("e_phoff", ehdr.e_phoff);
+    json_field_uint("e_shoff", ehdr.e_shoff);
+    json_field_uint("e_flags", ehdr.e_flags);
+    json_field_uint("e_ehsize", ehdr.e_ehsize);
+    json_field_uint("e_phentsize", ehdr.e_phentsize);
+    json_field_uint("e_phnum", phnum);
+    json_field_uint("e_shentsize", ehdr.e_shentsize);
+    json_field_uint("e_shnum", ehdr.e_shnum);
+    json_field_uint("e_shstrndx", ehdr.e_shstrndx);
+
+    json_record_end();
+}
+
+// display the program headers as json
+void json_program_headers(Elf *elf) {
+    size_t num;
+
+    // get the number of program headers
+    if(elf_getphdrnum(elf, &num) != 0) {
+        print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    json_table_begin("program_headers");
+
+    for(size_t i = 0; i < num; i++) {
+        GElf_Phdr phdr;
+
+        // get the program header
+        if(!gelf_getphdr(elf, i, &phdr)) {
+            print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        json_record_begin("program_headers", i);
+        json_field_uint("p_type", phdr.p_type);
+        json_field_str("p_type_name", elf_name_str(&pt_names, phdr.p_type));
+        json_field_uint("p_flags", phdr.p_flags);
+        json_field_uint("p_offset", phdr.p_offset);
+        json_field_uint("p_vaddr", phdr.p_vaddr);
+        json_field_uint("p_paddr", phdr.p_paddr);
+        json_field_uint("p_filesz", phdr.p_filesz);
+        json_field_uint("p_memsz", phdr.p_memsz);
+        json_field_uint("p_align", phdr.p_align);
+        json_record_end();
+    }
+
+    json_table_end();
+}
+
+// display the section headers as json
+void json_section_headers(Elf *elf) {
+    load_sections(elf);
+
+    json_table_begin("section_headers");
+
+    for(size_t i = 0; i < sections_num; i++) {
+        GElf_Shdr *shdr = &sections[i].shdr;
+
+        json_record_begin("section_headers", i);
+        json_field_uint("sh_name", shdr->sh_name);
+        json_field_str("name", sections[i].name);
+        json_field_uint("sh_type", shdr->sh_type);
+        json_field_str("sh_type_name", elf_name_str(&sht_names, shdr->sh_type));
+        json_field_uint("sh_flags", shdr->sh_flags);
+        json_field_uint("sh_addr", shdr->sh_addr);
+        json_field_uint("sh_offset", shdr->sh_offset);
+        json_field_uint("sh_size", shdr->sh_size);
+        json_field_uint("sh_link", shdr->sh_link);
+        json_field_uint("sh_info", shdr->sh_info);
+        json_field_uint("sh_addralign", shdr->sh_addralign);
+        json_field_uint("sh_entsize", shdr->sh_entsize);
+        json_record_end();
+    }
+
+    json_table_end();
+}
+
+// display the dynamic section as json
+void json_dynamic_section(Elf *elf) {
+    size_t sh_entsize = gelf_fsize(elf, ELF_T_DYN, 1, EV_CURRENT);
+
+    load_sections(elf);
+
+    json_table_begin("dynamic");
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        Elf_Data *data;
+        size_t num;
+
+        if(shdr->sh_type != SHT_DYNAMIC)
+            continue;
+
+        num = shdr->sh_size / sh_entsize;
+
+        // get data from section
+        data = elf_getdata(sections[j].scn, NULL);
+        if(!data) {
+            print_error("elf_getdata() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        for(size_t i = 0; i < num; i++) {
+            GElf_Dyn dyn;
+
+            // get information from the dynamic table
+            if(!gelf_getdyn(data, i, &dyn)) {
+                print_error("gelf_getdyn() failed: %s\n", elf_errmsg(-1));
+                fail();
+            }
+
+            json_record_begin("dynamic", i);
+            json_field_uint("d_tag", dyn.d_tag);
+            json_field_str("d_tag_name", elf_name_str(&dt_names, dyn.d_tag));
+            json_field_uint("d_val", dyn.d_un.d_val);
+
+            // entries that are offsets into the dynamic strtab
+            switch(dyn.d_tag) {
+                case DT_NEEDED:
+                case DT_SONAME:
+                case DT_RPATH:
+                case DT_RUNPATH:
+                    json_field_str("name", elf_strptr(elf, shdr->sh_link,
+                                                      dyn.d_un.d_val));
+                    break;
+                default:
+                    break;
+            }
+
+            json_record_end();
+
+            // stop when it's the end of the dynamic section
+            if(dyn.d_tag == DT_NULL)
+                break;
+        }
+    }
+
+    json_table_end();
+}
+
+// fields of a symbol table entry to display (option --fields)
+enum {
+    SYM_FIELD_NAME = 1 << 0,
+    SYM_FIELD_TYPE = 1 << 1,
+    SYM_FIELD_BIND = 1 << 2,
+    SYM_FIELD_VISIBILITY = 1 << 3,
+    SYM_FIELD_SECTION = 1 << 4,
+    SYM_FIELD_VALUE = 1 << 5,
+    SYM_FIELD_SIZE = 1 << 6,
+    SYM_FIELDS_ALL = (1 << 7) - 1
+};
+
+int sym_fields = SYM_FIELDS_ALL;
+
+// names of the fields, the st_ names of the text output included
+const struct {
+    const char *name;
+    int fields;
+} sym_field_names[] = {
+    {"name",       SYM_FIELD_NAME},
+    {"type",       SYM_FIELD_TYPE},
+    {"bind",       SYM_FIELD_BIND},
+    {"visibility", SYM_FIELD_VISIBILITY},
+    {"section",    SYM_FIELD_SECTION},
+    {"value",      SYM_FIELD_VALUE},
+    {"size",       SYM_FIELD_SIZE},
+    {"st_name",    SYM_FIELD_NAME},
+    {"st_info",    SYM_FIELD_TYPE | SYM_FIELD_BIND},
+    {"st_other",   SYM_FIELD_VISIBILITY},
+    {"st_shndx",   SYM_FIELD_SECTION},
+    {"st_value",   SYM_FIELD_VALUE},
+    {"st_size",    SYM_FIELD_SIZE}
+};
+
+// which symbols of --symtab and --dyn-syms are displayed (options --sym-*):
+// the ones that match every filter given, and any of the values of a filter
+struct sym_filter {
+    int active;
+
+    // a bit per st_info type and binding and st_other visibility, 0 for any
+    uint32_t types;
+    uint32_t binds;
+    uint32_t visibilities;
+
+    // section names or indices, !NAME to take every other section
+    char **sections;
+    size_t sections_num;
+    int sections_negate;
+
+    // shell patterns and regular expressions of the names
+    char **globs;
+    size_t globs_num;
+    regex_t *regexes;
+    size_t regexes_num;
+
+    int has_value;
+    GElf_Addr value_min;
+    GElf_Addr value_max;
+
+    int has_size;
+    GElf_Xword size_min;
+    GElf_Xword size_max;
+} sym_filter;
+
+// the filter options as given, for the cache keys
+char **sym_filter_opts = NULL;
+size_t sym_filter_opts_num = 0;
+
+// sections of the current elf that --sym-section takes, by index, and the
+// special indices it takes
+__thread unsigned char *sym_sections = NULL;
+__thread int sym_sections_abs = 0;
+__thread int sym_sections_common = 0;
+
+// find the value of a constant of elf.h by name, with or without its prefix
+// (e.g. STT_FUNC or func) or by number
+int parse_elf_name(const struct elf_names *names, const char *prefix,
+                   const char *arg, unsigned long *value) {
+    size_t prefix_len = strlen(prefix);
+    char *end;
+
+    *value = strtoul(arg, &end, 0);
+    if(*arg != '\0' && *end == '\0')
+        return 1;
+
+    if(!strncasecmp(arg, prefix, prefix_len))
+        arg += prefix_len;
+
+    for(size_t i = 0; i < names->num; i++) {
+        if(!strcasecmp(names->list[i].name + prefix_len, arg)) {
+            *value = names->list[i].value;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// add the comma separated constants of arg to a mask of the filter
+void parse_sym_mask(const struct elf_names *names, const char *prefix,
+                    const char *opt, char *arg, uint32_t *mask) {
+    char *save = NULL;
+
+    for(char *item = strtok_r(arg, ",", &save); item;
+        item = strtok_r(NULL, ",", &save)) {
+        unsigned long value;
+
+        if(!parse_elf_name(names, prefix, item, &value) || value >= 32) {
+            print_error("invalid value for --%s: %s\n", opt, item);
+            exit(EXIT_FAILURE);
+        }
+
+        *mask |= 1u << value;
+    }
+}
+
+// read a MIN:MAX range, either side can be left out
+void parse_sym_range(const char *opt, const char *arg, uint64_t *min,
+                     uint64_t *max) {
+    const char *colon = strchr(arg, ':');
+    char *end;
+
+    *min = 0;
+    *max = UINT64_MAX;
+
+    if(!colon) {
+        // a single value
+        *min = *max = strtoull(arg, &end, 0);
+        if(*arg == '\0' || *end != '\0')
+            goto invalid;
+
+        return;
+    }
+
+    if(colon != arg) {
+        *min = strtoull(arg, &end, 0);
+        if(end != colon)
+            goto invalid;
+    }
+
+    if(colon[1] != '\0') {
+        *max = strtoull(colon + 1, &end, 0);
+        if(*end != '\0')
+            goto invalid;
+    }
+
+    if(*min <= *max)
+        return;
+
+invalid:
+    print_error("invalid range for --%s: %s\n", opt, arg);
+    exit(EXIT_FAILURE);
+}
+
+// read the fields of --fields
+void parse_sym_fields(char *arg) {
+    char *save = NULL;
+
+    sym_fields = 0;
+
+    for(char *item = strtok_r(arg, ",", &save); item;
+        item = strtok_r(NULL, ",", &save)) {
+        size_t i;
+
+        for(i = 0; i < sizeof(sym_field_names) / sizeof(*sym_field_names); i++) {
+            if(!strcmp(sym_field_names[i].name, item))
+                break;
+        }
+
+        if(i == sizeof(sym_field_names) / sizeof(*sym_field_names)) {
+            print_error("invalid field: %s\n", item);
+            exit(EXIT_FAILURE);
+        }
+
+        sym_fields |= sym_field_names[i].fields;
+    }
+}
+
+// add an item to a list of the filter
+void sym_filter_add(char ***list, size_t *num, char *item) {
+    *list = realloc(*list, (*num + 1) * sizeof(**list));
+    if(!*list) {
+        print_error("realloc() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    (*list)[(*num)++] = item;
+}
+
+// read a --sym-* option
+void parse_sym_filter(const char *opt, char *arg) {
+    char *copy;
+    char *save = NULL;
+
+    sym_filter.active = 1;
+
+    // kept as given for the cache keys, before strtok_r splits arg
+    copy = malloc(strlen(opt) + strlen(arg) + 2);
+    if(!copy) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    sprintf(copy, "%s=%s", opt, arg);
+    sym_filter_add(&sym_filter_opts, &sym_filter_opts_num, copy);
+
+    if(!strcmp(opt, "sym-type"))
+        parse_sym_mask(&stt_names, "STT_", opt, arg, &sym_filter.types);
+    else if(!strcmp(opt, "sym-bind"))
+        parse_sym_mask(&stb_names, "STB_", opt, arg, &sym_filter.binds);
+    else if(!strcmp(opt, "sym-visibility"))
+        parse_sym_mask(&stv_names, "STV_", opt, arg, &sym_filter.visibilities);
+    else if(!strcmp(opt, "sym-section")) {
+        if(*arg == '!') {
+            sym_filter.sections_negate = 1;
+            arg++;
+        }
+
+        for(char *item = strtok_r(arg, ",", &save); item;
+            item = strtok_r(NULL, ",", &save))
+            sym_filter_add(&sym_filter.sections, &sym_filter.sections_num,
+                           item);
+    } else if(!strcmp(opt, "sym-name"))
+        sym_filter_add(&sym_filter.globs, &sym_filter.globs_num, arg);
+    else if(!strcmp(opt, "sym-regex")) {
+        char error[256];
+        int ret;
+
+        sym_filter.regexes = realloc(sym_filter.regexes,
+                                     (sym_filter.regexes_num + 1) *
+                                     sizeof(*sym_filter.regexes));
+        if(!sym_filter.regexes) {
+            print_error("realloc() failed: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        ret = regcomp(&sym_filter.regexes[sym_filter.regexes_num], arg,
+                      REG_EXTENDED | REG_NOSUB);
+        if(ret != 0) {
+            regerror(ret, &sym_filter.regexes[sym_filter.regexes_num], error,
+                     sizeof(error));
+            print_error("invalid regular expression %s: %s\n", arg, error);
+            exit(EXIT_FAILURE);
+        }
+
+        sym_filter.regexes_num++;
+    } else if(!strcmp(opt, "sym-value")) {
+        sym_filter.has_value = 1;
+        parse_sym_range(opt, arg, &sym_filter.value_min, &sym_filter.value_max);
+    } else if(!strcmp(opt, "sym-size")) {
+        sym_filter.has_size = 1;
+        parse_sym_range(opt, arg, &sym_filter.size_min, &sym_filter.size_max);
+    }
+}
+
+// release what load_sym_sections marked
+void free_sym_sections(void) {
+    free(sym_sections);
+    sym_sections = NULL;
+}
+
+// mark the sections of the current elf --sym-section takes (the names are
+// only compared once per file, not once per symbol)
+void load_sym_sections(void) {
+    // left over when the last file failed
+    free_sym_sections();
+
+    sym_sections_abs = 0;
+    sym_sections_common = 0;
+
+    if(!sym_filter.sections_num)
+        return;
+
+    sym_sections = calloc(sections_num + 1, 1);
+    if(!sym_sections) {
+        print_error("calloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    for(size_t i = 0; i < sym_filter.sections_num; i++) {
+        const char *arg = sym_filter.sections[i];
+        unsigned long index;
+
+        if(parse_elf_name(&shn_names, "SHN_", arg, &index)) {
+            if(index < sections_num)
+                sym_sections[index] = 1;
+            else if(index == SHN_ABS)
+                sym_sections_abs = 1;
+            else if(index == SHN_COMMON)
+                sym_sections_common = 1;
+
+            continue;
+        }
+
+        for(size_t j = 1; j < sections_num; j++) {
+            if(sections[j].name && !strcmp(sections[j].name, arg))
+                sym_sections[j] = 1;
+        }
+    }
+}
+
+// whether a symbol passes the filters: the fields of the entry come first,
+// the name is only looked at when they all match
+static inline int sym_matches(const struct sym_table *syms, GElf_Sym *sym) {
+    const char *name;
+    int matches;
+
+    if(!sym_filter.active)
+        return 1;
+
+    if(sym_filter.types && !(sym_filter.types >> GELF_ST_TYPE(sym->st_info) & 1))
+        return 0;
+
+    if(sym_filter.binds && !(sym_filter.binds >> GELF_ST_BIND(sym->st_info) & 1))
+        return 0;
+
+    if(sym_filter.visibilities &&
+       !(sym_filter.visibilities >> GELF_ST_VISIBILITY(sym->st_other) & 1))
+        return 0;
+
+    if(sym_filter.sections_num) {
+        if(sym->st_shndx < sections_num)
+            matches = sym_sections[sym->st_shndx];
+        else
+            matches = (sym->st_shndx == SHN_ABS && sym_sections_abs) ||
+                      (sym->st_shndx == SHN_COMMON && sym_sections_common);
+
+        if(matches == sym_filter.sections_negate)
+            return 0;
+    }
+
+    if(sym_filter.has_value && (sym->st_value < sym_filter.value_min ||
+                                sym->st_value > sym_filter.value_max))
+        return 0;
+
+    if(sym_filter.has_size && (sym->st_size < sym_filter.size_min ||
+                               sym->st_size > sym_filter.size_max))
+        return 0;
+
+    if(!sym_filter.globs_num && !sym_filter.regexes_num)
+        return 1;
+
+    name = get_sym_name(syms, sym);
+    if(!name)
+        return 0;
+
+    for(size_t i = 0; i < sym_filter.globs_num; i++) {
+        if(fnmatch(sym_filter.globs[i], name, 0) == 0)
+            return 1;
+    }
+
+    for(size_t i = 0; i < sym_filter.regexes_num; i++) {
+        if(regexec(&sym_filter.regexes[i], name, 0, NULL, 0) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+// add the fields of a symbol table entry to the current json record
+// (the ones of --fields)
+void json_symbol(GElf_Sym *sym, const char *name) {
+    if(sym_fields & SYM_FIELD_NAME) {
+        json_field_uint("st_name", sym->st_name);
+        json_field_str("name", name);
+    }
+
+    if(sym_fields & SYM_FIELD_VALUE)
+        json_field_uint("st_value", sym->st_value);
+
+    if(sym_fields & SYM_FIELD_SIZE)
+        json_field_uint("st_size", sym->st_size);
+
+    if(sym_fields & SYM_FIELD_TYPE) {
+        json_field_uint("type", GELF_ST_TYPE(sym->st_info));
+        json_field_str("type_name",
+                       elf_name_str(&stt_names, GELF_ST_TYPE(sym->st_info)));
+    }
+
+    if(sym_fields & SYM_FIELD_BIND) {
+        json_field_uint("bind", GELF_ST_BIND(sym->st_info));
+        json_field_str("bind_name",
+                       elf_name_str(&stb_names, GELF_ST_BIND(sym->st_info)));
+    }
+
+    if(sym_fields & SYM_FIELD_VISIBILITY) {
+        json_field_uint("visibility", GELF_ST_VISIBILITY(sym->st_other));
+        json_field_str("visibility_name",
+                       elf_name_str(&stv_names,
+                                    GELF_ST_VISIBILITY(sym->st_other)));
+    }
+
+    if(sym_fields & SYM_FIELD_SECTION) {
+        json_field_uint("st_shndx", sym->st_shndx);
+
+        if(sym->st_shndx != SHN_UNDEF && sym->st_shndx < SHN_LORESERVE)
+            json_field_str("section", section_name(sym->st_shndx));
+    }
+}
+
+// display the symbols of every section of the given type as json
+void json_symbols(Elf *elf, GElf_Word type, const char *table) {
+    load_sections(elf);
+    load_sym_sections();
+
+    json_table_begin(table);
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        struct sym_table syms;
+
+        if(shdr->sh_type != type)
+            continue;
+
+        // symbols are read in order, their names are all over the strtab
+        advise_section(shdr, MADV_SEQUENTIAL);
+        advise_section(shdr, MADV_WILLNEED);
+        advise_section_index(elf, shdr->sh_link, MADV_WILLNEED);
+
+        load_sym_table(elf, j, &syms);
+
+        SYM_LOOP(&syms, 0, i, sym,
+            if(!sym_matches(&syms, &sym))
+                continue;
+
+            json_record_begin(table, i);
+            json_symbol(&sym, get_sym_name(&syms, &sym));
+            json_record_end();
+        );
+    }
+
+    json_table_end();
+
+    free_sym_sections();
+}
+
+// display the elf file header (option -h)
+void show_file_header(Elf *elf) {
+    GElf_Ehdr ehdr;
+
+    if(output_format != FORMAT_TEXT) {
+        json_file_header(elf);
+        return;
+    }
+
+    print_title("File Header\n");
+
+    // strlen("EI_ABIVERSION")
+    field_max_len = 13;
+
+    // get the elf file header
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s", elf_errmsg(-1));
+        fail();
+    }
+
+    print_title("Elf_Ehdr");
+
+    // magic number and other info
+    print_field("e_ident", NULL);
+
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    for(int i = 0; i < EI_NIDENT; i++) {
+        if(i + 1 != EI_NIDENT)
+            out_printf("%2.2x ", ehdr.e_ident[i]);
+        else
+            out_printf("%2.2x\n", ehdr.e_ident[i]);
+    }
+
+    if(!no_color_opt)
+        out_str(C_END);
+
+    // object file type
+    print_field("e_type", NULL);
+    if(!print_elf_name(&et_names, ehdr.e_type)) {
+        print_value_hex(ehdr.e_type);
+
+        if((ehdr.e_type >= ET_LOOS) && (ehdr.e_type <= ET_HIOS))
+            out_str(" (os-specific)\n");
+        else if(ehdr.e_type >= ET_LOPROC)
+            out_str(" (processor-specific)\n");
+        else
+            out_str(" (unknown)\n");
+    }
+
+    // architecture
+    print_field("e_machine", NULL);
+    if(!print_elf_name(&em_names, ehdr.e_machine)) {
+        print_value_hex(ehdr.e_machine);
+
+        out_str(" (unknown)\n");
+    }
+
+    // object file version
+    print_field("e_version", "%x", ehdr.e_version);
+
+    // entry point virtual address
+    print_field_hex("e_entry", ehdr.e_entry);
+
+    // program header table file offset
+    print_field_hex("e_phoff", ehdr.e_phoff);
+
+    // section header table file offset
+    print_field_hex("e_shoff", ehdr.e_shoff);
+
+    // processor-specific flags
+    print_field_hex("e_flags", ehdr.e_flags);
+
+    // ELF header size in bytes
+    print_field_dec("e_ehsize", ehdr.e_ehsize);
+
+    // program header table entry size
+    print_field_dec("e_phentsize", ehdr.e_phentsize);
+
+    // program header table entry count
+    print_field("e_phnum", NULL);
+
+    if(!no_color_opt)
+        out_str(C_GREEN);
+
+    // handle when phnum is too large to fit into e_phnum
+    if(ehdr.e_phnum == PN_XNUM) {
+        Elf_Scn *section = NULL;
+        GElf_Shdr shdr;
+
+        section = elf_getscn(elf, 0);
+        if(!section) {
+            print_error("elf_getscn() failed: %s", elf_errmsg(-1));
+            fail();
+        }
+
+        if(!gelf_getshdr(section, &shdr)) {
+            print_error("gelf_getshdr() failed: %s", elf_errmsg(-1));
+            fail();
+        }
+
+        out_printf("%d\n", shdr.sh_info);
+    } else
+        out_printf("%d\n", ehdr.e_phnum);
+
+    if(!no_color_opt)
+        out_str(C_END);
+
+    // section header table entry size
+    print_field_dec("e_shentsize", ehdr.e_shentsize);
+
+    // section header table entry count
+    print_field_dec("e_shnum", ehdr.e_shnum);
+
+    // section header string table index
+    print_field_dec("e_shstrndx", ehdr.e_shstrndx);
+
+    out_char('\n');
+
+    // display the e_ident array in details
+    print_title("Elf_Ehdr.e_ident");
+
+    // file identification byte 0..3 index
+    print_field_hex("EI_MAG0", ehdr.e_ident[EI_MAG0]);
+    print_field("EI_MAG1", "%c", ehdr.e_ident[EI_MAG1]);
+    print_field("EI_MAG2", "%c", ehdr.e_ident[EI_MAG2]);
+    print_field("EI_MAG3", "%c", ehdr.e_ident[EI_MAG3]);
+
+    // file class byte index
+    print_field("EI_CLASS", NULL);
+    if(!print_elf_name(&elfclass_names, ehdr.e_ident[EI_CLASS])) {
+        print_value_hex(ehdr.e_ident[EI_CLASS]);
+
+        out_str(" (unknown)\n");
+    }
+
+    // data encoding byte index
+    print_field("EI_DATA", NULL);
+    if(!print_elf_name(&elfdata_names, ehdr.e_ident[EI_DATA])) {
+        print_value_hex(ehdr.e_ident[EI_DATA]);
+
+        out_str(" (unknown)\n");
+    }
+
+    // file version byte index
+    print_field("EI_VERSION", NULL);
+    if(!print_elf_name(&ev_names, ehdr.e_ident[EI_VERSION])) {
+        print_value_hex(ehdr.e_ident[EI_VERSION]);
+
+        out_str(" (unknown)\n");
+    }
+
+    // OS ABI identification
+    print_field("EI_OSABI", NULL);
+    if(!print_elf_name(&elfosabi_names, ehdr.e_ident[EI_OSABI])) {
+        print_value_hex(ehdr.e_ident[EI_OSABI]);
+
+        out_str(" (unknown)\n");
+    }
+
+    // ABI version
+    print_field_hex("EI_ABIVERSION", ehdr.e_ident[EI_ABIVERSION]);
+
+    // byte index of padding bytes
+    print_field_hex("EI_PAD", ehdr.e_ident[EI_PAD]);
+}
+
+// display the program headers (option -p)
+void show_program_headers(Elf *elf) {
+    size_t num;
+
+    if(output_format != FORMAT_TEXT) {
+        json_program_headers(elf);
+        return;
+    }
+
+    print_title("Program Headers\n");
+
+    // strlen("p_filesz")
+    field_max_len = 8;
+
+    // get the number of program headers
+    if(elf_getphdrnum(elf, &num) != 0) {
+        print_error("elf_getphdrnum() failed: %s", elf_errmsg(-1));
+        fail();
+    }
+
+    for(size_t i = 0; i < num; i++) {
+        GElf_Phdr phdr;
+
+        // get the program header
+        if(!gelf_getphdr(elf, i, &phdr)) {
+            print_error("gelf_getphdr() failed: %s", elf_errmsg(-1));
+            fail();
+        }
+
+        print_title_index("Elf_Phdr", i);
+
+        // segment type
+        print_field("p_type", NULL);
+        if(!print_elf_name(&pt_names, phdr.p_type)) {
+            print_value_hex(phdr.p_type);
+
+            if((phdr.p_type >= PT_LOOS) && (phdr.p_type <= PT_HIOS))
+                out_str(" (os-specific)\n");
+            else if(phdr.p_type >= PT_LOPROC)
+                out_str(" (processor-specific)\n");
+            else
+                out_str(" (unknown)\n");
+        }
+
+        // segment flags
+        print_field("p_flags", NULL);
+        switch(phdr.p_flags) {
+            case PF_R:
+                print_field_info("PF_R", "segment is readable");
+                break;
+            case PF_W:
+                print_field_info("PF_W", "segment is writable");
+                break;
+            case PF_X:
+                print_field_info("PF_X", "segment is executable");
+                break;
+            case PF_R | PF_W:
+                print_field_info("PF_R | PF_W", "segment is readable and writable");
+                break;
+            case PF_R | PF_X:
+                print_field_info("PF_R | PF_X", "segment is readable and executable");
+                break;
+            case PF_W | PF_X:
+                print_field_info("PF_W | PF_X", "segment is writable and executable");
+                break;
+            case PF_R | PF_W | PF_X:
+                print_field_info("PF_R | PF_W | PF_X", "segment is readable, writable and executable");
+                break;
+            default:
+                print_value_hex(phdr.p_flags);
+
+                if(phdr.p_flags & PF_MASKOS)
+                    out_str(" (os-specific)\n");
+                else if(phdr.p_flags & PF_MASKPROC)
+                    out_str(" (processor-specific)\n");
+                else
+                    out_str(" (unknown)\n");
+        }
+
+        // segment file offset
+        print_field_hex("p_offset", phdr.p_offset);
+
+        // segment virtual address
+        print_field_hex("p_vaddr", phdr.p_vaddr);
+
+        // segment physical address
+        print_field_hex("p_paddr", phdr.p_paddr);
+
+        // segment size in file
+        print_field_hex("p_filesz", phdr.p_filesz);
+
+        // segment size in memory
+        print_field_hex("p_memsz", phdr.p_memsz);
+
+        // segment alignment
+        print_field_hex("p_align", phdr.p_align);
+
+        if(i + 1 != num)
+            out_char('\n');
+    }
+}
+
+// display the section headers (option -s)
+void show_section_headers(Elf *elf) {
+    if(output_format != FORMAT_TEXT) {
+        json_section_headers(elf);
+        return;
+    }
+
+    print_title("Section Headers\n");
+
+    // strlen("sh_addralign")
+    field_max_len = 12;
+
+    load_sections(elf);
+
+    for(size_t i = 0; i < sections_num; i++) {
+        GElf_Shdr shdr = sections[i].shdr;
+        char *name = sections[i].name;
+
+        if(!name) {
+            print_error("section %zu has no valid name\n", i);
+            fail();
+        }
+
+        print_title_index("Elf_Shdr", i);
+
+        // section name
+        print_field("sh_name", NULL);
+        print_value_dec(shdr.sh_name);
+
+        print_name_info(name);
+
+        // section type
+        print_field("sh_type", NULL);
+        if(!print_elf_name(&sht_names, shdr.sh_type)) {
+            print_value_hex(shdr.sh_type);
+
+            if((shdr.sh_type >= SHT_LOPROC) && (shdr.sh_type <= SHT_HIPROC))
+                out_str(" (processor-specific)\n");
+            else if((shdr.sh_type >= SHT_LOOS) && (shdr.sh_type <= SHT_HIOS))
+                out_str(" (OS-specific)\n");
+            else if((shdr.sh_type >= SHT_LOUSER) && (shdr.sh_type <= SHT_HIUSER))
+                out_str(" (application-specific)\n");
+            else
+                out_str(" (unknown)\n");
+        }
+
+        // section flags
+        print_field("sh_flags", NULL);
+        print_flag_names(&shf_names, shdr.sh_flags);
+
+        // section virtual addr at execution
+        print_field_hex("sh_addr", shdr.sh_addr);
+
+        // section file offset
+        print_field_hex("sh_offset", shdr.sh_offset);
+
+        // section size in bytes
+        print_field_hex("sh_size", shdr.sh_size);
+
+        // link to another section
+        print_field_hex("sh_link", shdr.sh_link);
+
+        // additional section information
+        print_field_hex("sh_info", shdr.sh_info);
+
+        // section alignment
+        print_field_hex("sh_addralign", shdr.sh_addralign);
+
+        // entry size if section holds table
+        print_field_hex("sh_entsize", shdr.sh_entsize);
+
+        if(i + 1 != sections_num)
+            out_char('\n');
+    }
+}
+
+// display the dynamic section (option -d)
+void show_dynamic_section(Elf *elf) {
+    size_t sh_entsize;
+
+    if(output_format != FORMAT_TEXT) {
+        json_dynamic_section(elf);
+        return;
+    }
+
+    print_title("Dynamic Section\n");
+
+    // strlen("d_val")
+    field_max_len = 5;
+
+    sh_entsize = gelf_fsize(elf, ELF_T_DYN, 1, EV_CURRENT);
+
+    load_sections(elf);
+
+    for(size_t j = 1; j < sections_num; j++) {
+        Elf_Scn *section = sections[j].scn;
+        GElf_Shdr shdr = sections[j].shdr;
+        Elf_Data *data = NULL;
+        size_t num = 0;
+
+        // if it's not a dynamic section, skip the section
+        if(shdr.sh_type != SHT_DYNAMIC)
+            continue;
+
+        // the entries are read in order, the names come from its strtab
+        advise_section(&shdr, MADV_SEQUENTIAL);
+        advise_section_index(elf, shdr.sh_link, MADV_WILLNEED);
+
+        num = shdr.sh_size / sh_entsize;
+
+        // get data from section
+        data = elf_getdata(section, data);
+        if(!data) {
+            print_error("elf_getdata() failed: %s", elf_errmsg(-1));
+            fail();
+        }
+
+        for(size_t i = 0; i < num; i++) {
+            GElf_Dyn dyn;
+            char *name = NULL;
+
+            // get information from the dynamic table 
+            if(!gelf_getdyn(data, i, &dyn)) {
+                print_error("gelf_getdyn() failed: %s", elf_errmsg(-1));
+                fail();
+            }
+
+            print_title_index("Elf_Dyn", i);
+
+            // dynamic entry type
+            print_field("d_tag", NULL);
+            if(!print_elf_name(&dt_names, dyn.d_tag)) {
+                print_value_hex(dyn.d_tag);
+
+                if((dyn.d_tag >= DT_LOPROC) && (dyn.d_tag <= DT_HIPROC))
+                    out_str(" (processor-specific)\n");
+                else if((dyn.d_tag >= DT_LOOS) && (dyn.d_tag <= DT_HIOS))
+                    out_str(" (OS-specific)\n");
+                else
+                    out_str(" (unknown)\n");
+            }
+
+            // integer value
+            print_field("d_val", NULL);
+            switch(dyn.d_tag) {
+                // print library name
+                case DT_NEEDED:
+                case DT_SONAME:
+                    print_value_hex(dyn.d_un.d_val);
+
+                    if(dyn.d_tag == DT_NEEDED || dyn.d_tag == DT_SONAME) {
+                        name = elf_strptr(elf, shdr.sh_link, dyn.d_un.d_val);
+                        print_name_info(name);
+                    } else
+                        out_char('\n');
+
+                    break;
+                // print size/count/version/number of ...
+                case DT_PLTRELSZ:
+                case DT_RELASZ:
+                case DT_RELAENT:
+                case DT_STRSZ:
+                case DT_SYMENT:
+                case DT_RELSZ:
+                case DT_RELENT:
+                case DT_INIT_ARRAYSZ:
+                case DT_FINI_ARRAYSZ:
+                case DT_PREINIT_ARRAYSZ:
+                case DT_MOVEENT:
+                case DT_MOVESZ:
+                case DT_RELACOUNT:
+                case DT_RELCOUNT:
+                case DT_RELRSZ:
+                case DT_RELRENT:
+                case DT_GNU_CONFLICTSZ:
+                case DT_GNU_LIBLISTSZ:
+                case DT_SYMINSZ:
+                case DT_SYMINENT:
+                case DT_VERDEFNUM:
+                case DT_VERNEEDNUM:
+                    print_value_dec(dyn.d_un.d_val);
+                    out_char('\n');
+                    break;
+                // parse flags
+                case DT_FLAGS:
+                    print_flag_names(&df_names, dyn.d_un.d_val);
+                    break;
+                // parse feature_1
+                case DT_FEATURE_1:
+                    print_flag_names(&dtf_1_names, dyn.d_un.d_val);
+                    break;
+                // parse flags_1
+                case DT_FLAGS_1:
+                    print_flag_names(&df_1_names, dyn.d_un.d_val);
+                    break;
+                default:
+                    print_value_hex(dyn.d_un.d_val);
+                    out_char('\n');
+            }
+
+            // stop when it's the end of the dynamic section
+            if(dyn.d_tag == DT_NULL)
+                break;
+
+            out_char('\n');
+        }
+
+    }
+}
+
+// display the type and binding of a symbol
+void show_symbol_info(GElf_Sym *sym) {
+    print_field("st_info", NULL);
+    print_value_hex(sym->st_info);
+
+    out_str(" (");
+
+    // parse symbol type
+    if(!out_elf_name(&stt_names, GELF_ST_TYPE(sym->st_info))) {
+        out_hex(GELF_ST_TYPE(sym->st_info));
+
+        if((sym->st_info >= STT_LOPROC) && (sym->st_info <= STT_HIPROC))
+            out_str(" processor-specific");
+        else if((sym->st_info >= STT_LOOS) && (sym->st_info <= STT_HIOS))
+            out_str(" OS-specific");
+        else
+            out_str(" unknown");
+    }
+
+    out_str(", ");
+
+    // parse symbol binding
+    if(!out_elf_name(&stb_names, GELF_ST_BIND(sym->st_info))) {
+        out_hex(GELF_ST_BIND(sym->st_info));
+
+        if((sym->st_info >= STB_LOPROC) && (sym->st_info <= STB_HIPROC))
+            out_str(" processor-specific");
+        else if((sym->st_info >= STB_LOOS) && (sym->st_info <= STB_HIOS))
+            out_str(" OS-specific");
+        else
+            out_str(" unknown");
+    }
+
+    out_str(")\n");
+}
+
+// display the section index of a symbol
+void show_symbol_shndx(GElf_Sym *sym) {
+    print_field("st_shndx", NULL);
+    // parse special section indices
+    if(!print_elf_name(&shn_names, sym->st_shndx)) {
+        print_value_dec(sym->st_shndx);
+
+        if((sym->st_shndx >= SHN_LOPROC) && (sym->st_shndx <= SHN_HIPROC))
+            out_str(" (processor-specific)\n");
+        else if((sym->st_shndx >= SHN_LOOS) && (sym->st_shndx <= SHN_HIOS))
+            out_str(" (OS-specific)\n");
+        else if(sym->st_shndx >= SHN_LORESERVE)
+            out_str(" (reserved indices)\n");
+        else
+            print_name_info(section_name(sym->st_shndx));
+    }
+}
+
+// display the fields of a symbol table entry (the ones of --fields)
+void show_symbol(GElf_Sym *sym, const char *name) {
+    // symbol name
+    if(sym_fields & SYM_FIELD_NAME) {
+        print_field("st_name", NULL);
+
+        print_value_dec(sym->st_name);
+        print_name_info(name);
+    }
+
+    if(sym_fields & (SYM_FIELD_TYPE | SYM_FIELD_BIND))
+        show_symbol_info(sym);
+
+    // symbol visibility
+    if(sym_fields & SYM_FIELD_VISIBILITY) {
+        print_field("st_other", NULL);
+        if(!print_elf_name(&stv_names, GELF_ST_VISIBILITY(sym->st_other))) {
+            print_value_hex(GELF_ST_VISIBILITY(sym->st_other));
+
+            out_str(" (unknown)\n");
+        }
+    }
+
+    if(sym_fields & SYM_FIELD_SECTION)
+        show_symbol_shndx(sym);
+
+    // symbol value
+    if(sym_fields & SYM_FIELD_VALUE)
+        print_field_hex("st_value", sym->st_value);
+
+    // symbol size
+    if(sym_fields & SYM_FIELD_SIZE)
+        print_field_dec("st_size", sym->st_size);
+}
+
+// display every symbol table of a type
+void show_symbols(Elf *elf, GElf_Word type) {
+    int is_first = 1;
+
+    // strlen("st_shndx")
+    field_max_len = 8;
+
+    load_sections(elf);
+    load_sym_sections();
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        struct sym_table syms;
+
+        // if it's not a symbol table of that type, skip the section
+        if(shdr->sh_type != type)
+            continue;
+
+        // symbols are read in order, their names are all over the strtab
+        advise_section(shdr, MADV_SEQUENTIAL);
+        advise_section(shdr, MADV_WILLNEED);
+        advise_section_index(elf, shdr->sh_link, MADV_WILLNEED);
+
+        load_sym_table(elf, j, &syms);
+
+        SYM_LOOP(&syms, 0, i, sym,
+            // rejected symbols aren't formatted at all
+            if(!sym_matches(&syms, &sym))
+                continue;
+
+            if(!is_first)
+                out_char('\n');
+
+            print_title_index("Elf_Sym", i);
+            show_symbol(&sym, get_sym_name(&syms, &sym));
+            is_first = 0;
+        );
+    }
+
+    free_sym_sections();
+}
+
+// display the symbol table (option --symtab)
+void show_symtab(Elf *elf) {
+    if(output_format != FORMAT_TEXT) {
+        json_symbols(elf, SHT_SYMTAB, "symtab");
+        return;
+    }
+
+    print_title("Symbol Table\n");
+    show_symbols(elf, SHT_SYMTAB);
+}
+
+// display the dynamic symbol table (option --dyn-syms)
+void show_dynamic_symtab(Elf *elf) {
+    if(output_format != FORMAT_TEXT) {
+        json_symbols(elf, SHT_DYNSYM, "dyn_syms");
+        return;
+    }
+
+    print_title("Dynamic Symbol Table\n");
+    show_symbols(elf, SHT_DYNSYM);
+}
+
+// number of symbols and sections of --top and what they are ranked by (--by)
+size_t top_opt = 0;
+
+enum {
+    TOP_BY_SIZE
+};
+
+int top_by = TOP_BY_SIZE;
+
+// an entry of a top list: a symbol (section is its symbol table) or a
+// section (index is its index)
+struct top_entry {
+    uint64_t key;
+    size_t section;
+    size_t index;
+};
+
+// the largest entries seen so far in a min-heap of a fixed size: the
+// smallest of them is on top, and is the one replaced by a larger entry
+struct top_heap {
+    struct top_entry *entries;
+    size_t num;
+    size_t cap;
+};
+
+// whether a ranks below b (the first entry wins a tie)
+static inline int top_below(const struct top_entry *a,
+                            const struct top_entry *b) {
+    if(a->key != b->key)
+        return a->key < b->key;
+
+    if(a->section != b->section)
+        return a->section > b->section;
+
+    return a->index > b->index;
+}
+
+void top_sift_down(struct top_entry *entries, size_t num, size_t i) {
+    for(;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        struct top_entry swap;
+
+        if(left < num && top_below(&entries[left], &entries[smallest]))
+            smallest = left;
+
+        if(right < num && top_below(&entries[right], &entries[smallest]))
+            smallest = right;
+
+        if(smallest == i)
+            return;
+
+        swap = entries[i];
+        entries[i] = entries[smallest];
+        entries[smallest] = swap;
+        i = smallest;
+    }
+}
+
+// allocate a heap of up to cap entries (nothing else is allocated after)
+void top_init(struct top_heap *heap, size_t cap) {
+    heap->num = 0;
+    heap->cap = cap;
+    heap->entries = malloc((cap ? cap : 1) * sizeof(*heap->entries));
+    if(!heap->entries) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+}
+
+static inline void top_push(struct top_heap *heap, uint64_t key,
+                            size_t section, size_t index) {
+    struct top_entry entry = {key, section, index};
+
+    if(heap->num < heap->cap) {
+        // sift up
+        size_t i = heap->num++;
+
+        while(i > 0 && top_below(&entry, &heap->entries[(i - 1) / 2])) {
+            heap->entries[i] = heap->entries[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+
+        heap->entries[i] = entry;
+    } else if(heap->cap && top_below(&heap->entries[0], &entry)) {
+        heap->entries[0] = entry;
+        top_sift_down(heap->entries, heap->num, 0);
+    }
+}
+
+// sort the heap from the largest entry to the smallest, in place
+void top_sort(struct top_heap *heap) {
+    for(size_t i = heap->num; i > 1; i--) {
+        struct top_entry swap = heap->entries[0];
+
+        heap->entries[0] = heap->entries[i - 1];
+        heap->entries[i - 1] = swap;
+        top_sift_down(heap->entries, i - 1, 0);
+    }
+}
+
+// display the largest symbols of the symbol table (the dynamic symbol table
+// when there is none), the ones the --sym-* filters take
+void show_top_symbols(Elf *elf) {
+    GElf_Word type = SHT_SYMTAB;
+    struct top_heap heap;
+    size_t total = 0;
+
+    for(size_t j = 1; j < sections_num; j++) {
+        if(sections[j].shdr.sh_type == SHT_SYMTAB)
+            break;
+
+        if(j + 1 == sections_num)
+            type = SHT_DYNSYM;
+    }
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+
+        if(shdr->sh_type == type && shdr->sh_entsize)
+            total += shdr->sh_size / shdr->sh_entsize;
+    }
+
+    top_init(&heap, top_opt < total ? top_opt : total);
+
+    // a single pass that only looks at the entries, the names are resolved
+    // for the winners
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        struct sym_table syms;
+
+        if(shdr->sh_type != type)
+            continue;
+
+        advise_section(shdr, MADV_SEQUENTIAL);
+        advise_section(shdr, MADV_WILLNEED);
+
+        load_sym_table(elf, j, &syms);
+
+        SYM_LOOP(&syms, 0, i, sym,
+            if(!sym_matches(&syms, &sym))
+                continue;
+
+            top_push(&heap, sym.st_size, j, i);
+        );
+    }
+
+    top_sort(&heap);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Largest Symbols (%s)\n",
+                    type == SHT_SYMTAB ? ".symtab" : ".dynsym");
+
+    // strlen("st_shndx")
+    field_max_len = 8;
+
+    json_table_begin("top_symbols");
+
+    for(size_t i = 0; i < heap.num; i++) {
+        struct top_entry *entry = &heap.entries[i];
+        struct sym_table syms;
+        GElf_Sym sym;
+
+        load_sym_table(elf, entry->section, &syms);
+        get_sym(&syms, entry->index, &sym);
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("top_symbols", i);
+            json_field_str("symtab", sections[entry->section].name);
+            json_field_uint("symbol", entry->index);
+            json_symbol(&sym, get_sym_name(&syms, &sym));
+            json_record_end();
+            continue;
+        }
+
+        if(i)
+            out_char('\n');
+
+        print_title_index("Elf_Sym", entry->index);
+        show_symbol(&sym, get_sym_name(&syms, &sym));
+    }
+
+    json_table_end();
+
+    free(heap.entries);
+}
+
+// display the largest sections
+void show_top_sections(void) {
+    struct top_heap heap;
+    uint64_t total = 0;
+
+    top_init(&heap, top_opt < sections_num ? top_opt : sections_num);
+
+    for(size_t j = 1; j < sections_num; j++) {
+        total += sections[j].shdr.sh_size;
+        top_push(&heap, sections[j].shdr.sh_size, 0, j);
+    }
+
+    top_sort(&heap);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Largest Sections\n");
+
+    field_max_len = 8;
+
+    json_table_begin("top_sections");
+
+    for(size_t i = 0; i < heap.num; i++) {
+        size_t j = heap.entries[i].index;
+        GElf_Shdr *shdr = &sections[j].shdr;
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("top_sections", i);
+            json_field_uint("section", j);
+            json_field_str("name", sections[j].name);
+            json_field_uint("type", shdr->sh_type);
+            json_field_str("type_name", elf_name_str(&sht_names, shdr->sh_type));
+            json_field_uint("size", shdr->sh_size);
+            json_record_end();
+            continue;
+        }
+
+        if(i)
+            out_char('\n');
+
+        print_title_index("Elf_Shdr", j);
+
+        print_field("sh_name", NULL);
+        print_value_dec(shdr->sh_name);
+        print_name_info(sections[j].name);
+
+        print_field("sh_type", NULL);
+        if(!print_elf_name(&sht_names, shdr->sh_type)) {
+            print_value_hex(shdr->sh_type);
+            out_char('\n');
+        }
+
+        print_field_dec("sh_size", shdr->sh_size);
+
+        // of the size of every section
+        if(total)
+            print_field("share", "%.2f%%", 100.0 * shdr->sh_size / total);
+    }
+
+    json_table_end();
+
+    free(heap.entries);
+}
+
+// display the largest symbols and sections (option --top)
+void show_top(Elf *elf) {
+    load_sections(elf);
+    load_sym_sections();
+
+    show_top_symbols(elf);
+
+    if(output_format == FORMAT_TEXT)
+        out_char('\n');
+
+    show_top_sections();
+
+    free_sym_sections();
+}
+
+// a range of file offsets or addresses, index is what it belongs to (for a
+// symbol, section is its section and the range is its value and size)
+struct size_range {
+    size_t section;
+    uint64_t start;
+    uint64_t end;
+    size_t index;
+};
+
+// by section and start, then in index order
+int compare_size_ranges(const void *a, const void *b) {
+    const struct size_range *x = a;
+    const struct size_range *y = b;
+
+    if(x->section != y->section)
+        return x->section < y->section ? -1 : 1;
+
+    if(x->start != y->start)
+        return x->start < y->start ? -1 : 1;
+
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+// sort ranges of sections below num_sections in the order of
+// compare_size_ranges, returning the sorted array (ranges is freed): the
+// ranges in index order are spread by section in a single pass, and only
+// the sections whose ranges aren't already by start are sorted (a symbol
+// table can have millions of entries, mostly in address order)
+struct size_range *sort_size_ranges(struct size_range *ranges, size_t num,
+                                    size_t num_sections) {
+    struct size_range *sorted;
+    size_t *first;
+    size_t pos = 0;
+
+    if(num < 4096) {
+        qsort(ranges, num, sizeof(*ranges), compare_size_ranges);
+        return ranges;
+    }
+
+    first = calloc(num_sections + 1, sizeof(*first));
+    sorted = malloc(num * sizeof(*sorted));
+    if(!first || !sorted) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    for(size_t i = 0; i < num; i++)
+        first[ranges[i].section]++;
+
+    for(size_t j = 0; j <= num_sections; j++) {
+        size_t count = first[j];
+
+        first[j] = pos;
+        pos += count;
+    }
+
+    for(size_t i = 0; i < num; i++)
+        sorted[first[ranges[i].section]++] = ranges[i];
+
+    // first[j] is now where the ranges of section j end
+    pos = 0;
+    for(size_t j = 0; j <= num_sections; j++) {
+        for(size_t i = pos + 1; i < first[j]; i++) {
+            if(sorted[i].start < sorted[i - 1].start) {
+                qsort(sorted + pos, first[j] - pos, sizeof(*sorted),
+                      compare_size_ranges);
+                break;
+            }
+        }
+
+        pos = first[j];
+    }
+
+    free(first);
+    free(ranges);
+
+    return sorted;
+}
+
+// bytes of [start, end) covered by sorted ranges, each byte counted once
+uint64_t size_covered(const struct size_range *ranges, size_t num,
+                      uint64_t start, uint64_t end) {
+    uint64_t covered = 0;
+    uint64_t pos = start;
+
+    for(size_t i = 0; i < num && pos < end; i++) {
+        uint64_t from = ranges[i].start > pos ? ranges[i].start : pos;
+        uint64_t to = ranges[i].end < end ? ranges[i].end : end;
+
+        if(to > from) {
+            covered += to - from;
+            pos = to;
+        }
+    }
+
+    return covered;
+}
+
+// first of the sorted ranges of a section that can cover start: the first
+// one starting at start or after, or the one before when it goes past start
+size_t size_first_range(const struct size_range *ranges, size_t num,
+                        size_t section, uint64_t start) {
+    size_t low = 0, high = num;
+
+    while(low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        if(ranges[mid].section < section ||
+           (ranges[mid].section == section && ranges[mid].start < start))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if(low > 0 && ranges[low - 1].section == section &&
+       ranges[low - 1].end > start)
+        low--;
+
+    return low;
+}
+
+// bytes a section takes up in memory (.tbss takes none of its segment)
+static inline uint64_t section_vm_size(GElf_Shdr *shdr) {
+    if(!(shdr->sh_flags & SHF_ALLOC) ||
+       (shdr->sh_type == SHT_NOBITS && shdr->sh_flags & SHF_TLS))
+        return 0;
+
+    return shdr->sh_size;
+}
+
+// ranges of the sections and headers in the file, of the sections in memory
+// and of the symbols in their sections, all sorted
+struct size_map {
+    struct size_range *file;
+    size_t file_num;
+    struct size_range *vm;
+    size_t vm_num;
+    struct size_range *syms;
+    size_t syms_num;
+
+    // the elf header and the header tables, sorted
+    struct size_range headers[3];
+    size_t headers_num;
+
+    // the symbol table of syms (0 when there is none)
+    size_t symtab;
+};
+
+// collect and sort the ranges of the size report
+void load_size_map(Elf *elf, GElf_Ehdr *ehdr, size_t phnum,
+                   struct size_map *map) {
+    GElf_Word type = SHT_SYMTAB;
+    struct sym_table syms;
+
+    memset(map, 0, sizeof(*map));
+
+    map->file = malloc((sections_num + 3) * sizeof(*map->file));
+    map->vm = malloc((sections_num + 1) * sizeof(*map->vm));
+    if(!map->file || !map->vm) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    // the elf header and the header tables aren't in a section
+    map->headers[map->headers_num++] = (struct size_range) {
+        0, 0, ehdr->e_ehsize, 0
+    };
+
+    if(phnum)
+        map->headers[map->headers_num++] = (struct size_range) {
+            0, ehdr->e_phoff, ehdr->e_phoff + phnum * ehdr->e_phentsize, 0
+        };
+
+    if(sections_num)
+        map->headers[map->headers_num++] = (struct size_range) {
+            0, ehdr->e_shoff, ehdr->e_shoff + sections_num * ehdr->e_shentsize,
+            0
+        };
+
+    qsort(map->headers, map->headers_num, sizeof(*map->headers),
+          compare_size_ranges);
+
+    for(size_t i = 0; i < map->headers_num; i++)
+        map->file[map->file_num++] = map->headers[i];
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+
+        if(shdr->sh_type != SHT_NOBITS && shdr->sh_size)
+            map->file[map->file_num++] = (struct size_range) {
+                0, shdr->sh_offset, shdr->sh_offset + shdr->sh_size, j
+            };
+
+        if(section_vm_size(shdr))
+            map->vm[map->vm_num++] = (struct size_range) {
+                0, shdr->sh_addr, shdr->sh_addr + shdr->sh_size, j
+            };
+    }
+
+    qsort(map->file, map->file_num, sizeof(*map->file), compare_size_ranges);
+    qsort(map->vm, map->vm_num, sizeof(*map->vm), compare_size_ranges);
+
+    // the symbol table, or the dynamic one when there is none
+    for(size_t j = 1; j < sections_num; j++) {
+        if(sections[j].shdr.sh_type == SHT_SYMTAB)
+            break;
+
+        if(j + 1 == sections_num)
+            type = SHT_DYNSYM;
+    }
+
+    for(size_t j = 1; j < sections_num && !map->symtab; j++) {
+        if(sections[j].shdr.sh_type == type)
+            map->symtab = j;
+    }
+
+    if(!map->symtab)
+        return;
+
+    advise_section(&sections[map->symtab].shdr, MADV_SEQUENTIAL);
+    advise_section(&sections[map->symtab].shdr, MADV_WILLNEED);
+
+    load_sym_table(elf, map->symtab, &syms);
+
+    map->syms = malloc((syms.num + 1) * sizeof(*map->syms));
+    if(!map->syms) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    // only the symbols with a size in a section of the file take up bytes (a
+    // tls symbol is an offset in the tls segment of a linked file)
+    SYM_LOOP(&syms, 0, i, sym,
+        uint64_t start;
+
+        if(!sym.st_size || sym.st_shndx == SHN_UNDEF ||
+           sym.st_shndx >= SHN_LORESERVE || sym.st_shndx >= sections_num ||
+           GELF_ST_TYPE(sym.st_info) == STT_SECTION ||
+           GELF_ST_TYPE(sym.st_info) == STT_FILE ||
+           (GELF_ST_TYPE(sym.st_info) == STT_TLS && ehdr->e_type != ET_REL) ||
+           !sym_matches(&syms, &sym))
+            continue;
+
+        // the value of a symbol of a relocatable file is an offset in its
+        // section
+        start = sym.st_value;
+        if(ehdr->e_type == ET_REL)
+            start += sections[sym.st_shndx].shdr.sh_addr;
+
+        map->syms[map->syms_num++] = (struct size_range) {
+            sym.st_shndx, start, start + sym.st_size, i
+        };
+    );
+
+    map->syms = sort_size_ranges(map->syms, map->syms_num, sections_num);
+}
+
+void free_size_map(struct size_map *map) {
+    free(map->file);
+    free(map->vm);
+    free(map->syms);
+}
+
+// bytes of a load segment in memory covered by its sections, or by the
+// headers it maps (the first segment usually maps the elf header and the
+// program header table)
+uint64_t segment_vm_covered(struct size_map *map, GElf_Phdr *phdr) {
+    uint64_t covered = size_covered(map->vm, map->vm_num, phdr->p_vaddr,
+                                    phdr->p_vaddr + phdr->p_memsz);
+
+    covered += size_covered(map->headers, map->headers_num, phdr->p_offset,
+                            phdr->p_offset + phdr->p_filesz);
+
+    return covered < phdr->p_memsz ? covered : phdr->p_memsz;
+}
+
+// display a size of the report or add it to the json record
+void print_size(const char *field, uint64_t size) {
+    if(output_format != FORMAT_TEXT)
+        json_field_uint(field, size);
+    else
+        print_field_dec(field, size);
+}
+
+// display the bytes of a section, the ones its symbols take up and with
+// --top the symbols that take up the most
+void show_size_section(Elf *elf, struct size_map *map, size_t j,
+                       const char *segment, size_t *record) {
+    GElf_Shdr *shdr = &sections[j].shdr;
+    uint64_t file_size = shdr->sh_type != SHT_NOBITS ? shdr->sh_size : 0;
+    uint64_t start = shdr->sh_addr;
+    uint64_t end = shdr->sh_addr + shdr->sh_size;
+    uint64_t pos = start;
+    uint64_t symbols_size = 0;
+    size_t symbols_num = 0;
+    struct top_heap heap;
+
+    top_init(&heap, top_opt);
+
+    // sweep the sorted symbols of the section, a byte goes to the first
+    // symbol that covers it
+    for(size_t i = size_first_range(map->syms, map->syms_num, j, start);
+        i < map->syms_num && map->syms[i].section == j &&
+        map->syms[i].start < end; i++) {
+        uint64_t from = map->syms[i].start > pos ? map->syms[i].start : pos;
+        uint64_t to = map->syms[i].end < end ? map->syms[i].end : end;
+
+        if(to <= from)
+            continue;
+
+        symbols_size += to - from;
+        symbols_num++;
+        pos = to;
+
+        top_push(&heap, to - from, 0, map->syms[i].index);
+    }
+
+    top_sort(&heap);
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("size_report", (*record)++);
+        json_field_str("kind", "section");
+        json_field_uint("section", j);
+        json_field_str("name", sections[j].name);
+        json_field_str("segment", segment);
+    } else {
+        out_char('\n');
+        print_title_index("Elf_Shdr", j);
+
+        print_field("sh_name", NULL);
+        print_value_dec(shdr->sh_name);
+        print_name_info(sections[j].name);
+
+        print_field("segment", "%s", segment);
+    }
+
+    print_size("file_size", file_size);
+    print_size("vm_size", section_vm_size(shdr));
+
+    if(symbols_num) {
+        print_size("symbols", symbols_num);
+        print_size("symbol_bytes", symbols_size);
+        print_size("gap_bytes", shdr->sh_size - symbols_size);
+    }
+
+    if(output_format != FORMAT_TEXT)
+        json_record_end();
+
+    if(heap.num) {
+        struct sym_table syms;
+
+        load_sym_table(elf, map->symtab, &syms);
+
+        for(size_t i = 0; i < heap.num; i++) {
+            struct top_entry *entry = &heap.entries[i];
+            GElf_Sym sym;
+
+            get_sym(&syms, entry->index, &sym);
+
+            if(output_format != FORMAT_TEXT) {
+                json_record_begin("size_report", (*record)++);
+                json_field_str("kind", "symbol");
+                json_field_uint("symbol", entry->index);
+                json_field_str("name", get_sym_name(&syms, &sym));
+                json_field_uint("section", j);
+                json_field_uint("bytes", entry->key);
+                json_record_end();
+                continue;
+            }
+
+            out_char('\n');
+            print_title_index("Elf_Sym", entry->index);
+
+            print_field("st_name", NULL);
+            print_value_dec(sym.st_name);
+            print_name_info(get_sym_name(&syms, &sym));
+
+            // the bytes of the section it was given, less than its size when
+            // it overlaps another symbol
+            print_field_dec("bytes", entry->key);
+        }
+    }
+
+    free(heap.entries);
+}
+
+// attribute every byte of the file and of the memory image to the load
+// segments, their sections and the symbols in them (option --size-report)
+void show_size_report(Elf *elf) {
+    GElf_Ehdr ehdr;
+    struct size_map map;
+    size_t phnum;
+    size_t size;
+    uint64_t vm_size = 0, vm_covered = 0;
+    size_t record = 0;
+    unsigned char *done;
+
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    if(elf_getphdrnum(elf, &phnum) != 0) {
+        print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    if(!elf_rawfile(elf, &size)) {
+        print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    load_sections(elf);
+    load_sym_sections();
+    load_size_map(elf, &ehdr, phnum, &map);
+
+    for(size_t i = 0; i < phnum; i++) {
+        GElf_Phdr phdr;
+
+        if(!gelf_getphdr(elf, i, &phdr)) {
+            print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        if(phdr.p_type != PT_LOAD)
+            continue;
+
+        vm_size += phdr.p_memsz;
+        vm_covered += segment_vm_covered(&map, &phdr);
+    }
+
+    if(output_format == FORMAT_TEXT) {
+        print_title("Size Report\n");
+        print_title("Total");
+    } else {
+        json_table_begin("size_report");
+        json_record_begin("size_report", record++);
+        json_field_str("kind", "total");
+    }
+
+    // strlen("vm_gap_bytes")
+    field_max_len = 12;
+
+    // the gaps are the bytes in no section (or header) and in no segment
+    print_size("file_size", size);
+    print_size("gap_bytes", size -
+               size_covered(map.file, map.file_num, 0, size));
+    print_size("vm_size", vm_size);
+    print_size("vm_gap_bytes", vm_size - vm_covered);
+
+    if(output_format != FORMAT_TEXT)
+        json_record_end();
+
+    // a section is shown once, under the first load segment it's in
+    done = calloc(sections_num + 1, 1);
+    if(!done) {
+        print_error("calloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    for(size_t i = 0; i < phnum; i++) {
+        GElf_Phdr phdr;
+        uint64_t end;
+        char segment[32];
+
+        if(!gelf_getphdr(elf, i, &phdr)) {
+            print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        if(phdr.p_type != PT_LOAD)
+            continue;
+
+        end = phdr.p_vaddr + phdr.p_memsz;
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("size_report", record++);
+            json_field_str("kind", "segment");
+            json_field_uint("segment", i);
+            json_field_uint("flags", phdr.p_flags);
+        } else {
+            out_char('\n');
+            print_title_index("Elf_Phdr", i);
+            print_field("p_flags", "%c%c%c", phdr.p_flags & PF_R ? 'R' : '-',
+                        phdr.p_flags & PF_W ? 'W' : '-',
+                        phdr.p_flags & PF_X ? 'X' : '-');
+        }
+
+        print_size("file_size", phdr.p_filesz);
+        print_size("gap_bytes", phdr.p_filesz -
+                   size_covered(map.file, map.file_num, phdr.p_offset,
+                                phdr.p_offset + phdr.p_filesz));
+        print_size("vm_size", phdr.p_memsz);
+        print_size("vm_gap_bytes", phdr.p_memsz -
+                   segment_vm_covered(&map, &phdr));
+
+        if(output_format != FORMAT_TEXT)
+            json_record_end();
+
+        snprintf(segment, sizeof(segment), "%zu", i);
+
+        // its sections in address order
+        for(size_t k = size_first_range(map.vm, map.vm_num, 0, phdr.p_vaddr);
+            k < map.vm_num && map.vm[k].start < end; k++) {
+            size_t j = map.vm[k].index;
+
+            if(done[j] || map.vm[k].end <= phdr.p_vaddr)
+                continue;
+
+            done[j] = 1;
+            show_size_section(elf, &map, j, segment, &record);
+        }
+    }
+
+    // the sections that aren't loaded
+    for(size_t j = 1; j < sections_num; j++) {
+        if(!done[j])
+            show_size_section(elf, &map, j, "none", &record);
+    }
+
+    json_table_end();
+
+    free(done);
+    free_size_map(&map);
+    free_sym_sections();
+}
+
+// read the i-th word (8 bytes on 64-bit, 4 otherwise) in the host byte order
+GElf_Xword read_word(const unsigned char *buf, size_t i, int is_64, int swap) {
+    if(is_64) {
+        uint64_t word;
+
+        memcpy(&word, buf + i * 8, 8);
+        return swap ? __builtin_bswap64(word) : word;
+    } else {
+        uint32_t word;
+
+        memcpy(&word, buf + i * 4, 4);
+        return swap ? __builtin_bswap32(word) : word;
+    }
+}
+
+// whether the elf byte order differs from the host one
+int elf_needs_swap(GElf_Ehdr *ehdr) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return ehdr->e_ident[EI_DATA] == ELFDATA2MSB;
+#else
+    return ehdr->e_ident[EI_DATA] == ELFDATA2LSB;
+#endif
+}
+
+// count the relocations a relr table expands to: an even word is an address
+// (one relocation), an odd word is a bitmap of the next 63 (or 31) words
+size_t relr_count(const unsigned char *buf, size_t num, int is_64, int swap) {
+    size_t count = 0;
+
+    if(is_64 && !swap) {
+        // the common case, one load and one popcount per word
+        for(size_t i = 0; i < num; i++) {
+            uint64_t word;
+
+            memcpy(&word, buf + i * 8, 8);
+            count += word & 1 ? __builtin_popcountll(word) - 1 : 1;
+        }
+
+        return count;
+    }
+
+    for(size_t i = 0; i < num; i++) {
+        GElf_Xword word = read_word(buf, i, is_64, swap);
+
+        count += word & 1 ? __builtin_popcountll(word) - 1 : 1;
+    }
+
+    return count;
+}
+
+// get the raw contents of a relr section
+Elf_Data *relr_data(Elf_Scn *section) {
+    // libelf may not know how to translate SHT_RELR, read the raw bytes and
+    // swap them ourselves
+    Elf_Data *data = elf_rawdata(section, NULL);
+
+    if(!data) {
+        print_error("elf_rawdata() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    return data;
+}
+
+// display the relr packed relative relocations and how well they are packed
+// (option --relr)
+void show_relr(Elf *elf) {
+    GElf_Ehdr ehdr;
+    int is_64;
+    int swap;
+    size_t word_size;
+    int is_first = 1;
+
+    if(output_format == FORMAT_TEXT)
+        print_title("RELR Relocations\n");
+
+    // strlen("r_address")
+    field_max_len = 9;
+
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    is_64 = ehdr.e_ident[EI_CLASS] == ELFCLASS64;
+    swap = elf_needs_swap(&ehdr);
+    word_size = is_64 ? 8 : 4;
+
+    load_sections(elf);
+
+    json_table_begin("relr");
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        const unsigned char *buf;
+        Elf_Data *data;
+        size_t num;
+        size_t count = 0;
+        size_t rela_size;
+        GElf_Addr base = 0;
+
+        if(shdr->sh_type != SHT_RELR)
+            continue;
+
+        // words are read in order
+        advise_section(shdr, MADV_SEQUENTIAL);
+
+        data = relr_data(sections[j].scn);
+        buf = data->d_buf;
+        num = data->d_size / word_size;
+
+        if(output_format == FORMAT_TEXT) {
+            if(!is_first)
+                out_char('\n');
+
+            // the title ends with a blank line of its own
+            print_title("Section %zu (%s)\n", j,
+                        sections[j].name ? sections[j].name : "");
+            is_first = 1;
+        }
+
+        for(size_t i = 0; i < num; i++) {
+            GElf_Xword word = read_word(buf, i, is_64, swap);
+            GElf_Addr first = 0;
+            size_t relocs;
+
+            if(!(word & 1)) {
+                // relocation at the address, the next bitmap starts after it
+                relocs = 1;
+                first = word;
+                base = word + word_size;
+            } else {
+                // bit n (from 1) is a relocation at base + (n - 1) * word_size
+                GElf_Xword bits = word >> 1;
+
+                relocs = __builtin_popcountll(bits);
+                if(bits)
+                    first = base + __builtin_ctzll(bits) * word_size;
+
+                base += (word_size * 8 - 1) * word_size;
+            }
+
+            count += relocs;
+
+            if(output_format != FORMAT_TEXT) {
+                json_record_begin("relr", i);
+                json_field_str("section", sections[j].name);
+                json_field_uint("word", word);
+                json_field_str("kind", word & 1 ? "bitmap" : "address");
+                json_field_uint("relocs", relocs);
+                json_field_uint("address", first);
+                json_record_end();
+                continue;
+            }
+
+            if(!is_first)
+                out_char('\n');
+
+            print_title_index("Elf_Relr", i);
+            is_first = 0;
+
+            // raw entry
+            print_field_hex("r_word", word);
+
+            // address or bitmap
+            print_field("r_kind", word & 1 ? "bitmap" : "address");
+
+            // number of relocations the entry expands to
+            print_field_dec("r_relocs", relocs);
+
+            // address of the first of them
+            print_field_hex("r_address", first);
+        }
+
+        // size the same relocations would take as rela entries
+        rela_size = count * (is_64 ? sizeof(Elf64_Rela) : sizeof(Elf32_Rela));
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("relr", NO_INDEX);
+            json_field_str("section", sections[j].name);
+            json_field_uint("words", num);
+            json_field_uint("relocs", count);
+            json_field_uint("relr_size", data->d_size);
+            json_field_uint("rela_size", rela_size);
+            json_record_end();
+            continue;
+        }
+
+        if(!is_first)
+            out_char('\n');
+
+        print_title("Summary");
+        is_first = 0;
+        print_field_dec("words", num);
+        print_field_dec("relocs", count);
+        print_field("size", "%zu (%zu as rela entries)", data->d_size,
+                    rela_size);
+
+        if(data->d_size)
+            print_field("ratio", "%.2f", (double) rela_size / data->d_size);
+    }
+
+    json_table_end();
+}
+
+// display the relocation entries (option --relocs)
+void show_relocs(Elf *elf) {
+    GElf_Ehdr ehdr;
+    int is_first = 1;
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Relocations\n");
+
+    // strlen("r_addend")
+    field_max_len = 8;
+
+    // the machine tells how to decode r_type
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    load_sections(elf);
+
+    json_table_begin("relocs");
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        int is_rela = shdr->sh_type == SHT_RELA;
+        char **sym_names;
+        Elf_Data *data;
+        size_t num;
+
+        if(shdr->sh_type != SHT_RELA && shdr->sh_type != SHT_REL)
+            continue;
+
+        // entries are read in order
+        advise_section(shdr, MADV_SEQUENTIAL);
+
+        sym_names = load_symbol_names(elf, shdr->sh_link);
+
+        // get data from section
+        data = elf_getdata(sections[j].scn, NULL);
+        if(!data) {
+            print_error("elf_getdata() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        num = shdr->sh_size / gelf_fsize(elf, is_rela ? ELF_T_RELA : ELF_T_REL,
+                                         1, data->d_version);
+
+        if(output_format == FORMAT_TEXT) {
+            if(!is_first)
+                out_char('\n');
+
+            print_title("Section %zu (%s)\n", j,
+                        sections[j].name ? sections[j].name : "");
+            is_first = 0;
+        }
+
+        for(size_t i = 0; i < num; i++) {
+            GElf_Rela rela;
+            GElf_Word type;
+            size_t sym;
+            const char *type_name;
+            const char *sym_name = NULL;
+
+            // a rel entry is a rela entry without the addend
+            if(is_rela) {
+                if(!gelf_getrela(data, i, &rela)) {
+                    print_error("gelf_getrela() failed: %s\n", elf_errmsg(-1));
+                    fail();
+                }
+            } else {
+                GElf_Rel rel;
+
+                if(!gelf_getrel(data, i, &rel)) {
+                    print_error("gelf_getrel() failed: %s\n", elf_errmsg(-1));
+                    fail();
+                }
+
+                rela.r_offset = rel.r_offset;
+                rela.r_info = rel.r_info;
+                rela.r_addend = 0;
+            }
+
+            type = GELF_R_TYPE(rela.r_info);
+            sym = GELF_R_SYM(rela.r_info);
+            type_name = reloc_type_name(ehdr.e_machine, type);
+
+            if(sym_names && sym < sections[shdr->sh_link].sym_names_num)
+                sym_name = sym_names[sym];
+
+            if(output_format != FORMAT_TEXT) {
+                json_record_begin("relocs", i);
+                json_field_str("section", sections[j].name);
+                json_field_uint("r_offset", rela.r_offset);
+                json_field_uint("r_type", type);
+                json_field_str("type", type_name);
+                json_field_uint("r_sym", sym);
+
+                if(sym != STN_UNDEF)
+                    json_field_str("symbol", sym_name);
+
+                if(is_rela) {
+                    json_key("r_addend");
+                    out_dec(rela.r_addend);
+                }
+
+                json_record_end();
+                continue;
+            }
+
+            print_title_index(is_rela ? "Elf_Rela" : "Elf_Rel", i);
+
+            // address of the relocation
+            print_field_hex("r_offset", rela.r_offset);
+
+            // relocation type
+            print_field("r_type", NULL);
+            if(type_name) {
+                if(!no_color_opt)
+                    out_str(C_GREEN);
+
+                out_str(type_name);
+
+                if(!no_color_opt)
+                    out_str(C_END);
+
+                out_char('\n');
+            } else {
+                print_value_hex(type);
+                out_str(" (unknown)\n");
+            }
+
+            // symbol index
+            print_field("r_sym", NULL);
+            print_value_dec(sym);
+            print_name_info(sym_name);
+
+            // constant addend
+            if(is_rela)
+                print_field_dec("r_addend", rela.r_addend);
+
+            if(i + 1 != num)
+                out_char('\n');
+        }
+    }
+
+    json_table_end();
+}
+
+// max relocation type counted separately by --reloc-summary (aarch64 types
+// go up to 1032)
+#define RELOC_TYPES_MAX 2048
+
+// relocation counts of a section (or of the whole file)
+struct reloc_counts {
+    size_t total;
+    size_t relative;
+    size_t other;
+    size_t types[RELOC_TYPES_MAX];
+};
+
+// display the counts of a single section (or of the whole file)
+void show_reloc_counts(GElf_Half machine, const char *name,
+                       struct reloc_counts *counts) {
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("reloc_summary", NO_INDEX);
+        json_field_str("section", name);
+        json_field_uint("entries", counts->total);
+        json_field_uint("relative", counts->relative);
+
+        json_key("types");
+        json_open('{');
+
+        for(GElf_Word type = 0; type < RELOC_TYPES_MAX; type++) {
+            const char *type_name = reloc_type_name(machine, type);
+            char buf[16];
+
+            if(!counts->types[type])
+                continue;
+
+            if(!type_name) {
+                sprintf(buf, "%u", type);
+                type_name = buf;
+            }
+
+            json_field_uint(type_name, counts->types[type]);
+        }
+
+        if(counts->other)
+            json_field_uint("other", counts->other);
+
+        json_close('}');
+        json_record_end();
+        return;
+    }
+
+    print_title("%s", name ? name : "Total");
+
+    for(GElf_Word type = 0; type < RELOC_TYPES_MAX; type++) {
+        const char *type_name = reloc_type_name(machine, type);
+        char buf[16];
+
+        if(!counts->types[type])
+            continue;
+
+        // the buffer isn't a string literal, print_field would cache it
+        if(type_name)
+            print_field_name(type_name);
+        else {
+            sprintf(buf, "%#x", type);
+            print_field_name_uncached(buf);
+        }
+
+        print_value_dec(counts->types[type]);
+        out_printf(" (%.1f%%)\n", 100.0 * counts->types[type] / counts->total);
+    }
+
+    if(counts->other)
+        print_field("other", "%zu (%.1f%%)", counts->other,
+                    100.0 * counts->other / counts->total);
+
+    print_field("entries", "%zu", counts->total);
+
+    if(counts->total)
+        print_field("relative", "%zu (%.1f%%)", counts->relative,
+                    100.0 * counts->relative / counts->total);
+    else
+        print_field("relative", "0");
+}
+
+// count the entries of a rel or rela section per type
+void count_relocs(Elf *elf, struct section *section,
+                  struct reloc_counts *counts) {
+    int is_rela = section->shdr.sh_type == SHT_RELA;
+    Elf_Data *data;
+    size_t num;
+
+    // get data from section
+    data = elf_getdata(section->scn, NULL);
+    if(!data) {
+        print_error("elf_getdata() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    num = section->shdr.sh_size /
+          gelf_fsize(elf, is_rela ? ELF_T_RELA : ELF_T_REL, 1,
+                     data->d_version);
+
+    for(size_t i = 0; i < num; i++) {
+        GElf_Rela rela;
+        GElf_Rel rel;
+        GElf_Word type;
+
+        if(is_rela) {
+            if(!gelf_getrela(data, i, &rela)) {
+                print_error("gelf_getrela() failed: %s\n", elf_errmsg(-1));
+                fail();
+            }
+
+            type = GELF_R_TYPE(rela.r_info);
+        } else {
+            if(!gelf_getrel(data, i, &rel)) {
+                print_error("gelf_getrel() failed: %s\n", elf_errmsg(-1));
+                fail();
+            }
+
+            type = GELF_R_TYPE(rel.r_info);
+        }
+
+        if(type < RELOC_TYPES_MAX)
+            counts->types[type]++;
+        else
+            counts->other++;
+    }
+
+    counts->total = num;
+}
+
+// count the relocation entries per type without displaying them
+// (option --reloc-summary)
+void show_reloc_summary(Elf *elf) {
+    GElf_Ehdr ehdr;
+    struct reloc_counts total;
+    struct reloc_counts counts;
+    int is_first = 1;
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Relocation Summary\n");
+
+    // the machine tells how to decode r_type
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    // strlen("R_X86_64_GOTPC32_TLSDESC"), long enough for most types
+    field_max_len = 24;
+
+    load_sections(elf);
+
+    memset(&total, 0, sizeof(total));
+
+    json_table_begin("reloc_summary");
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+
+        if(shdr->sh_type != SHT_RELA && shdr->sh_type != SHT_REL &&
+           shdr->sh_type != SHT_RELR)
+            continue;
+
+        // entries are read in order
+        advise_section(shdr, MADV_SEQUENTIAL);
+
+        memset(&counts, 0, sizeof(counts));
+
+        if(shdr->sh_type == SHT_RELR) {
+            int is_64 = ehdr.e_ident[EI_CLASS] == ELFCLASS64;
+            Elf_Data *data = relr_data(sections[j].scn);
+
+            // every relr entry is a relative relocation
+            counts.total = relr_count(data->d_buf,
+                                      data->d_size / (is_64 ? 8 : 4), is_64,
+                                      elf_needs_swap(&ehdr));
+            counts.relative = counts.total;
+        } else
+            count_relocs(elf, &sections[j], &counts);
+
+        // the relative share of the section and of the whole file
+        for(GElf_Word type = 0; type < RELOC_TYPES_MAX; type++) {
+            if(!counts.types[type])
+                continue;
+
+            if(is_relative_reloc(ehdr.e_machine, type))
+                counts.relative += counts.types[type];
+
+            total.types[type] += counts.types[type];
+        }
+
+        total.total += counts.total;
+        total.relative += counts.relative;
+        total.other += counts.other;
+
+        if(output_format == FORMAT_TEXT && !is_first)
+            out_char('\n');
+
+        show_reloc_counts(ehdr.e_machine, sections[j].name, &counts);
+        is_first = 0;
+    }
+
+    if(output_format == FORMAT_TEXT && !is_first)
+        out_char('\n');
+
+    show_reloc_counts(ehdr.e_machine, NULL, &total);
+
+    json_table_end();
+}
+
+// symbol of the address index (see load_addr_index)
+struct addr_symbol {
+    GElf_Addr value;
+    GElf_Xword size;
+    // how far from value the symbol covers: its size, or up to the end of
+    // its section when it has none
+    GElf_Xword span;
+    const char *name;
+};
+
+// symbols sorted by address, plus their addresses in eytzinger order (the
+// implicit binary tree layout of a heap, 1-based) for the lookups
+struct addr_index {
+    struct addr_symbol *symbols;
+    size_t num;
+    GElf_Addr *tree;
+    size_t *tree_symbols;
+    // the sized symbol reaching the furthest among the first i + 1, for the
+    // addresses past the end of a symbol nested in a bigger one
+    size_t *enclosing;
+};
+
+int compare_addr_symbols(const void *a, const void *b) {
+    const struct addr_symbol *x = a;
+    const struct addr_symbol *y = b;
+
+    if(x->value != y->value)
+        return x->value < y->value ? -1 : 1;
+
+    // with several symbols at the same address, the sized one comes first,
+    // and the largest of them (an alias can have another size)
+    if((x->size == 0) != (y->size == 0))
+        return (x->size == 0) - (y->size == 0);
+
+    if(x->size != y->size)
+        return x->size > y->size ? -1 : 1;
+
+    return 0;
+}
+
+// fill the eytzinger tree with the sorted addresses (in-order traversal)
+size_t fill_addr_tree(struct addr_index *index, size_t next, size_t k) {
+    if(k > index->num)
+        return next;
+
+    next = fill_addr_tree(index, next, 2 * k);
+    index->tree[k] = index->symbols[next].value;
+    index->tree_symbols[k] = next++;
+
+    return fill_addr_tree(index, next, 2 * k + 1);
+}
+
+// build the address index from the symbols of the symbol table (or of the
+// dynamic symbol table when the file is stripped)
+void load_addr_index(Elf *elf, struct addr_index *index) {
+    GElf_Word type = SHT_SYMTAB;
+    size_t cap = 0;
+    size_t num = 0;
+
+    memset(index, 0, sizeof(*index));
+
+    load_sections(elf);
+
+    for(size_t j = 1; j < sections_num; j++) {
+        if(sections[j].shdr.sh_type == SHT_SYMTAB)
+            break;
+
+        if(j + 1 == sections_num)
+            type = SHT_DYNSYM;
+    }
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        struct sym_table syms;
+
+        if(shdr->sh_type != type)
+            continue;
+
+        // symbols are read in order, only the kept ones get their name
+        advise_section(shdr, MADV_SEQUENTIAL);
+
+        load_sym_table(elf, j, &syms);
+        num = syms.num;
+
+        if(index->num + num > cap) {
+            cap = index->num + num;
+
+            index->symbols = realloc(index->symbols,
+                                     cap * sizeof(*index->symbols));
+            if(!index->symbols) {
+                print_error("realloc() failed: %s\n", strerror(errno));
+                fail();
+            }
+        }
+
+        SYM_LOOP(&syms, 0, i, sym,
+            struct addr_symbol *symbol = &index->symbols[index->num];
+
+            // only code and data have a meaningful address
+            switch(GELF_ST_TYPE(sym.st_info)) {
+                case STT_NOTYPE:
+                case STT_OBJECT:
+                case STT_FUNC:
+                case STT_GNU_IFUNC:
+                    break;
+                default:
+                    continue;
+            }
+
+            if(sym.st_shndx == SHN_UNDEF || sym.st_shndx == SHN_ABS ||
+               sym.st_name == 0)
+                continue;
+
+            symbol->value = sym.st_value;
+            symbol->size = sym.st_size;
+            symbol->span = sym.st_size;
+            symbol->name = get_sym_name(&syms, &sym);
+
+            // a label or _end only covers its own address past the end of
+            // its section
+            if(!symbol->span) {
+                GElf_Shdr *sym_shdr = sym.st_shndx < sections_num ?
+                                      &sections[sym.st_shndx].shdr : NULL;
+                GElf_Addr end = sym_shdr ? sym_shdr->sh_addr +
+                                           sym_shdr->sh_size : 0;
+
+                symbol->span = end > sym.st_value ? end - sym.st_value : 1;
+            }
+
+            if(symbol->name)
+                index->num++;
+        );
+    }
+
+    qsort(index->symbols, index->num, sizeof(*index->symbols),
+          compare_addr_symbols);
+
+    // keep one symbol per address
+    num = 0;
+    for(size_t i = 0; i < index->num; i++) {
+        if(num && index->symbols[num - 1].value == index->symbols[i].value)
+            continue;
+
+        index->symbols[num++] = index->symbols[i];
+    }
+
+    index->num = num;
+
+    index->tree = malloc((num + 1) * sizeof(*index->tree));
+    index->tree_symbols = malloc((num + 1) * sizeof(*index->tree_symbols));
+    index->enclosing = malloc((num + 1) * sizeof(*index->enclosing));
+    if(!index->tree || !index->tree_symbols || !index->enclosing) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    fill_addr_tree(index, 0, 1);
+
+    for(size_t i = 0; i < num; i++) {
+        struct addr_symbol *symbol = &index->symbols[i];
+        struct addr_symbol *furthest;
+
+        index->enclosing[i] = i;
+
+        if(i == 0)
+            continue;
+
+        // the ends are compared as distances from this symbol, so they
+        // don't overflow (everything before it starts at or below it)
+        furthest = &index->symbols[index->enclosing[i - 1]];
+        if(furthest->size > symbol->value - furthest->value &&
+           furthest->size - (symbol->value - furthest->value) > symbol->size)
+            index->enclosing[i] = index->enclosing[i - 1];
+    }
+}
+
+void free_addr_index(struct addr_index *index) {
+    free(index->symbols);
+    free(index->tree);
+    free(index->tree_symbols);
+    free(index->enclosing);
+}
+
+// find the symbol containing an address (NULL when there is none)
+struct addr_symbol *lookup_addr(struct addr_index *index, GElf_Addr addr) {
+    struct addr_symbol *symbol;
+    size_t k = 1;
+    size_t i;
+
+    // go down the tree to the first address greater than addr, without
+    // branches that depend on the data
+    while(k <= index->num)
+        k = 2 * k + (index->tree[k] <= addr);
+
+    // undo the right turns taken after the last left turn
+    k >>= __builtin_ffsll(~k);
+
+    // the symbol before it is the last one starting at or before addr
+    i = k ? index->tree_symbols[k] : index->num;
+    if(i == 0)
+        return NULL;
+
+    symbol = &index->symbols[i - 1];
+
+    // a symbol without size covers everything up to the next one, within
+    // its section
+    if(addr - symbol->value < symbol->span)
+        return symbol;
+
+    // past its end, a bigger symbol starting before it can still cover addr
+    symbol = &index->symbols[index->enclosing[i - 1]];
+    if(addr - symbol->value >= symbol->size)
+        return NULL;
+
+    return symbol;
+}
+
+// addresses given to --addr2sym (read from stdin when there are none)
+char **addr_args = NULL;
+size_t addr_args_num = 0;
+
+// resolve an address and display it as symbol+offset
+void show_addr(struct addr_index *index, const char *arg) {
+    struct addr_symbol *symbol;
+    GElf_Addr addr;
+    char *end;
+
+    // strtoull would take a negative address and wrap it around
+    errno = 0;
+    addr = strtoull(arg, &end, 16);
+    if(errno || end == arg || *end != '\0' ||
+       arg[strspn(arg, " \t")] == '-') {
+        print_error("invalid address: %s\n", arg);
+        current_job->failed = 1;
+
+        // still one line (or record) per address, so they stay in step
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("addr2sym", NO_INDEX);
+            json_field_str("address", NULL);
+            json_field_str("symbol", NULL);
+            json_record_end();
+        } else {
+            out_str(arg);
+            out_str(" ??\n");
+        }
+
+        return;
+    }
+
+    symbol = lookup_addr(index, addr);
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("addr2sym", NO_INDEX);
+        json_field_uint("address", addr);
+        json_field_str("symbol", symbol ? symbol->name : NULL);
+        if(symbol)
+            json_field_uint("offset", addr - symbol->value);
+        json_record_end();
+        return;
+    }
+
+    print_value_hex(addr);
+    out_char(' ');
+
+    if(!symbol) {
+        out_str("??\n");
+        return;
+    }
+
+    out_str(symbol->name);
+
+    if(addr != symbol->value) {
+        out_char('+');
+        out_hex(addr - symbol->value);
+    }
+
+    out_char('\n');
+}
+
+// resolve addresses to symbol+offset (option --addr2sym)
+void show_addr2sym(Elf *elf) {
+    struct addr_index index;
+
+    load_addr_index(elf, &index);
+
+    json_table_begin("addr2sym");
+
+    if(addr_args_num) {
+        for(size_t i = 0; i < addr_args_num; i++)
+            show_addr(&index, addr_args[i]);
+    } else {
+        int interactive = isatty(STDIN_FILENO);
+        char *line = NULL;
+        size_t size = 0;
+        ssize_t len;
+
+        // one address per line, as they come
+        while((len = getline(&line, &size, stdin)) != -1) {
+            while(len > 0 && strchr("\n\r\t ", line[len - 1]))
+                line[--len] = '\0';
+
+            if(len == 0)
+                continue;
+
+            show_addr(&index, line);
+
+            // answer right away when someone is typing
+            if(interactive)
+                out_flush();
+        }
+
+        free(line);
+    }
+
+    json_table_end();
+
+    free_addr_index(&index);
+}
+
+// names given to --lookup
+char **lookup_names = NULL;
+size_t lookup_names_num = 0;
+
+// what a symbol lookup needs from the file, found through the dynamic
+// segment like the dynamic linker does, so it works without section headers
+struct dyn_image {
+    const unsigned char *buf;
+    size_t size;
+    int is_64;
+    int swap;
+    GElf_Off gnu_hash;
+    GElf_Off hash;
+    GElf_Off symtab;
+    GElf_Off strtab;
+    GElf_Xword strsz;
+};
+
+// read a 4 or 8 byte word at an offset of the file
+GElf_Xword image_word(struct dyn_image *image, GElf_Off offset, size_t size) {
+    if(offset > image->size || image->size - offset < size) {
+        print_error("%s: hash table goes past the end of the file\n",
+                    current_file);
+        fail();
+    }
+
+    return read_word(image->buf + offset, 0, size == 8, image->swap);
+}
+
+// find where an address of the loaded image is in the file
+GElf_Off image_offset(Elf *elf, GElf_Addr addr) {
+    size_t phnum;
+
+    if(elf_getphdrnum(elf, &phnum) != 0) {
+        print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    for(size_t i = 0; i < phnum; i++) {
+        GElf_Phdr phdr;
+
+        if(!gelf_getphdr(elf, i, &phdr)) {
+            print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        if(phdr.p_type == PT_LOAD && addr >= phdr.p_vaddr &&
+           addr - phdr.p_vaddr < phdr.p_filesz)
+            return phdr.p_offset + (addr - phdr.p_vaddr);
+    }
+
+    print_error("%s: address %#lx is not in the file\n", current_file, addr);
+    fail();
+    return 0;
+}
+
+// get the hash tables, the dynamic symbol table and its strtab
+void load_dyn_image(Elf *elf, struct dyn_image *image) {
+    GElf_Ehdr ehdr;
+    GElf_Addr gnu_hash = 0;
+    GElf_Addr hash = 0;
+    GElf_Addr symtab = 0;
+    GElf_Addr strtab = 0;
+    size_t phnum;
+    size_t dyn_size;
+
+    memset(image, 0, sizeof(*image));
+
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    image->buf = (const unsigned char *) elf_rawfile(elf, &image->size);
+    if(!image->buf) {
+        print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    image->is_64 = ehdr.e_ident[EI_CLASS] == ELFCLASS64;
+    image->swap = elf_needs_swap(&ehdr);
+    dyn_size = image->is_64 ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+
+    if(elf_getphdrnum(elf, &phnum) != 0) {
+        print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    for(size_t i = 0; i < phnum; i++) {
+        GElf_Phdr phdr;
+
+        if(!gelf_getphdr(elf, i, &phdr)) {
+            print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        if(phdr.p_type != PT_DYNAMIC)
+            continue;
+
+        for(size_t j = 0; j < phdr.p_filesz / dyn_size; j++) {
+            GElf_Off offset = phdr.p_offset + j * dyn_size;
+            size_t word_size = dyn_size / 2;
+            GElf_Sxword tag = image_word(image, offset, word_size);
+            GElf_Xword val = image_word(image, offset + word_size, word_size);
+
+            if(tag == DT_NULL)
+                break;
+
+            switch(tag) {
+                case DT_GNU_HASH:
+                    gnu_hash = val;
+                    break;
+                case DT_HASH:
+                    hash = val;
+                    break;
+                case DT_SYMTAB:
+                    symtab = val;
+                    break;
+                case DT_STRTAB:
+                    strtab = val;
+                    break;
+                case DT_STRSZ:
+                    image->strsz = val;
+                    break;
+            }
+        }
+    }
+
+    if(!(gnu_hash || hash) || !symtab || !strtab) {
+        print_error("%s: no dynamic symbol hash table\n", current_file);
+        fail();
+    }
+
+    if(gnu_hash)
+        image->gnu_hash = image_offset(elf, gnu_hash);
+    if(hash)
+        image->hash = image_offset(elf, hash);
+
+    image->symtab = image_offset(elf, symtab);
+    image->strtab = image_offset(elf, strtab);
+
+    // the strtab has to be in the file
+    if(image->strtab > image->size || image->size - image->strtab < image->strsz)
+        image->strsz = image->size - image->strtab;
+}
+
+// read the i-th entry of the dynamic symbol table
+void image_symbol(struct dyn_image *image, size_t i, GElf_Sym *sym) {
+    size_t size = image->is_64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+    GElf_Off offset = image->symtab + i * size;
+    int swap = image->swap;
+
+    if(offset > image->size || image->size - offset < size) {
+        print_error("%s: symbol %zu goes past the end of the file\n",
+                    current_file, i);
+        fail();
+    }
+
+    if(image->is_64) {
+        Elf64_Sym raw;
+
+        memcpy(&raw, image->buf + offset, sizeof(raw));
+        sym->st_name = swap ? __builtin_bswap32(raw.st_name) : raw.st_name;
+        sym->st_info = raw.st_info;
+        sym->st_other = raw.st_other;
+        sym->st_shndx = swap ? __builtin_bswap16(raw.st_shndx) : raw.st_shndx;
+        sym->st_value = swap ? __builtin_bswap64(raw.st_value) : raw.st_value;
+        sym->st_size = swap ? __builtin_bswap64(raw.st_size) : raw.st_size;
+    } else {
+        Elf32_Sym raw;
+
+        memcpy(&raw, image->buf + offset, sizeof(raw));
+        sym->st_name = swap ? __builtin_bswap32(raw.st_name) : raw.st_name;
+        sym->st_info = raw.st_info;
+        sym->st_other = raw.st_other;
+        sym->st_shndx = swap ? __builtin_bswap16(raw.st_shndx) : raw.st_shndx;
+        sym->st_value = swap ? __builtin_bswap32(raw.st_value) : raw.st_value;
+        sym->st_size = swap ? __builtin_bswap32(raw.st_size) : raw.st_size;
+    }
+}
+
+// get the name of a symbol if it's the given one (of length len)
+const char *image_symbol_name(struct dyn_image *image, GElf_Sym *sym,
+                              const char *name, size_t len) {
+    const char *str = (const char *) image->buf + image->strtab + sym->st_name;
+
+    if(sym->st_name >= image->strsz || image->strsz - sym->st_name <= len)
+        return NULL;
+
+    if(memcmp(str, name, len + 1) != 0)
+        return NULL;
+
+    return str;
+}
+
+// hash function of DT_GNU_HASH
+uint32_t gnu_hash(const char *name) {
+    uint32_t h = 5381;
+
+    for(const unsigned char *c = (const unsigned char *) name; *c; c++)
+        h = h * 33 + *c;
+
+    return h;
+}
+
+// hash function of DT_HASH
+uint32_t sysv_hash(const char *name) {
+    uint32_t h = 0;
+
+    for(const unsigned char *c = (const unsigned char *) name; *c; c++) {
+        h = (h << 4) + *c;
+        h ^= (h >> 24) & 0xf0;
+    }
+
+    return h & 0x0fffffff;
+}
+
+// symbols found by --lookup and how many hash chain entries it took
+struct lookup_match {
+    size_t index;
+    GElf_Sym sym;
+    const char *name;
+};
+
+struct lookup_result {
+    struct lookup_match *matches;
+    size_t matches_num;
+    size_t probes;
+};
+
+// read the i-th symbol and keep it if it has the name (of length len)
+void lookup_symbol(struct dyn_image *image, size_t i, const char *name,
+                   size_t len, struct lookup_result *result) {
+    struct lookup_match *match;
+    GElf_Sym sym;
+    const char *str;
+
+    image_symbol(image, i, &sym);
+
+    str = image_symbol_name(image, &sym, name, len);
+    if(!str)
+        return;
+
+    result->matches = realloc(result->matches, (result->matches_num + 1) *
+                              sizeof(*result->matches));
+    if(!result->matches) {
+        print_error("realloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    match = &result->matches[result->matches_num++];
+    match->index = i;
+    match->sym = sym;
+    match->name = str;
+}
+
+// walk the bucket of a name in DT_GNU_HASH: the bloom filter rules out most
+// missing names, then only the chain of entries with the same bucket is read
+void lookup_gnu_hash(struct dyn_image *image, const char *name,
+                     struct lookup_result *result) {
+    size_t word_size = image->is_64 ? 8 : 4;
+    size_t bits = word_size * 8;
+    size_t len = strlen(name);
+    uint32_t h = gnu_hash(name);
+    GElf_Off base = image->gnu_hash;
+    uint32_t nbuckets = image_word(image, base, 4);
+    uint32_t symoffset = image_word(image, base + 4, 4);
+    uint32_t bloom_size = image_word(image, base + 8, 4);
+    uint32_t bloom_shift = image_word(image, base + 12, 4);
+    GElf_Off bloom = base + 16;
+    GElf_Off buckets = bloom + (GElf_Off) bloom_size * word_size;
+    GElf_Off chains = buckets + (GElf_Off) nbuckets * 4;
+    GElf_Xword word;
+    GElf_Xword mask;
+    uint32_t i;
+
+    if(nbuckets == 0 || bloom_size == 0)
+        return;
+
+    // a shift that doesn't fit a 32-bit hash is a corrupt table, its bloom
+    // filter can't rule anything out
+    if(bloom_shift < 32) {
+        word = image_word(image, bloom + (h / bits) % bloom_size * word_size,
+                          word_size);
+        mask = (GElf_Xword) 1 << (h % bits) |
+               (GElf_Xword) 1 << ((h >> bloom_shift) % bits);
+
+        if((word & mask) != mask)
+            return;
+    }
+
+    i = image_word(image, buckets + (GElf_Off) (h % nbuckets) * 4, 4);
+    if(i < symoffset)
+        return;
+
+    // the lowest bit of a chain entry marks the end of the chain
+    for(;; i++) {
+        uint32_t chain_h = image_word(image,
+                                      chains + (GElf_Off) (i - symoffset) * 4,
+                                      4);
+
+        result->probes++;
+
+        if((chain_h | 1) == (h | 1))
+            lookup_symbol(image, i, name, len, result);
+
+        if(chain_h & 1)
+            break;
+    }
+}
+
+// walk the bucket of a name in DT_HASH
+void lookup_sysv_hash(struct dyn_image *image, const char *name,
+                      struct lookup_result *result) {
+    size_t len = strlen(name);
+    uint32_t h = sysv_hash(name);
+    GElf_Off base = image->hash;
+    uint32_t nbucket = image_word(image, base, 4);
+    uint32_t nchain = image_word(image, base + 4, 4);
+    GElf_Off buckets = base + 8;
+    GElf_Off chains = buckets + (GElf_Off) nbucket * 4;
+    uint32_t i;
+
+    if(nbucket == 0)
+        return;
+
+    i = image_word(image, buckets + (GElf_Off) (h % nbucket) * 4, 4);
+
+    // a broken chain could loop, it can't be longer than the table
+    while(i != STN_UNDEF && i < nchain && result->probes < nchain) {
+        result->probes++;
+
+        lookup_symbol(image, i, name, len, result);
+
+        i = image_word(image, chains + (GElf_Off) i * 4, 4);
+    }
+}
+
+// find symbols by name through the hash table of the file (option --lookup)
+void show_lookup(Elf *elf) {
+    struct dyn_image image;
+
+    load_dyn_image(elf, &image);
+
+    // st_shndx is displayed with the section name when there are sections
+    load_sections(elf);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Symbol Lookup\n");
+
+    // strlen("st_shndx")
+    field_max_len = 8;
+
+    json_table_begin("lookup");
+
+    for(size_t i = 0; i < lookup_names_num; i++) {
+        const char *name = lookup_names[i];
+        const char *table = image.gnu_hash ? "DT_GNU_HASH" : "DT_HASH";
+        struct lookup_result result = {NULL, 0, 0};
+
+        // every version of the name is in the same chain
+        if(image.gnu_hash)
+            lookup_gnu_hash(&image, name, &result);
+        else
+            lookup_sysv_hash(&image, name, &result);
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("lookup", NO_INDEX);
+            json_field_str("name", name);
+            json_field_str("hash", table);
+            json_field_uint("probes", result.probes);
+            json_key("symbols");
+            json_open('[');
+
+            for(size_t j = 0; j < result.matches_num; j++) {
+                json_next();
+                json_open('{');
+                json_field_uint("index", result.matches[j].index);
+                json_symbol(&result.matches[j].sym, result.matches[j].name);
+                json_close('}');
+            }
+
+            json_close(']');
+            json_record_end();
+        } else {
+            if(i)
+                out_char('\n');
+
+            print_field("name", "%s", name);
+            print_field("hash", "%s", table);
+            print_field_dec("probes", result.probes);
+            print_field_dec("found", result.matches_num);
+
+            for(size_t j = 0; j < result.matches_num; j++) {
+                out_char('\n');
+                print_title_index("Elf_Sym", result.matches[j].index);
+                show_symbol(&result.matches[j].sym, result.matches[j].name);
+            }
+        }
+
+        free(result.matches);
+    }
+
+    json_table_end();
+}
+
+// how the symbols of a hash table are spread over its buckets
+struct hash_stats {
+    size_t buckets;
+    size_t used;
+    size_t symbols;
+    size_t max_chain;
+    // number of buckets for each chain length
+    size_t *chains;
+    size_t chains_cap;
+    // sum of len * (len + 1) / 2, the compares to find every symbol once
+    size_t probes;
+};
+
+// count a bucket with a chain of len symbols
+void add_chain(struct hash_stats *stats, size_t len) {
+    if(len >= stats->chains_cap) {
+        size_t cap = len * 2 + 8;
+
+        stats->chains = realloc(stats->chains, cap * sizeof(*stats->chains));
+        if(!stats->chains) {
+            print_error("realloc() failed: %s\n", strerror(errno));
+            fail();
+        }
+
+        memset(stats->chains + stats->chains_cap, 0,
+               (cap - stats->chains_cap) * sizeof(*stats->chains));
+        stats->chains_cap = cap;
+    }
+
+    stats->chains[len]++;
+    stats->buckets++;
+    stats->symbols += len;
+    stats->probes += len * (len + 1) / 2;
+
+    if(len)
+        stats->used++;
+
+    if(len > stats->max_chain)
+        stats->max_chain = len;
+}
+
+// display what the chains of a hash table look like, with the expected
+// number of compares for a name that is in it (hit) and one that isn't (miss)
+void show_hash_stats(const char *table, struct hash_stats *stats,
+                     double miss_probes) {
+    double hit_probes = stats->symbols ?
+                        (double) stats->probes / stats->symbols : 0;
+
+    if(output_format != FORMAT_TEXT) {
+        json_field_uint("buckets", stats->buckets);
+        json_field_uint("used_buckets", stats->used);
+        json_field_uint("symbols", stats->symbols);
+        json_field_uint("max_chain", stats->max_chain);
+        json_key("hit_probes");
+        out_printf("%.3f", hit_probes);
+        json_key("miss_probes");
+        out_printf("%.3f", miss_probes);
+        json_key("chains");
+        json_open('[');
+
+        for(size_t i = 0; i <= stats->max_chain && stats->buckets; i++) {
+            json_next();
+            out_udec(stats->chains[i]);
+        }
+
+        json_close(']');
+        return;
+    }
+
+    print_field("buckets", "%zu (%zu used, %.1f%%)", stats->buckets,
+                stats->used, stats->buckets ?
+                100.0 * stats->used / stats->buckets : 0);
+    print_field_dec("symbols", stats->symbols);
+    print_field("load", "%.2f symbols per used bucket", stats->used ?
+                (double) stats->symbols / stats->used : 0);
+    print_field_dec("max_chain", stats->max_chain);
+    print_field("hit", "%.3f probes", hit_probes);
+    print_field("miss", "%.3f probes", miss_probes);
+
+    out_char('\n');
+    print_title("%s Chain Lengths\n", table);
+
+    for(size_t i = 0; i <= stats->max_chain && stats->buckets; i++) {
+        char field[24];
+
+        snprintf(field, sizeof(field), "%zu", i);
+        print_field_name_uncached(field);
+        print_value_dec(stats->chains[i]);
+        out_printf(" (%.1f%%)\n", 100.0 * stats->chains[i] / stats->buckets);
+    }
+}
+
+// go through every chain of DT_GNU_HASH and how full its bloom filter is
+void gnu_hash_stats(struct dyn_image *image) {
+    struct hash_stats stats = {0};
+    size_t word_size = image->is_64 ? 8 : 4;
+    GElf_Off base = image->gnu_hash;
+    uint32_t nbuckets = image_word(image, base, 4);
+    uint32_t symoffset = image_word(image, base + 4, 4);
+    uint32_t bloom_size = image_word(image, base + 8, 4);
+    uint32_t bloom_shift = image_word(image, base + 12, 4);
+    GElf_Off bloom = base + 16;
+    GElf_Off buckets = bloom + (GElf_Off) bloom_size * word_size;
+    GElf_Off chains = buckets + (GElf_Off) nbuckets * 4;
+    size_t bloom_bits = 0;
+    double bloom_fill;
+    double false_positive;
+
+    for(uint32_t i = 0; i < bloom_size; i++) {
+        GElf_Xword word = image_word(image, bloom + i * word_size, word_size);
+
+        bloom_bits += __builtin_popcountll(word);
+    }
+
+    for(uint32_t b = 0; b < nbuckets; b++) {
+        uint32_t i = image_word(image, buckets + (GElf_Off) b * 4, 4);
+        size_t len = 0;
+
+        // the lowest bit of a chain entry marks the end of the chain
+        if(i >= symoffset) {
+            for(;; i++) {
+                len++;
+
+                if(image_word(image, chains + (GElf_Off) (i - symoffset) * 4,
+                              4) & 1)
+                    break;
+            }
+        }
+
+        add_chain(&stats, len);
+    }
+
+    // a missing name gets past the filter when its two bits are set, then
+    // goes through a whole chain of its bucket
+    bloom_fill = bloom_size ?
+                 (double) bloom_bits / (bloom_size * word_size * 8) : 0;
+    false_positive = bloom_fill * bloom_fill;
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("hash_stats", NO_INDEX);
+        json_field_str("hash", "DT_GNU_HASH");
+        json_field_uint("symoffset", symoffset);
+        json_field_uint("bloom_words", bloom_size);
+        json_field_uint("bloom_shift", bloom_shift);
+        json_field_uint("bloom_bits_set", bloom_bits);
+        json_key("bloom_fill");
+        out_printf("%.4f", bloom_fill);
+        json_key("bloom_false_positive");
+        out_printf("%.4f", false_positive);
+    } else {
+        print_title("DT_GNU_HASH\n");
+        print_field_dec("symoffset", symoffset);
+        print_field("bloom", "%u words, shift %u", bloom_size, bloom_shift);
+        print_field("bloom_fill", "%.2f%% (%zu of %zu bits)",
+                    100.0 * bloom_fill, bloom_bits,
+                    (size_t) bloom_size * word_size * 8);
+        print_field("false_pos", "%.2f%% of missing names", 100.0 *
+                    false_positive);
+    }
+
+    show_hash_stats("DT_GNU_HASH", &stats, nbuckets ?
+                    false_positive * stats.symbols / nbuckets : 0);
+
+    if(output_format != FORMAT_TEXT)
+        json_record_end();
+
+    free(stats.chains);
+}
+
+// go through every chain of DT_HASH
+void sysv_hash_stats(struct dyn_image *image) {
+    struct hash_stats stats = {0};
+    GElf_Off base = image->hash;
+    uint32_t nbucket = image_word(image, base, 4);
+    uint32_t nchain = image_word(image, base + 4, 4);
+    GElf_Off buckets = base + 8;
+    GElf_Off chains = buckets + (GElf_Off) nbucket * 4;
+
+    for(uint32_t b = 0; b < nbucket; b++) {
+        uint32_t i = image_word(image, buckets + (GElf_Off) b * 4, 4);
+        size_t len = 0;
+
+        // a broken chain could loop, it can't be longer than the table
+        while(i != STN_UNDEF && i < nchain && len < nchain) {
+            len++;
+            i = image_word(image, chains + (GElf_Off) i * 4, 4);
+        }
+
+        add_chain(&stats, len);
+    }
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("hash_stats", NO_INDEX);
+        json_field_str("hash", "DT_HASH");
+        json_field_uint("nchain", nchain);
+    } else {
+        print_title("DT_HASH\n");
+        print_field_dec("nchain", nchain);
+    }
+
+    // a missing name goes through a whole chain
+    show_hash_stats("DT_HASH", &stats, nbucket ?
+                    (double) stats.symbols / nbucket : 0);
+
+    if(output_format != FORMAT_TEXT)
+        json_record_end();
+
+    free(stats.chains);
+}
+
+// display how well the hash tables are sized (option --hash-stats)
+void show_hash_table_stats(Elf *elf) {
+    struct dyn_image image;
+
+    load_dyn_image(elf, &image);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Hash Table Statistics\n");
+
+    // strlen("bloom_fill")
+    field_max_len = 10;
+
+    json_table_begin("hash_stats");
+
+    if(image.gnu_hash)
+        gnu_hash_stats(&image);
+
+    if(image.hash) {
+        if(image.gnu_hash && output_format == FORMAT_TEXT)
+            out_char('\n');
+
+        sysv_hash_stats(&image);
+    }
+
+    json_table_end();
+}
+
+// size of the chunks section contents are read in (a multiple of the 16 bytes
+// of a hex dump line)
+#define SECTION_CHUNK_SIZE (1 << 16)
+
+// contents of a section read in chunks, decompressed on the way when the
+// section is compressed so it's never inflated in memory as a whole
+struct section_reader {
+    // contents as they are in the file (after the Chdr when compressed)
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+
+    // ELFCOMPRESS_* or 0 when the contents aren't compressed
+    GElf_Word type;
+    GElf_Xword uncompressed_size;
+
+    z_stream zlib;
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd;
+    ZSTD_inBuffer zstd_in;
+#endif
+
+    int done;
+    unsigned char buf[SECTION_CHUNK_SIZE];
+};
+
+// get the compression header of a section (returns 0 when it isn't
+// compressed)
+int section_chdr(GElf_Shdr *shdr, Elf_Scn *scn, GElf_Chdr *chdr) {
+    if(!(shdr->sh_flags & SHF_COMPRESSED) || shdr->sh_type == SHT_NOBITS)
+        return 0;
+
+    if(!gelf_getchdr(scn, chdr)) {
+        print_error("gelf_getchdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    return 1;
+}
+
+// release what the decompression uses
+void section_reader_end(struct section_reader *reader) {
+    if(reader->type == ELFCOMPRESS_ZLIB)
+        inflateEnd(&reader->zlib);
+#ifdef HAVE_ZSTD
+    else if(reader->type == ELFCOMPRESS_ZSTD)
+        ZSTD_freeDStream(reader->zstd);
+#endif
+
+    reader->type = 0;
+}
+
+// give up on a section that can't be decompressed
+void section_reader_fail(struct section_reader *reader, const char *error) {
+    section_reader_end(reader);
+
+    print_error("%s: cannot decompress section: %s\n", current_file, error);
+    fail();
+}
+
+// start reading the contents of the section with the given index
+void section_reader_begin(Elf *elf, size_t index,
+                          struct section_reader *reader) {
+    GElf_Shdr *shdr = &sections[index].shdr;
+    size_t chdr_size;
+    Elf_Data *data;
+    GElf_Chdr chdr;
+
+    reader->data = NULL;
+    reader->size = 0;
+    reader->pos = 0;
+    reader->type = 0;
+    reader->done = 0;
+
+    // no bytes in the file, only in memory
+    reader->uncompressed_size = shdr->sh_size;
+
+    if(shdr->sh_type == SHT_NOBITS || shdr->sh_size == 0)
+        return;
+
+    // the bytes of the file, not what libelf would make of them
+    data = elf_rawdata(sections[index].scn, NULL);
+    if(!data) {
+        print_error("elf_rawdata() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    reader->data = data->d_buf;
+    reader->size = data->d_size;
+    reader->uncompressed_size = data->d_size;
+
+    if(!section_chdr(shdr, sections[index].scn, &chdr))
+        return;
+
+    chdr_size = gelf_getclass(elf) == ELFCLASS64 ? sizeof(Elf64_Chdr) :
+                                                   sizeof(Elf32_Chdr);
+
+    reader->data += chdr_size;
+    reader->size -= chdr_size;
+    reader->uncompressed_size = chdr.ch_size;
+
+    switch(chdr.ch_type) {
+        case ELFCOMPRESS_ZLIB:
+            memset(&reader->zlib, 0, sizeof(reader->zlib));
+
+            if(inflateInit(&reader->zlib) != Z_OK)
+                section_reader_fail(reader, "inflateInit() failed");
+            break;
+#ifdef HAVE_ZSTD
+        case ELFCOMPRESS_ZSTD:
+            reader->zstd = ZSTD_createDStream();
+            if(!reader->zstd)
+                section_reader_fail(reader, "ZSTD_createDStream() failed");
+
+            reader->zstd_in.src = reader->data;
+            reader->zstd_in.size = reader->size;
+            reader->zstd_in.pos = 0;
+            break;
+#endif
+        default:
+            section_reader_fail(reader, elf_name_str(&elfcompress_names,
+                                                     chdr.ch_type) ?
+                                "compression not supported" :
+                                "unknown compression");
+    }
+
+    reader->type = chdr.ch_type;
+}
+
+// inflate the next chunk of a zlib compressed section
+size_t section_read_zlib(struct section_reader *reader) {
+    z_stream *zlib = &reader->zlib;
+
+    zlib->next_out = reader->buf;
+    zlib->avail_out = sizeof(reader->buf);
+
+    while(zlib->avail_out && !reader->done) {
+        int ret;
+
+        // avail_in is only 32 bits wide
+        if(zlib->avail_in == 0) {
+            size_t len = reader->size - reader->pos;
+
+            if(len > (1U << 30))
+                len = 1U << 30;
+
+            zlib->next_in = (unsigned char *) reader->data + reader->pos;
+            zlib->avail_in = len;
+            reader->pos += len;
+        }
+
+        ret = inflate(zlib, Z_NO_FLUSH);
+
+        if(ret == Z_STREAM_END)
+            reader->done = 1;
+        else if(ret == Z_BUF_ERROR && reader->pos == reader->size)
+            section_reader_fail(reader, "data cut short");
+        else if(ret != Z_OK && ret != Z_BUF_ERROR)
+            section_reader_fail(reader, zlib->msg ? zlib->msg : "bad data");
+    }
+
+    return sizeof(reader->buf) - zlib->avail_out;
+}
+
+#ifdef HAVE_ZSTD
+// decompress the next chunk of a zstd compressed section
+size_t section_read_zstd(struct section_reader *reader) {
+    ZSTD_outBuffer out = {reader->buf, sizeof(reader->buf), 0};
+
+    while(out.pos < out.size && !reader->done) {
+        size_t ret = ZSTD_decompressStream(reader->zstd, &out,
+                                           &reader->zstd_in);
+
+        if(ZSTD_isError(ret))
+            section_reader_fail(reader, ZSTD_getErrorName(ret));
+
+        if(reader->zstd_in.pos == reader->zstd_in.size) {
+            // 0 means the last frame is complete
+            if(ret == 0)
+                reader->done = 1;
+            else if(out.pos < out.size)
+                section_reader_fail(reader, "data cut short");
+        }
+    }
+
+    return out.pos;
+}
+#endif
+
+// next chunk of the contents (NULL at the end), the chunks are all
+// SECTION_CHUNK_SIZE bytes long but the last one
+const unsigned char *section_read(struct section_reader *reader, size_t *len) {
+    switch(reader->type) {
+        case ELFCOMPRESS_ZLIB:
+            *len = section_read_zlib(reader);
+            return *len ? reader->buf : NULL;
+#ifdef HAVE_ZSTD
+        case ELFCOMPRESS_ZSTD:
+            *len = section_read_zstd(reader);
+            return *len ? reader->buf : NULL;
+#endif
+        default:
+            // used in place
+            if(reader->pos == reader->size)
+                return NULL;
+
+            *len = reader->size - reader->pos;
+            if(*len > SECTION_CHUNK_SIZE)
+                *len = SECTION_CHUNK_SIZE;
+
+            reader->pos += *len;
+
+            return reader->data + reader->pos - *len;
+    }
+}
+
+// display the compressed sections and how much they shrank (option
+// --compression)
+void show_compression(Elf *elf) {
+    GElf_Xword total_size = 0;
+    GElf_Xword total_compressed = 0;
+    size_t num = 0;
+
+    load_sections(elf);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Compressed Sections\n");
+
+    // strlen("ch_addralign")
+    field_max_len = 12;
+
+    json_table_begin("compression");
+
+    for(size_t i = 1; i < sections_num; i++) {
+        GElf_Shdr *shdr = &sections[i].shdr;
+        GElf_Chdr chdr;
+
+        if(!section_chdr(shdr, sections[i].scn, &chdr))
+            continue;
+
+        total_size += chdr.ch_size;
+        total_compressed += shdr->sh_size;
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("compression", i);
+            json_field_str("name", sections[i].name);
+            json_field_uint("type", chdr.ch_type);
+            json_field_str("type_name", elf_name_str(&elfcompress_names,
+                                                     chdr.ch_type));
+            json_field_uint("size", chdr.ch_size);
+            json_field_uint("addralign", chdr.ch_addralign);
+            json_field_uint("compressed_size", shdr->sh_size);
+            json_record_end();
+            continue;
+        }
+
+        if(num++)
+            out_char('\n');
+
+        print_title_index("Elf_Chdr", i);
+
+        print_field("section", "%s", sections[i].name ? sections[i].name : "");
+
+        print_field("ch_type", NULL);
+        if(!print_elf_name(&elfcompress_names, chdr.ch_type)) {
+            print_value_hex(chdr.ch_type);
+
+            if(chdr.ch_type >= ELFCOMPRESS_LOPROC &&
+               chdr.ch_type <= ELFCOMPRESS_HIPROC)
+                out_str(" (processor-specific)\n");
+            else if(chdr.ch_type >= ELFCOMPRESS_LOOS &&
+                    chdr.ch_type <= ELFCOMPRESS_HIOS)
+                out_str(" (OS-specific)\n");
+            else
+                out_str(" (unknown)\n");
+        }
+
+        print_field_dec("ch_size", chdr.ch_size);
+        print_field_dec("ch_addralign", chdr.ch_addralign);
+        print_field_dec("sh_size", shdr->sh_size);
+
+        if(chdr.ch_size)
+            print_field("ratio", "%.2f", (double) shdr->sh_size / chdr.ch_size);
+    }
+
+    json_table_end();
+
+    if(output_format != FORMAT_TEXT || !num)
+        return;
+
+    out_char('\n');
+    print_title("Total");
+    print_field_dec("sections", num);
+    print_field_dec("ch_size", total_size);
+    print_field_dec("sh_size", total_compressed);
+
+    if(total_size)
+        print_field("ratio", "%.2f", (double) total_compressed / total_size);
+}
+
+// sections given to --hex-dump, by name or index
+char **hex_dump_sections = NULL;
+size_t hex_dump_sections_num = 0;
+
+// index of a section given by its name or its index
+size_t find_section(const char *arg) {
+    char *end;
+    unsigned long index = strtoul(arg, &end, 10);
+
+    if(*arg >= '0' && *arg <= '9' && *end == '\0') {
+        if(index < sections_num)
+            return index;
+    } else {
+        for(size_t i = 0; i < sections_num; i++) {
+            if(sections[i].name && !strcmp(sections[i].name, arg))
+                return i;
+        }
+    }
+
+    print_error("%s: no section %s\n", current_file, arg);
+    fail();
+
+    return 0;
+}
+
+// write bytes as two hex digits each
+void out_hex_bytes(const unsigned char *buf, size_t len) {
+    char hex[2 * 64];
+
+    while(len) {
+        size_t n = len < 64 ? len : 64;
+
+        for(size_t i = 0; i < n; i++) {
+            hex[2 * i] = "0123456789abcdef"[buf[i] >> 4];
+            hex[2 * i + 1] = "0123456789abcdef"[buf[i] & 0xf];
+        }
+
+        out_write(hex, 2 * n);
+        buf += n;
+        len -= n;
+    }
+}
+
+// print a hex dump line: offset, up to 16 bytes in groups of 4 and the bytes
+// that are printable
+void print_hex_line(GElf_Addr addr, const unsigned char *buf, size_t len) {
+    char line[128];
+    size_t pos = 0;
+    int digits = 8;
+
+    if(!no_color_opt) {
+        memcpy(line, C_RED, sizeof(C_RED) - 1);
+        pos += sizeof(C_RED) - 1;
+    }
+
+    // at least 8 digits
+    while(digits < 16 && addr >> (4 * digits))
+        digits++;
+
+    line[pos++] = '0';
+    line[pos++] = 'x';
+
+    for(int i = digits - 1; i >= 0; i--)
+        line[pos++] = "0123456789abcdef"[(addr >> (4 * i)) & 0xf];
+
+    if(!no_color_opt) {
+        memcpy(line + pos, C_END, sizeof(C_END) - 1);
+        pos += sizeof(C_END) - 1;
+    }
+
+    for(size_t i = 0; i < 16; i++) {
+        if(i % 4 == 0)
+            line[pos++] = ' ';
+
+        if(i < len) {
+            line[pos++] = "0123456789abcdef"[buf[i] >> 4];
+            line[pos++] = "0123456789abcdef"[buf[i] & 0xf];
+        } else {
+            line[pos++] = ' ';
+            line[pos++] = ' ';
+        }
+    }
+
+    line[pos++] = ' ';
+    line[pos++] = ' ';
+
+    for(size_t i = 0; i < len; i++)
+        line[pos++] = buf[i] >= 0x20 && buf[i] < 0x7f ? buf[i] : '.';
+
+    line[pos++] = '\n';
+
+    out_write(line, pos);
+}
+
+// display the contents of a section, decompressed when needed
+void show_section_contents(Elf *elf, size_t index) {
+    GElf_Shdr *shdr = &sections[index].shdr;
+    struct section_reader reader;
+    const unsigned char *buf;
+    GElf_Addr addr = shdr->sh_addr;
+    size_t len;
+
+    advise_section(shdr, MADV_SEQUENTIAL);
+
+    section_reader_begin(elf, index, &reader);
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("hex_dump", index);
+        json_field_str("name", sections[index].name);
+        json_field_uint("size", reader.uncompressed_size);
+        json_field_str("compression", reader.type ?
+                       elf_name_str(&elfcompress_names, reader.type) : NULL);
+
+        json_key("data");
+        out_char('"');
+
+        while((buf = section_read(&reader, &len)))
+            out_hex_bytes(buf, len);
+
+        out_char('"');
+        json_record_end();
+
+        section_reader_end(&reader);
+        return;
+    }
+
+    print_title_index("Section", index);
+
+    print_field("name", "%s", sections[index].name ? sections[index].name : "");
+    print_field_dec("size", reader.uncompressed_size);
+
+    if(reader.type) {
+        print_field("compression", NULL);
+        print_elf_name(&elfcompress_names, reader.type);
+    }
+
+    if(shdr->sh_type == SHT_NOBITS || !reader.size)
+        return;
+
+    out_char('\n');
+
+    // the chunks are a whole number of lines but the last one
+    while((buf = section_read(&reader, &len))) {
+        for(size_t i = 0; i < len; i += 16) {
+            print_hex_line(addr, buf + i, len - i < 16 ? len - i : 16);
+            addr += 16;
+        }
+    }
+
+    section_reader_end(&reader);
+}
+
+// display the sections given to --hex-dump
+void show_hex_dump(Elf *elf) {
+    load_sections(elf);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Hex Dump\n");
+
+    // strlen("compression")
+    field_max_len = 11;
+
+    json_table_begin("hex_dump");
+
+    for(size_t i = 0; i < hex_dump_sections_num; i++) {
+        if(i && output_format == FORMAT_TEXT)
+            out_char('\n');
+
+        show_section_contents(elf, find_section(hex_dump_sections[i]));
+    }
+
+    json_table_end();
+}
+
+// read a value of the file at p in the host byte order
+static inline uint16_t file_u16(const unsigned char *p, int swap) {
+    uint16_t value;
+
+    memcpy(&value, p, sizeof(value));
+    return swap ? __builtin_bswap16(value) : value;
+}
+
+static inline uint32_t file_u32(const unsigned char *p, int swap) {
+    uint32_t value;
+
+    memcpy(&value, p, sizeof(value));
+    return swap ? __builtin_bswap32(value) : value;
+}
+
+static inline uint64_t file_u64(const unsigned char *p, int swap) {
+    uint64_t value;
+
+    memcpy(&value, p, sizeof(value));
+    return swap ? __builtin_bswap64(value) : value;
+}
+
+// a note of a note section or segment
+struct note {
+    uint32_t type;
+    const char *name;
+    uint32_t namesz;
+    const unsigned char *desc;
+    uint32_t descsz;
+};
+
+// read the note at *pos and move *pos past it (returns 0 at the end or when
+// the note is cut short). Names and descriptors start at a multiple of align
+int next_note(const unsigned char *buf, size_t len, size_t *pos, size_t align,
+              int swap, struct note *note) {
+    size_t desc;
+
+    if(*pos > len || len - *pos < 12)
+        return 0;
+
+    note->namesz = file_u32(buf + *pos, swap);
+    note->descsz = file_u32(buf + *pos + 4, swap);
+    note->type = file_u32(buf + *pos + 8, swap);
+
+    desc = (*pos + 12 + note->namesz + align - 1) & ~(align - 1);
+    if(desc > len || note->descsz > len - desc)
+        return 0;
+
+    note->name = (const char *) buf + *pos + 12;
+    note->desc = buf + desc;
+
+    *pos = (desc + note->descsz + align - 1) & ~(align - 1);
+
+    return 1;
+}
+
+// whether a note is from the given owner (e.g. ELF_NOTE_GNU)
+int note_owner_is(struct note *note, const char *owner) {
+    return note->namesz == strlen(owner) + 1 &&
+           !memcmp(note->name, owner, note->namesz);
+}
+
+// build ids are 20 bytes (sha1) but can be up to 64 here
+#define BUILD_ID_SIZE (2 * 64 + 1)
+
+// longest note section or segment read_build_id looks at
+#define NOTES_MAX_SIZE (1 << 16)
+
+// read bytes of a file, from its contents in memory when there are some
+// (map) or else from fd (returns how many were read)
+size_t read_at(int fd, const char *map, size_t map_size, void *buf,
+               size_t len, uint64_t offset) {
+    ssize_t ret;
+
+    if(map) {
+        if(offset >= map_size)
+            return 0;
+
+        if(len > map_size - offset)
+            len = map_size - offset;
+
+        memcpy(buf, map + offset, len);
+
+        return len;
+    }
+
+    ret = pread(fd, buf, len, offset);
+
+    return ret < 0 ? 0 : ret;
+}
+
+// find the build id of an elf and write it in hex to id (BUILD_ID_SIZE
+// bytes), without going through libelf: only the elf header, the program
+// headers and the note segments up to the one with the build id are read
+// (the section headers and the note sections when there are no program
+// headers). Returns 1 when found, 0 when there is none and -1 when it isn't
+// an elf
+int read_build_id(int fd, const char *map, size_t map_size, char *id) {
+    unsigned char ehdr[sizeof(Elf64_Ehdr)];
+    unsigned char *table = NULL;
+    unsigned char *notes = NULL;
+    uint64_t table_offset;
+    uint16_t entsize, num;
+    int is_64, swap, sections;
+    int found = 0;
+    size_t len;
+
+    len = read_at(fd, map, map_size, ehdr, sizeof(ehdr), 0);
+    if(len < EI_NIDENT || memcmp(ehdr, ELFMAG, SELFMAG) != 0 ||
+       (ehdr[EI_CLASS] != ELFCLASS32 && ehdr[EI_CLASS] != ELFCLASS64))
+        return -1;
+
+    is_64 = ehdr[EI_CLASS] == ELFCLASS64;
+    if(len < (is_64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr)))
+        return -1;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    swap = ehdr[EI_DATA] == ELFDATA2MSB;
+#else
+    swap = ehdr[EI_DATA] == ELFDATA2LSB;
+#endif
+
+    if(is_64) {
+        table_offset = file_u64(ehdr + offsetof(Elf64_Ehdr, e_phoff), swap);
+        entsize = file_u16(ehdr + offsetof(Elf64_Ehdr, e_phentsize), swap);
+        num = file_u16(ehdr + offsetof(Elf64_Ehdr, e_phnum), swap);
+    } else {
+        table_offset = file_u32(ehdr + offsetof(Elf32_Ehdr, e_phoff), swap);
+        entsize = file_u16(ehdr + offsetof(Elf32_Ehdr, e_phentsize), swap);
+        num = file_u16(ehdr + offsetof(Elf32_Ehdr, e_phnum), swap);
+    }
+
+    // relocatable objects only have the note sections
+    sections = num == 0;
+
+    if(sections && is_64) {
+        table_offset = file_u64(ehdr + offsetof(Elf64_Ehdr, e_shoff), swap);
+        entsize = file_u16(ehdr + offsetof(Elf64_Ehdr, e_shentsize), swap);
+        num = file_u16(ehdr + offsetof(Elf64_Ehdr, e_shnum), swap);
+    } else if(sections) {
+        table_offset = file_u32(ehdr + offsetof(Elf32_Ehdr, e_shoff), swap);
+        entsize = file_u16(ehdr + offsetof(Elf32_Ehdr, e_shentsize), swap);
+        num = file_u16(ehdr + offsetof(Elf32_Ehdr, e_shnum), swap);
+    }
+
+    if(num == 0 || entsize < (sections ?
+                              (is_64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr)) :
+                              (is_64 ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr))))
+        return 0;
+
+    table = malloc((size_t) entsize * num);
+    notes = malloc(NOTES_MAX_SIZE);
+    if(!table || !notes)
+        goto out;
+
+    if(read_at(fd, map, map_size, table, (size_t) entsize * num,
+               table_offset) != (size_t) entsize * num)
+        goto out;
+
+    for(size_t i = 0; i < num && !found; i++) {
+        const unsigned char *entry = table + i * entsize;
+        uint64_t offset, size, align;
+        struct note note;
+        size_t pos = 0;
+
+        if(sections && is_64) {
+            if(file_u32(entry + offsetof(Elf64_Shdr, sh_type), swap) != SHT_NOTE)
+                continue;
+
+            offset = file_u64(entry + offsetof(Elf64_Shdr, sh_offset), swap);
+            size = file_u64(entry + offsetof(Elf64_Shdr, sh_size), swap);
+            align = file_u64(entry + offsetof(Elf64_Shdr, sh_addralign), swap);
+        } else if(sections) {
+            if(file_u32(entry + offsetof(Elf32_Shdr, sh_type), swap) != SHT_NOTE)
+                continue;
+
+            offset = file_u32(entry + offsetof(Elf32_Shdr, sh_offset), swap);
+            size = file_u32(entry + offsetof(Elf32_Shdr, sh_size), swap);
+            align = file_u32(entry + offsetof(Elf32_Shdr, sh_addralign), swap);
+        } else if(is_64) {
+            if(file_u32(entry + offsetof(Elf64_Phdr, p_type), swap) != PT_NOTE)
+                continue;
+
+            offset = file_u64(entry + offsetof(Elf64_Phdr, p_offset), swap);
+            size = file_u64(entry + offsetof(Elf64_Phdr, p_filesz), swap);
+            align = file_u64(entry + offsetof(Elf64_Phdr, p_align), swap);
+        } else {
+            if(file_u32(entry + offsetof(Elf32_Phdr, p_type), swap) != PT_NOTE)
+                continue;
+
+            offset = file_u32(entry + offsetof(Elf32_Phdr, p_offset), swap);
+            size = file_u32(entry + offsetof(Elf32_Phdr, p_filesz), swap);
+            align = file_u32(entry + offsetof(Elf32_Phdr, p_align), swap);
+        }
+
+        len = read_at(fd, map, map_size, notes, size < NOTES_MAX_SIZE ? size :
+                      NOTES_MAX_SIZE, offset);
+
+        while(next_note(notes, len, &pos, align == 8 ? 8 : 4, swap, &note)) {
+            if(note.type != NT_GNU_BUILD_ID ||
+               !note_owner_is(&note, ELF_NOTE_GNU) ||
+               2 * note.descsz >= BUILD_ID_SIZE)
+                continue;
+
+            for(size_t j = 0; j < note.descsz; j++) {
+                id[2 * j] = "0123456789abcdef"[note.desc[j] >> 4];
+                id[2 * j + 1] = "0123456789abcdef"[note.desc[j] & 0xf];
+            }
+
+            id[2 * note.descsz] = '\0';
+            found = 1;
+            break;
+        }
+    }
+
+out:
+    free(table);
+    free(notes);
+
+    return found;
+}
+
+// display a build id, NULL when there is none (option --build-id)
+void show_build_id(const char *id) {
+    if(output_format == FORMAT_JSON) {
+        json_field_str("build_id", id);
+        return;
+    }
+
+    if(output_format == FORMAT_NDJSON) {
+        json_record_begin("build_id", NO_INDEX);
+        json_field_str("build_id", id);
+        json_record_end();
+        return;
+    }
+
+    print_title("Build ID\n");
+
+    // strlen("build_id")
+    field_max_len = 8;
+
+    print_field("build_id", "%s", id ? id : "none");
+}
+
+// same as show_build_id but finds the build id of an elf opened with libelf
+void show_elf_build_id(Elf *elf) {
+    char id[BUILD_ID_SIZE];
+    const char *buf;
+    size_t size;
+
+    buf = elf_rawfile(elf, &size);
+    if(!buf) {
+        print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    show_build_id(read_build_id(-1, buf, size, id) > 0 ? id : NULL);
+}
+
+// display the properties of a NT_GNU_PROPERTY_TYPE_0 note: a type, a size
+// and the data padded to 8 bytes (4 on 32-bit)
+void show_gnu_properties(struct note *note, int is_64, int swap) {
+    size_t align = is_64 ? 8 : 4;
+    size_t pos = 0;
+
+    if(output_format != FORMAT_TEXT) {
+        json_key("properties");
+        json_open('[');
+    }
+
+    while(pos + 8 <= note->descsz) {
+        uint32_t type = file_u32(note->desc + pos, swap);
+        uint32_t size = file_u32(note->desc + pos + 4, swap);
+        const unsigned char *data = note->desc + pos + 8;
+        const struct elf_names *flags = NULL;
+        uint64_t value = 0;
+
+        if(size > note->descsz - pos - 8)
+            break;
+
+        pos += 8 + ((size + align - 1) & ~(align - 1));
+
+        if(size == 4)
+            value = file_u32(data, swap);
+        else if(size == 8)
+            value = file_u64(data, swap);
+
+        // properties that are a mask of bits with names of their own
+        switch(type) {
+            case GNU_PROPERTY_X86_FEATURE_1_AND:
+                flags = &gnu_property_x86_feature_1_names;
+                break;
+            case GNU_PROPERTY_X86_ISA_1_NEEDED:
+            case GNU_PROPERTY_X86_ISA_1_USED:
+                flags = &gnu_property_x86_isa_1_names;
+                break;
+            case GNU_PROPERTY_AARCH64_FEATURE_1_AND:
+                flags = &gnu_property_aarch64_feature_1_names;
+                break;
+            case GNU_PROPERTY_1_NEEDED:
+                flags = &gnu_property_1_needed_names;
+                break;
+        }
+
+        if(output_format != FORMAT_TEXT) {
+            json_next();
+            json_open('{');
+            json_field_uint("type", type);
+            json_field_str("type_name", elf_name_str(&gnu_property_names, type));
+
+            if(size == 4 || size == 8)
+                json_field_uint("value", value);
+            else {
+                json_key("data");
+                out_char('"');
+                out_hex_bytes(data, size);
+                out_char('"');
+            }
+
+            json_close('}');
+            continue;
+        }
+
+        print_field("pr_type", NULL);
+        if(!print_elf_name(&gnu_property_names, type)) {
+            print_value_hex(type);
+
+            if(type >= GNU_PROPERTY_LOPROC && type <= GNU_PROPERTY_HIPROC)
+                out_str(" (processor-specific)\n");
+            else if(type >= GNU_PROPERTY_LOUSER)
+                out_str(" (application-specific)\n");
+            else
+                out_str(" (unknown)\n");
+        }
+
+        print_field("pr_data", NULL);
+
+        if(flags && size == 4)
+            print_flag_names(flags, value);
+        else if(size == 4 || size == 8) {
+            print_value_hex(value);
+            out_char('\n');
+        } else {
+            if(!no_color_opt)
+                out_str(C_GREEN);
+
+            out_hex_bytes(data, size);
+
+            if(!no_color_opt)
+                out_str(C_END);
+
+            out_char('\n');
+        }
+    }
+
+    if(output_format != FORMAT_TEXT)
+        json_close(']');
+}
+
+// display what a note holds, for the kinds of notes known
+void show_note_desc(struct note *note, int is_64, int swap) {
+    const char *str = (const char *) note->desc;
+    int is_gnu = note_owner_is(note, ELF_NOTE_GNU);
+
+    if(is_gnu && note->type == NT_GNU_BUILD_ID) {
+        if(output_format != FORMAT_TEXT) {
+            json_key("build_id");
+            out_char('"');
+            out_hex_bytes(note->desc, note->descsz);
+            out_char('"');
+            return;
+        }
+
+        print_field("build_id", NULL);
+
+        if(!no_color_opt)
+            out_str(C_GREEN);
+
+        out_hex_bytes(note->desc, note->descsz);
+
+        if(!no_color_opt)
+            out_str(C_END);
+
+        out_char('\n');
+    } else if(is_gnu && note->type == NT_GNU_ABI_TAG && note->descsz >= 16) {
+        uint32_t os = file_u32(note->desc, swap);
+        uint32_t major = file_u32(note->desc + 4, swap);
+        uint32_t minor = file_u32(note->desc + 8, swap);
+        uint32_t subminor = file_u32(note->desc + 12, swap);
+
+        if(output_format != FORMAT_TEXT) {
+            char version[32];
+
+            snprintf(version, sizeof(version), "%u.%u.%u", major, minor,
+                     subminor);
+
+            json_field_uint("abi_os", os);
+            json_field_str("abi_os_name", elf_name_str(&elf_note_os_names, os));
+            json_field_str("abi_version", version);
+            return;
+        }
+
+        print_field("abi_os", NULL);
+        if(!print_elf_name(&elf_note_os_names, os)) {
+            print_value_dec(os);
+            out_str(" (unknown)\n");
+        }
+
+        print_field("abi_version", "%u.%u.%u", major, minor, subminor);
+    } else if(is_gnu && note->type == NT_GNU_PROPERTY_TYPE_0) {
+        show_gnu_properties(note, is_64, swap);
+    } else if((is_gnu && note->type == NT_GNU_GOLD_VERSION) ||
+              (note_owner_is(note, ELF_NOTE_FDO) &&
+               note->type == NT_FDO_PACKAGING_METADATA)) {
+        // a string, json for the package metadata
+        const char *key = note->type == NT_GNU_GOLD_VERSION ? "gold_version" :
+                                                              "package";
+        int len = strnlen(str, note->descsz);
+
+        if(output_format != FORMAT_TEXT) {
+            char *value = strndup(str, len);
+
+            if(!value) {
+                print_error("strndup() failed: %s\n", strerror(errno));
+                fail();
+            }
+
+            json_field_str(key, value);
+            free(value);
+            return;
+        }
+
+        print_field(key, "%.*s", len, str);
+    } else if(note->descsz) {
+        if(output_format != FORMAT_TEXT) {
+            json_key("desc");
+            out_char('"');
+            out_hex_bytes(note->desc, note->descsz);
+            out_char('"');
+            return;
+        }
+
+        print_field("n_desc", NULL);
+
+        if(!no_color_opt)
+            out_str(C_GREEN);
+
+        out_hex_bytes(note->desc, note->descsz);
+
+        if(!no_color_opt)
+            out_str(C_END);
+
+        out_char('\n');
+    }
+}
+
+// display the notes of a note section (section is its name) or segment
+// (segment is its index), num counts the notes displayed so far
+void show_note_list(const unsigned char *buf, size_t len, size_t align,
+                    GElf_Ehdr *ehdr, const char *section, size_t segment,
+                    size_t *num) {
+    int is_64 = ehdr->e_ident[EI_CLASS] == ELFCLASS64;
+    int swap = elf_needs_swap(ehdr);
+    struct note note;
+    size_t pos = 0;
+
+    while(next_note(buf, len, &pos, align == 8 ? 8 : 4, swap, &note)) {
+        const char *type_name = NULL;
+        int name_len = note.namesz ? strnlen(note.name, note.namesz) : 0;
+
+        if(note_owner_is(&note, ELF_NOTE_GNU))
+            type_name = elf_name_str(&nt_gnu_names, note.type);
+        else if(note_owner_is(&note, ELF_NOTE_FDO) &&
+                note.type == NT_FDO_PACKAGING_METADATA)
+            type_name = "NT_FDO_PACKAGING_METADATA";
+
+        if(output_format != FORMAT_TEXT) {
+            char *name = strndup(note.name, name_len);
+
+            if(!name) {
+                print_error("strndup() failed: %s\n", strerror(errno));
+                fail();
+            }
+
+            json_record_begin("notes", (*num)++);
+
+            if(section)
+                json_field_str("section", section);
+            else
+                json_field_uint("segment", segment);
+
+            json_field_str("name", name);
+            json_field_uint("type", note.type);
+            json_field_str("type_name", type_name);
+            json_field_uint("descsz", note.descsz);
+            show_note_desc(&note, is_64, swap);
+            json_record_end();
+
+            free(name);
+            continue;
+        }
+
+        if((*num)++)
+            out_char('\n');
+
+        print_title_index("Elf_Nhdr", *num - 1);
+
+        if(section)
+            print_field("section", "%s", section);
+        else
+            print_field_dec("segment", segment);
+
+        print_field("n_name", "%.*s", name_len, note.name);
+
+        print_field("n_type", NULL);
+        if(note_owner_is(&note, ELF_NOTE_GNU) && type_name)
+            print_elf_name(&nt_gnu_names, note.type);
+        else if(type_name)
+            print_value_name(type_name);
+        else {
+            print_value_hex(note.type);
+            out_char('\n');
+        }
+
+        print_field_dec("n_descsz", note.descsz);
+
+        show_note_desc(&note, is_64, swap);
+    }
+}
+
+// display the notes of the note sections, or of the note segments when there
+// are no section headers (option --notes)
+void show_notes(Elf *elf) {
+    GElf_Ehdr ehdr;
+    size_t num = 0;
+    int has_sections = 0;
+
+    if(!gelf_getehdr(elf, &ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    load_sections(elf);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Notes\n");
+
+    // strlen("abi_version")
+    field_max_len = 12;
+
+    json_table_begin("notes");
+
+    for(size_t i = 1; i < sections_num; i++) {
+        GElf_Shdr *shdr = &sections[i].shdr;
+        Elf_Data *data;
+
+        has_sections = 1;
+
+        if(shdr->sh_type != SHT_NOTE)
+            continue;
+
+        data = elf_rawdata(sections[i].scn, NULL);
+        if(!data) {
+            print_error("elf_rawdata() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        show_note_list(data->d_buf, data->d_size, shdr->sh_addralign, &ehdr,
+                       sections[i].name ? sections[i].name : "", NO_INDEX,
+                       &num);
+    }
+
+    if(!has_sections) {
+        const char *buf;
+        size_t size, phnum;
+
+        buf = elf_rawfile(elf, &size);
+        if(!buf) {
+            print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        if(elf_getphdrnum(elf, &phnum) != 0) {
+            print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        for(size_t i = 0; i < phnum; i++) {
+            GElf_Phdr phdr;
+
+            if(!gelf_getphdr(elf, i, &phdr)) {
+                print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+                fail();
+            }
+
+            if(phdr.p_type != PT_NOTE || phdr.p_offset >= size ||
+               phdr.p_filesz > size - phdr.p_offset)
+                continue;
+
+            show_note_list((const unsigned char *) buf + phdr.p_offset,
+                           phdr.p_filesz, phdr.p_align, &ehdr, NULL, i, &num);
+        }
+    }
+
+    json_table_end();
+}
+
+// longest path --deps builds
+#define DEP_PATH_SIZE 4096
+
+// a file --deps looked at while searching for a library, kept for every file
+// and thread so each path is opened once
+struct dep_lib {
+    char *path;
+    int state;
+    // errno when memory ran out reading it (it's then missing)
+    int error;
+
+    // the directory of its real path ($ORIGIN)
+    char *origin;
+    dev_t dev;
+    ino_t ino;
+
+    // what a library has to match to be loaded
+    int is_64;
+    int data;
+    int machine;
+    uint32_t flags;
+
+    // where the libraries of the file displayed are installed (only set for
+    // it, see dep_layout)
+    const char *multiarch;
+    const char *lib_dir;
+
+    char *soname;
+    char **needed;
+    size_t needed_num;
+    char *rpath;
+    char *runpath;
+    char *interp;
+    int nodeflib;
+
+    struct dep_lib *next;
+};
+
+// state of a dep_lib
+#define DEP_LOADING 0
+#define DEP_LOADED  1
+// not there, or not a dynamic elf
+#define DEP_MISSING 2
+
+#define DEP_LIBS_SIZE 4096
+
+struct dep_lib *dep_libs[DEP_LIBS_SIZE];
+pthread_mutex_t deps_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t deps_cond = PTHREAD_COND_INITIALIZER;
+
+// a string of the dynamic strtab (NULL when it isn't in the file)
+const char *dep_string(const unsigned char *buf, size_t size, uint64_t strtab,
+                       uint64_t strsz, uint64_t offset) {
+    const unsigned char *str;
+    size_t max;
+
+    if(strtab >= size || offset >= strsz || offset >= size - strtab)
+        return NULL;
+
+    str = buf + strtab + offset;
+    max = size - strtab - offset;
+    if(max > strsz - offset)
+        max = strsz - offset;
+
+    if(!memchr(str, '\0', max))
+        return NULL;
+
+    return (const char *) str;
+}
+
+// copy a string that can be NULL, returns 0 when it can't be allocated
+int dep_copy(char **copy, const char *str) {
+    *copy = str ? strdup(str) : NULL;
+
+    return !str || *copy;
+}
+
+// get the type, offset, address and size in the file of a program header
+void dep_phdr(const unsigned char *entry, int is_64, int swap, uint32_t *type,
+              uint64_t *offset, uint64_t *vaddr, uint64_t *filesz) {
+    *type = file_u32(entry, swap);
+
+    if(is_64) {
+        *offset = file_u64(entry + offsetof(Elf64_Phdr, p_offset), swap);
+        *vaddr = file_u64(entry + offsetof(Elf64_Phdr, p_vaddr), swap);
+        *filesz = file_u64(entry + offsetof(Elf64_Phdr, p_filesz), swap);
+    } else {
+        *offset = file_u32(entry + offsetof(Elf32_Phdr, p_offset), swap);
+        *vaddr = file_u32(entry + offsetof(Elf32_Phdr, p_vaddr), swap);
+        *filesz = file_u32(entry + offsetof(Elf32_Phdr, p_filesz), swap);
+    }
+}
+
+// read what --deps needs from an elf in memory, through the program headers
+// like the dynamic linker does (returns 0 when it isn't a dynamic elf and -1,
+// with errno set, when memory runs out)
+int dep_parse(struct dep_lib *lib, const unsigned char *buf, size_t size) {
+    uint64_t phoff, dyn_offset = 0, dyn_size = 0;
+    uint64_t strtab = 0, strtab_offset = size, strsz = 0;
+    uint64_t soname = -1, rpath = -1, runpath = -1;
+    uint64_t *needed = NULL;
+    size_t needed_num = 0;
+    size_t word;
+    uint16_t phentsize, phnum;
+    int swap;
+
+    if(size < EI_NIDENT || memcmp(buf, ELFMAG, SELFMAG) != 0 ||
+       (buf[EI_CLASS] != ELFCLASS32 && buf[EI_CLASS] != ELFCLASS64))
+        return 0;
+
+    lib->is_64 = buf[EI_CLASS] == ELFCLASS64;
+    lib->data = buf[EI_DATA];
+    word = lib->is_64 ? 8 : 4;
+
+    if(size < (lib->is_64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr)))
+        return 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    swap = buf[EI_DATA] == ELFDATA2MSB;
+#else
+    swap = buf[EI_DATA] == ELFDATA2LSB;
+#endif
+
+    lib->machine = file_u16(buf + offsetof(Elf64_Ehdr, e_machine), swap);
+
+    if(lib->is_64) {
+        phoff = file_u64(buf + offsetof(Elf64_Ehdr, e_phoff), swap);
+        phentsize = file_u16(buf + offsetof(Elf64_Ehdr, e_phentsize), swap);
+        phnum = file_u16(buf + offsetof(Elf64_Ehdr, e_phnum), swap);
+        lib->flags = file_u32(buf + offsetof(Elf64_Ehdr, e_flags), swap);
+    } else {
+        phoff = file_u32(buf + offsetof(Elf32_Ehdr, e_phoff), swap);
+        phentsize = file_u16(buf + offsetof(Elf32_Ehdr, e_phentsize), swap);
+        phnum = file_u16(buf + offsetof(Elf32_Ehdr, e_phnum), swap);
+        lib->flags = file_u32(buf + offsetof(Elf32_Ehdr, e_flags), swap);
+    }
+
+    if(phentsize < (lib->is_64 ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr)) ||
+       phoff > size || (size - phoff) / phentsize < phnum)
+        return 0;
+
+    // the dynamic segment and the interpreter
+    for(size_t i = 0; i < phnum; i++) {
+        uint32_t type;
+        uint64_t offset, vaddr, filesz;
+
+        dep_phdr(buf + phoff + i * phentsize, lib->is_64, swap, &type,
+                 &offset, &vaddr, &filesz);
+
+        if(offset > size || filesz > size - offset)
+            continue;
+
+        if(type == PT_DYNAMIC) {
+            dyn_offset = offset;
+            dyn_size = filesz;
+        } else if(type == PT_INTERP && filesz && !lib->interp &&
+                  memchr(buf + offset, '\0', filesz)) {
+            if(!dep_copy(&lib->interp, (const char *) buf + offset))
+                return -1;
+        }
+    }
+
+    if(!dyn_size)
+        return 0;
+
+    for(uint64_t pos = 0; dyn_size - pos >= 2 * word; pos += 2 * word) {
+        int64_t tag = read_word(buf + dyn_offset + pos, 0, lib->is_64, swap);
+        uint64_t val = read_word(buf + dyn_offset + pos + word, 0, lib->is_64,
+                                 swap);
+
+        if(tag == DT_NULL)
+            break;
+
+        switch(tag) {
+            case DT_NEEDED: {
+                uint64_t *new_needed = realloc(needed, (needed_num + 1) *
+                                                       sizeof(*needed));
+
+                if(!new_needed) {
+                    free(needed);
+                    return -1;
+                }
+
+                needed = new_needed;
+                needed[needed_num++] = val;
+                break;
+            }
+            case DT_SONAME:
+                soname = val;
+                break;
+            case DT_RPATH:
+                rpath = val;
+                break;
+            case DT_RUNPATH:
+                runpath = val;
+                break;
+            case DT_STRTAB:
+                strtab = val;
+                break;
+            case DT_STRSZ:
+                strsz = val;
+                break;
+            case DT_FLAGS_1:
+                lib->nodeflib = (val & DF_1_NODEFLIB) != 0;
+                break;
+        }
+    }
+
+    // DT_STRTAB is an address, find it in the load segments
+    for(size_t i = 0; i < phnum; i++) {
+        uint32_t type;
+        uint64_t offset, vaddr, filesz;
+
+        dep_phdr(buf + phoff + i * phentsize, lib->is_64, swap, &type,
+                 &offset, &vaddr, &filesz);
+
+        if(type == PT_LOAD && strtab >= vaddr && strtab - vaddr < filesz) {
+            strtab_offset = offset + (strtab - vaddr);
+            break;
+        }
+    }
+
+    // the names that aren't in the strtab are left out
+    lib->needed = calloc(needed_num + 1, sizeof(*lib->needed));
+    if(!lib->needed) {
+        free(needed);
+        return -1;
+    }
+
+    for(size_t i = 0; i < needed_num; i++) {
+        const char *name = dep_string(buf, size, strtab_offset, strsz,
+                                      needed[i]);
+
+        if(!name)
+            continue;
+
+        if(!dep_copy(&lib->needed[lib->needed_num], name)) {
+            free(needed);
+            return -1;
+        }
+
+        lib->needed_num++;
+    }
+
+    free(needed);
+
+    if(!dep_copy(&lib->soname, dep_string(buf, size, strtab_offset, strsz,
+                                          soname)) ||
+       !dep_copy(&lib->rpath, dep_string(buf, size, strtab_offset, strsz,
+                                         rpath)) ||
+       !dep_copy(&lib->runpath, dep_string(buf, size, strtab_offset, strsz,
+                                           runpath)))
+        return -1;
+
+    return 1;
+}
+
+// free what dep_parse and dep_read allocated for a library
+void dep_free(struct dep_lib *lib) {
+    for(size_t k = 0; k < lib->needed_num; k++)
+        free(lib->needed[k]);
+
+    free(lib->needed);
+    free(lib->soname);
+    free(lib->rpath);
+    free(lib->runpath);
+    free(lib->interp);
+    free(lib->origin);
+}
+
+// the directory of the real path of a file, where $ORIGIN points (NULL when
+// memory runs out)
+char *dep_origin(const char *path) {
+    char *real = realpath(path, NULL);
+    char *slash;
+
+    if(!real)
+        real = strdup(path);
+
+    if(!real)
+        return NULL;
+
+    slash = strrchr(real, '/');
+    if(!slash)
+        strcpy(real, ".");
+    else if(slash == real)
+        slash[1] = '\0';
+    else
+        *slash = '\0';
+
+    return real;
+}
+
+// open a file and read it into lib, returns its state (the errno of a
+// failure to allocate memory goes in lib->error, the file is then missing)
+int dep_read(struct dep_lib *lib) {
+    int state = DEP_MISSING;
+    struct stat st;
+    void *map;
+    int fd;
+
+    fd = open(lib->path, O_RDONLY);
+    if(fd < 0)
+        return state;
+
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(map != MAP_FAILED) {
+            if(stats_opt)
+                __atomic_fetch_add(&stats_mapped_bytes, st.st_size,
+                                   __ATOMIC_RELAXED);
+
+            int parsed = dep_parse(lib, map, st.st_size);
+
+            if(parsed > 0 && !(lib->origin = dep_origin(lib->path)))
+                parsed = -1;
+
+            if(parsed > 0) {
+                state = DEP_LOADED;
+                lib->dev = st.st_dev;
+                lib->ino = st.st_ino;
+            } else if(parsed < 0)
+                lib->error = errno;
+
+            munmap(map, st.st_size);
+        }
+    }
+
+    close(fd);
+
+    return state;
+}
+
+// errno of the last failure to allocate memory of the thread, the threads
+// resolving a level of the tree report it instead of calling fail()
+__thread int dep_errno = 0;
+
+// the file at a path, read the first time it's asked for (the threads that
+// ask for it meanwhile wait for it), NULL when memory runs out
+struct dep_lib *dep_load(const char *path) {
+    uint32_t hash = gnu_hash(path);
+    struct dep_lib **slot = &dep_libs[hash % DEP_LIBS_SIZE];
+    struct dep_lib *lib;
+    int state;
+
+    pthread_mutex_lock(&deps_lock);
+
+    for(lib = *slot; lib; lib = lib->next) {
+        if(!strcmp(lib->path, path))
+            break;
+    }
+
+    if(lib) {
+        while(lib->state == DEP_LOADING)
+            pthread_cond_wait(&deps_cond, &deps_lock);
+
+        if(lib->error)
+            dep_errno = lib->error;
+
+        pthread_mutex_unlock(&deps_lock);
+        return lib;
+    }
+
+    lib = calloc(1, sizeof(*lib));
+    if(lib)
+        lib->path = strdup(path);
+
+    if(!lib || !lib->path) {
+        dep_errno = errno;
+        free(lib);
+        pthread_mutex_unlock(&deps_lock);
+        return NULL;
+    }
+
+    lib->state = DEP_LOADING;
+    lib->next = *slot;
+    *slot = lib;
+
+    pthread_mutex_unlock(&deps_lock);
+
+    state = dep_read(lib);
+
+    pthread_mutex_lock(&deps_lock);
+    lib->state = state;
+    pthread_cond_broadcast(&deps_cond);
+
+    if(lib->error)
+        dep_errno = lib->error;
+
+    pthread_mutex_unlock(&deps_lock);
+
+    return lib;
+}
+
+// an entry of /etc/ld.so.cache: a library name and its path
+struct dep_cache_entry {
+    const char *name;
+    const char *path;
+};
+
+struct dep_cache_entry *dep_cache = NULL;
+size_t dep_cache_num = 0;
+pthread_once_t dep_cache_once = PTHREAD_ONCE_INIT;
+
+#define LD_SO_CACHE "/etc/ld.so.cache"
+#define LD_SO_CACHE_OLD "ld.so-1.7.0"
+#define LD_SO_CACHE_NEW "glibc-ld.so.cache1.1"
+
+// read the entries of the new format of ld.so.cache (after the old one in
+// the caches of older glibcs), it stays mapped
+void dep_cache_load(void) {
+    const unsigned char *buf;
+    struct stat st;
+    size_t size, offset = 0;
+    uint32_t num;
+    int fd;
+
+    fd = open(LD_SO_CACHE, O_RDONLY);
+    if(fd < 0)
+        return;
+
+    if(fstat(fd, &st) != 0 || st.st_size < 48) {
+        close(fd);
+        return;
+    }
+
+    size = st.st_size;
+    buf = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(buf == MAP_FAILED)
+        return;
+
+    // the old format: magic, number of entries and 12 byte entries
+    if(!memcmp(buf, LD_SO_CACHE_OLD, strlen(LD_SO_CACHE_OLD))) {
+        num = file_u32(buf + 12, 0);
+        offset = (16 + (uint64_t) num * 12 + 7) & ~(uint64_t) 7;
+    }
+
+    if(offset > size - 48 ||
+       memcmp(buf + offset, LD_SO_CACHE_NEW, strlen(LD_SO_CACHE_NEW)))
+        return;
+
+    // then 24 byte entries whose strings are from the start of their header
+    buf += offset;
+    size -= offset;
+
+    num = file_u32(buf + 20, 0);
+    if(num > (size - 48) / 24)
+        return;
+
+    dep_cache = calloc(num + 1, sizeof(*dep_cache));
+    if(!dep_cache)
+        return;
+
+    for(size_t i = 0; i < num; i++) {
+        const unsigned char *entry = buf + 48 + i * 24;
+        uint32_t flags = file_u32(entry, 0);
+        uint32_t key = file_u32(entry + 4, 0);
+        uint32_t value = file_u32(entry + 8, 0);
+        uint64_t hwcap = file_u64(entry + 16, 0);
+
+        // only elf libraries, and not the ones of the glibc-hwcaps
+        // subdirectories, which depend on the cpu
+        if((flags & 0xff) < 1 || (flags & 0xff) > 3 || hwcap ||
+           key >= size || value >= size ||
+           !memchr(buf + key, '\0', size - key) ||
+           !memchr(buf + value, '\0', size - value))
+            continue;
+
+        dep_cache[dep_cache_num++] = (struct dep_cache_entry) {
+            (const char *) buf + key, (const char *) buf + value
+        };
+    }
+}
+
+// multiarch triplet of a class, byte order and machine (Debian and
+// derivatives), NULL when there is none
+const char *dep_multiarch(struct dep_lib *lib) {
+    int msb = lib->data == ELFDATA2MSB;
+
+    switch(lib->machine) {
+        case EM_X86_64:
+            return lib->is_64 ? "x86_64-linux-gnu" : "x86_64-linux-gnux32";
+        case EM_386:
+            return "i386-linux-gnu";
+        case EM_AARCH64:
+            return msb ? "aarch64_be-linux-gnu" : "aarch64-linux-gnu";
+        case EM_ARM:
+            // the float abi is part of the triplet
+            if(lib->flags & EF_ARM_ABI_FLOAT_HARD)
+                return msb ? "armeb-linux-gnueabihf" : "arm-linux-gnueabihf";
+
+            return msb ? "armeb-linux-gnueabi" : "arm-linux-gnueabi";
+        case EM_RISCV:
+            return lib->is_64 ? "riscv64-linux-gnu" : NULL;
+        case EM_PPC:
+            return msb ? "powerpc-linux-gnu" : NULL;
+        case EM_PPC64:
+            return msb ? "powerpc64-linux-gnu" : "powerpc64le-linux-gnu";
+        case EM_S390:
+            return lib->is_64 ? "s390x-linux-gnu" : "s390-linux-gnu";
+    }
+
+    return NULL;
+}
+
+// whether a directory exists
+int dep_is_dir(const char *path) {
+    struct stat st;
+
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// find out once per file what $LIB is and whether the default search path
+// has multiarch directories: the triplet's directories when this system has
+// them, lib64 or lib otherwise (as on Fedora and RHEL)
+void dep_layout(struct dep_lib *root) {
+    static __thread char lib_dir[64];
+    const char *multiarch = dep_multiarch(root);
+    char path[DEP_PATH_SIZE];
+
+    if(multiarch) {
+        snprintf(path, sizeof(path), "/lib/%s", multiarch);
+
+        if(!dep_is_dir(path)) {
+            snprintf(path, sizeof(path), "/usr/lib/%s", multiarch);
+
+            if(!dep_is_dir(path))
+                multiarch = NULL;
+        }
+    }
+
+    if(multiarch)
+        snprintf(lib_dir, sizeof(lib_dir), "lib/%s", multiarch);
+    else if(root->is_64 && (dep_is_dir("/lib64") || dep_is_dir("/usr/lib64")))
+        snprintf(lib_dir, sizeof(lib_dir), "lib64");
+    else
+        snprintf(lib_dir, sizeof(lib_dir), "lib");
+
+    root->multiarch = multiarch;
+    root->lib_dir = lib_dir;
+}
+
+// expand the $ORIGIN and $LIB (${ORIGIN} and ${LIB} too) of a directory of
+// a search path (returns 0 when it doesn't fit in out)
+int dep_expand(const char *dir, size_t len, const char *origin,
+               struct dep_lib *root, char *out, size_t out_size) {
+    size_t pos = 0;
+
+    for(size_t i = 0; i < len;) {
+        const char *value = NULL;
+        size_t skip = 1;
+
+        if(dir[i] == '$') {
+            const char *token = dir + i + 1;
+            size_t left = len - i - 1;
+            int braces = left && *token == '{';
+
+            if(braces) {
+                token++;
+                left--;
+            }
+
+            if(left >= 6 && !strncmp(token, "ORIGIN", 6) &&
+               (!braces || (left > 6 && token[6] == '}'))) {
+                value = origin;
+                skip = 7 + 2 * braces;
+            } else if(left >= 3 && !strncmp(token, "LIB", 3) &&
+                      (!braces || (left > 3 && token[3] == '}'))) {
+                value = root->lib_dir;
+                skip = 4 + 2 * braces;
+            }
+        }
+
+        if(value) {
+            size_t n = strlen(value);
+
+            if(pos + n >= out_size)
+                return 0;
+
+            memcpy(out + pos, value, n);
+            pos += n;
+        } else {
+            if(pos + 1 >= out_size)
+                return 0;
+
+            out[pos++] = dir[i];
+        }
+
+        i += skip;
+    }
+
+    out[pos] = '\0';
+
+    return 1;
+}
+
+// whether a library can be loaded by the file its search started from
+int dep_compatible(struct dep_lib *lib, struct dep_lib *root) {
+    return lib && lib->state == DEP_LOADED && lib->is_64 == root->is_64 &&
+           lib->data == root->data && lib->machine == root->machine;
+}
+
+// look for a library in a search path ("dir:dir...", with ; too for
+// LD_LIBRARY_PATH), an empty directory is the current one
+struct dep_lib *dep_search(const char *dirs, const char *name,
+                           const char *origin, struct dep_lib *root) {
+    char dir[DEP_PATH_SIZE];
+    char path[DEP_PATH_SIZE];
+
+    while(dirs) {
+        size_t len = strcspn(dirs, ":;");
+        struct dep_lib *lib;
+
+        if(dep_expand(dirs, len, origin, root, dir, sizeof(dir)) &&
+           (size_t) snprintf(path, sizeof(path), "%s/%s", len ? dir : ".",
+                             name) < sizeof(path)) {
+            lib = dep_load(path);
+            if(dep_compatible(lib, root))
+                return lib;
+        }
+
+        dirs = dirs[len] ? dirs + len + 1 : NULL;
+    }
+
+    return NULL;
+}
+
+// a library in the dependency tree of a file
+struct dep_node {
+    struct dep_lib *lib;
+    // the name it was first needed as and where it was found
+    const char *name;
+    const char *found_in;
+    // the node that loaded it (DEP_NONE for the file itself)
+    size_t loader;
+    // the node of each of its needed libraries (DEP_NONE when not found)
+    size_t *deps;
+    // whether the tree under it was displayed
+    int shown;
+};
+
+#define DEP_NONE ((size_t) -1)
+
+// a needed library to find: the node that needs it and its position
+struct dep_request {
+    size_t node;
+    size_t index;
+    struct dep_lib *lib;
+    const char *found_in;
+    // errno when memory ran out looking for it
+    int error;
+};
+
+// what the threads resolving a level of the tree share
+struct dep_level {
+    struct dep_node *nodes;
+    struct dep_request *requests;
+    size_t requests_num;
+    size_t next;
+};
+
+// find a library the way the dynamic linker does: a name with a slash is a
+// path, otherwise DT_RPATH of the loader and of the loaders before it (when
+// the loader has no DT_RUNPATH), LD_LIBRARY_PATH, DT_RUNPATH, ld.so.cache
+// and the default directories (neither with DF_1_NODEFLIB)
+void dep_find(struct dep_node *nodes, struct dep_request *request) {
+    struct dep_lib *loader = nodes[request->node].lib;
+    struct dep_lib *root = nodes[0].lib;
+    const char *name = loader->needed[request->index];
+    const char *env = getenv("LD_LIBRARY_PATH");
+    const char *multiarch = root->multiarch;
+    char path[DEP_PATH_SIZE];
+    struct dep_lib *lib = NULL;
+
+    if(strchr(name, '/')) {
+        if(dep_expand(name, strlen(name), loader->origin, root, path,
+                      sizeof(path))) {
+            lib = dep_load(path);
+            request->found_in = "path";
+        }
+
+        if(lib && !dep_compatible(lib, root))
+            lib = NULL;
+
+        request->lib = lib;
+        return;
+    }
+
+    if(!loader->runpath) {
+        for(size_t n = request->node; n != DEP_NONE && !lib;
+            n = nodes[n].loader) {
+            if(nodes[n].lib->rpath)
+                lib = dep_search(nodes[n].lib->rpath, name,
+                                 nodes[n].lib->origin, root);
+        }
+
+        request->found_in = "rpath";
+    }
+
+    if(!lib && env && *env) {
+        lib = dep_search(env, name, root->origin, root);
+        request->found_in = "LD_LIBRARY_PATH";
+    }
+
+    if(!lib && loader->runpath) {
+        lib = dep_search(loader->runpath, name, loader->origin, root);
+        request->found_in = "runpath";
+    }
+
+    if(!lib && !loader->nodeflib) {
+        pthread_once(&dep_cache_once, dep_cache_load);
+
+        for(size_t i = 0; i < dep_cache_num && !lib; i++) {
+            if(strcmp(dep_cache[i].name, name))
+                continue;
+
+            lib = dep_load(dep_cache[i].path);
+            if(!dep_compatible(lib, root))
+                lib = NULL;
+        }
+
+        request->found_in = "ld.so.cache";
+    }
+
+    if(!lib && !loader->nodeflib) {
+        if(multiarch)
+            snprintf(path, sizeof(path), "/lib/%s:/usr/lib/%s:", multiarch,
+                     multiarch);
+        else
+            path[0] = '\0';
+
+        // /lib64 and /usr/lib64 come first for 64-bit
+        if(root->is_64)
+            strcat(path, "/lib64:/usr/lib64:");
+
+        strcat(path, "/lib:/usr/lib");
+
+        lib = dep_search(path, name, root->origin, root);
+        request->found_in = "default";
+    }
+
+    request->lib = lib;
+}
+
+// resolve the requests of a level until there are none left
+void *dep_worker(void *arg) {
+    struct dep_level *level = arg;
+
+    for(;;) {
+        size_t i = __atomic_fetch_add(&level->next, 1, __ATOMIC_RELAXED);
+
+        if(i >= level->requests_num)
+            break;
+
+        dep_errno = 0;
+        dep_find(level->nodes, &level->requests[i]);
+        level->requests[i].error = dep_errno;
+    }
+
+    return NULL;
+}
+
+// the node of a library that's already loaded under a name (through its
+// needed name or its soname) or that is the same file
+size_t dep_loaded(struct dep_node *nodes, size_t num, const char *name,
+                  struct dep_lib *lib) {
+    for(size_t n = 0; n < num; n++) {
+        if(!strcmp(nodes[n].name, name) ||
+           (nodes[n].lib->soname && !strcmp(nodes[n].lib->soname, name)) ||
+           (lib && nodes[n].lib->dev == lib->dev &&
+            nodes[n].lib->ino == lib->ino))
+            return n;
+    }
+
+    return DEP_NONE;
+}
+
+// number of threads resolving a level of the tree, set in main
+#define DEPS_THREADS_MAX 8
+size_t deps_threads = 1;
+
+// build the dependency tree breadth first, the way the dynamic linker loads
+// the libraries: the libraries of a level are looked for in parallel, then
+// added in order, so the first one to need a library loads it
+struct dep_node *dep_tree(struct dep_lib *root, size_t *nodes_num) {
+    struct dep_node *nodes;
+    size_t num = 1, cap = 16;
+    size_t level_start = 0;
+
+    nodes = calloc(cap, sizeof(*nodes));
+    if(!nodes) {
+        print_error("calloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    // the file itself is shown already
+    nodes[0] = (struct dep_node) {root, "", "file", DEP_NONE, NULL, 1};
+
+    while(level_start < num) {
+        size_t level_end = num;
+        struct dep_level level = {nodes, NULL, 0, 0};
+        size_t cap_requests = 0;
+
+        for(size_t n = level_start; n < level_end; n++) {
+            cap_requests += nodes[n].lib->needed_num;
+
+            nodes[n].deps = malloc((nodes[n].lib->needed_num + 1) *
+                                   sizeof(*nodes[n].deps));
+            if(!nodes[n].deps) {
+                print_error("malloc() failed: %s\n", strerror(errno));
+                fail();
+            }
+        }
+
+        level.requests = malloc((cap_requests + 1) * sizeof(*level.requests));
+        if(!level.requests) {
+            print_error("malloc() failed: %s\n", strerror(errno));
+            fail();
+        }
+
+        // the names already loaded need no search
+        for(size_t n = level_start; n < level_end; n++) {
+            for(size_t k = 0; k < nodes[n].lib->needed_num; k++) {
+                nodes[n].deps[k] = dep_loaded(nodes, level_end,
+                                              nodes[n].lib->needed[k], NULL);
+
+                if(nodes[n].deps[k] == DEP_NONE)
+                    level.requests[level.requests_num++] =
+                        (struct dep_request) {n, k, NULL, NULL, 0};
+            }
+        }
+
+        if(level.requests_num > 1 && deps_threads > 1) {
+            size_t threads_num = level.requests_num < deps_threads ?
+                                 level.requests_num : deps_threads;
+            pthread_t *threads = calloc(threads_num, sizeof(*threads));
+
+            if(!threads) {
+                print_error("calloc() failed: %s\n", strerror(errno));
+                fail();
+            }
+
+            for(size_t t = 0; t < threads_num; t++) {
+                if(pthread_create(&threads[t], NULL, dep_worker, &level) != 0) {
+                    print_error("pthread_create() failed\n");
+                    fail();
+                }
+            }
+
+            for(size_t t = 0; t < threads_num; t++)
+                pthread_join(threads[t], NULL);
+
+            free(threads);
+        } else
+            dep_worker(&level);
+
+        // the helper threads can't fail(), it's done once they're over
+        for(size_t r = 0; r < level.requests_num; r++) {
+            struct dep_request *request = &level.requests[r];
+
+            if(!request->error)
+                continue;
+
+            print_error("Cannot resolve %s: %s\n",
+                        nodes[request->node].lib->needed[request->index],
+                        strerror(request->error));
+
+            for(size_t n = 0; n < num; n++)
+                free(nodes[n].deps);
+
+            free(nodes);
+            free(level.requests);
+            fail();
+        }
+
+        // in order, a library found twice in the level is loaded once
+        for(size_t r = 0; r < level.requests_num; r++) {
+            struct dep_request *request = &level.requests[r];
+            const char *name = nodes[request->node].lib->needed[request->index];
+            size_t n = dep_loaded(nodes, num, name, request->lib);
+
+            if(n == DEP_NONE && request->lib) {
+                if(num == cap) {
+                    cap *= 2;
+
+                    nodes = realloc(nodes, cap * sizeof(*nodes));
+                    if(!nodes) {
+                        print_error("realloc() failed: %s\n", strerror(errno));
+                        fail();
+                    }
+
+                    level.nodes = nodes;
+                }
+
+                nodes[num] = (struct dep_node) {
+                    request->lib, name, request->found_in, request->node, NULL,
+                    0
+                };
+                n = num++;
+            }
+
+            nodes[request->node].deps[request->index] = n;
+        }
+
+        free(level.requests);
+        level_start = level_end;
+    }
+
+    *nodes_num = num;
+
+    return nodes;
+}
+
+// display a needed library and, under the node that loaded it, the ones it
+// needs (it's already loaded everywhere else)
+void show_dep(struct dep_node *nodes, const char *name, size_t n,
+              size_t parent, int depth, size_t *record) {
+    int expand = n != DEP_NONE && nodes[n].loader == parent && !nodes[n].shown;
+    const char *found_in = n == DEP_NONE ? "not found" :
+                           expand ? nodes[n].found_in : "already loaded";
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("deps", (*record)++);
+        json_field_str("name", name);
+        json_field_str("path", n == DEP_NONE ? NULL : nodes[n].lib->path);
+        json_field_str("found_in", found_in);
+        json_field_uint("depth", depth);
+        json_record_end();
+    } else {
+        for(int i = 0; i < depth; i++)
+            out_str("    ");
+
+        out_str(name);
+        out_str(" => ");
+
+        if(!no_color_opt)
+            out_str(C_GREEN);
+
+        out_str(n == DEP_NONE ? "not found" : nodes[n].lib->path);
+
+        if(!no_color_opt)
+            out_str(C_END);
+
+        if(n != DEP_NONE) {
+            out_str(" (");
+            out_str(found_in);
+            out_char(')');
+        }
+
+        out_char('\n');
+    }
+
+    if(!expand)
+        return;
+
+    nodes[n].shown = 1;
+
+    for(size_t k = 0; k < nodes[n].lib->needed_num; k++)
+        show_dep(nodes, nodes[n].lib->needed[k], nodes[n].deps[k], n,
+                 depth + 1, record);
+}
+
+// resolve the libraries an elf needs and the ones they need without running
+// anything (option --deps)
+void show_deps(Elf *elf) {
+    struct dep_lib root = {0};
+    struct dep_node *nodes;
+    size_t nodes_num;
+    size_t record = 0;
+    const unsigned char *buf;
+    size_t size;
+    int parsed;
+
+    buf = (const unsigned char *) elf_rawfile(elf, &size);
+    if(!buf) {
+        print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    parsed = dep_parse(&root, buf, size);
+    if(parsed > 0 && !(root.origin = dep_origin(current_file)))
+        parsed = -1;
+
+    if(parsed < 0) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        dep_free(&root);
+        fail();
+    }
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Dependencies\n");
+
+    // strlen("interpreter")
+    field_max_len = 11;
+
+    json_table_begin("deps");
+
+    // a file without a dynamic segment needs nothing
+    if(parsed) {
+        root.path = current_file;
+        root.state = DEP_LOADED;
+        dep_layout(&root);
+
+        nodes = dep_tree(&root, &nodes_num);
+
+        if(root.interp) {
+            if(output_format != FORMAT_TEXT) {
+                json_record_begin("deps", record++);
+                json_field_str("name", root.interp);
+                json_field_str("path", root.interp);
+                json_field_str("found_in", "interpreter");
+                json_field_uint("depth", 0);
+                json_record_end();
+            } else
+                print_field("interpreter", "%s", root.interp);
+        }
+
+        for(size_t k = 0; k < root.needed_num; k++)
+            show_dep(nodes, root.needed[k], nodes[0].deps[k], 0, 0, &record);
+
+        for(size_t n = 0; n < nodes_num; n++)
+            free(nodes[n].deps);
+
+        free(nodes);
+    }
+
+    if(output_format == FORMAT_TEXT && !root.needed_num)
+        print_field("needed", "none");
+
+    json_table_end();
+
+    dep_free(&root);
+}
+
+// an archive in memory, read without going through the members
+struct ar_image {
+    const char *buf;
+    size_t size;
+
+    // table of the long member names (the // member)
+    const char *names;
+    size_t names_size;
+};
+
+// size of the member whose header is at offset, (size_t) -1 when the header
+// is cut short or broken
+size_t ar_member_size(struct ar_image *image, size_t offset) {
+    const struct ar_hdr *hdr;
+    size_t size = 0;
+
+    if(offset > image->size || image->size - offset < sizeof(*hdr))
+        return -1;
+
+    hdr = (const struct ar_hdr *) (image->buf + offset);
+    if(memcmp(hdr->ar_fmag, ARFMAG, sizeof(hdr->ar_fmag)) != 0)
+        return -1;
+
+    for(size_t i = 0; i < sizeof(hdr->ar_size) && hdr->ar_size[i] != ' '; i++) {
+        if(hdr->ar_size[i] < '0' || hdr->ar_size[i] > '9')
+            return -1;
+
+        size = size * 10 + (hdr->ar_size[i] - '0');
+    }
+
+    if(size > image->size - offset - sizeof(*hdr))
+        return -1;
+
+    return size;
+}
+
+// offset of the header of the member after the one at offset (members start
+// at even offsets)
+size_t ar_next(struct ar_image *image, size_t offset) {
+    size_t next = offset + sizeof(struct ar_hdr) + ar_member_size(image, offset);
+
+    return next + (next & 1);
+}
+
+// whether the member at offset is one of the symbol tables (/ and /SYM64/) or
+// the long names (//) instead of a file
+int ar_special(struct ar_image *image, size_t offset) {
+    const char *name = image->buf + offset;
+
+    return name[0] == '/' && (name[1] == ' ' || name[1] == '/' ||
+                              !strncmp(name, "/SYM64/", 7));
+}
+
+// take an archive from memory and find its long names
+void load_ar_image(struct ar_image *image, const char *buf, size_t size) {
+    size_t offset;
+
+    image->buf = buf;
+    image->size = size;
+    image->names = NULL;
+    image->names_size = 0;
+
+    // the special members come first
+    for(offset = SARMAG; ar_member_size(image, offset) != (size_t) -1 &&
+                         ar_special(image, offset);
+        offset = ar_next(image, offset)) {
+        if(!strncmp(buf + offset, "// ", 3)) {
+            image->names = buf + offset + sizeof(struct ar_hdr);
+            image->names_size = ar_member_size(image, offset);
+        }
+    }
+}
+
+// copy the name of the member at offset in name (size bytes at most)
+void ar_member_name(struct ar_image *image, size_t offset, char *name,
+                    size_t size) {
+    const struct ar_hdr *hdr = (const struct ar_hdr *) (image->buf + offset);
+    const char *start = hdr->ar_name;
+    size_t max = sizeof(hdr->ar_name);
+    size_t len = 0;
+
+    // "/123" is the name at 123 in the long names
+    if(start[0] == '/' && start[1] >= '0' && start[1] <= '9') {
+        size_t pos = 0;
+
+        for(size_t i = 1; i < max && start[i] >= '0' && start[i] <= '9'; i++)
+            pos = pos * 10 + (start[i] - '0');
+
+        if(!image->names || pos >= image->names_size) {
+            snprintf(name, size, "%.*s", (int) max, start);
+            return;
+        }
+
+        start = image->names + pos;
+        max = image->names_size - pos;
+    }
+
+    // gnu names end with a slash
+    while(len < max && start[len] != '/' && start[len] != '\n')
+        len++;
+
+    snprintf(name, size, "%.*s", (int) len, start);
+}
+
+// display the archive symbol table (option --archive-index)
+void show_archive_index(Elf *archive) {
+    struct ar_image image;
+    Elf_Arsym *arsym;
+    size_t num = 0;
+    const char *buf;
+    size_t size;
+
+    buf = elf_rawfile(archive, &size);
+    if(!buf) {
+        print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    load_ar_image(&image, buf, size);
+
+    // an archive without symbol table has none
+    arsym = elf_getarsym(archive, &num);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("Archive Index\n");
+
+    // strlen("as_name")
+    field_max_len = 7;
+
+    json_table_begin("archive_index");
+
+    // the last entry only marks the end of the table
+    for(size_t i = 0; arsym && i + 1 < num; i++) {
+        char member[256] = "";
+
+        if(ar_member_size(&image, arsym[i].as_off) != (size_t) -1)
+            ar_member_name(&image, arsym[i].as_off, member, sizeof(member));
+
+        if(output_format != FORMAT_TEXT) {
+            json_record_begin("archive_index", i);
+            json_field_str("name", arsym[i].as_name);
+            json_field_uint("offset", arsym[i].as_off);
+            json_field_str("member", member);
+            json_field_uint("hash", arsym[i].as_hash);
+            json_record_end();
+            continue;
+        }
+
+        if(i)
+            out_char('\n');
+
+        print_title_index("Elf_Arsym", i);
+
+        print_field("as_name", "%s", arsym[i].as_name);
+
+        print_field("as_off", NULL);
+        print_value_hex(arsym[i].as_off);
+        print_name_info(member);
+
+        print_field_hex("as_hash", arsym[i].as_hash);
+    }
+
+    json_table_end();
+}
+
+// print the empty line between two tables (text output only)
+void print_separator(void) {
+    if(output_format == FORMAT_TEXT)
+        out_char('\n');
+}
+
+// display the help message
+void usage(FILE *stream) {
+    fprintf(stream,
+            "Usage: elfy [options] FILE...\n\n"
+            "Options:\n"
+            "  -h, --file-header      display the ELF file header\n"
+            "  -p, --program-headers  display the program headers\n"
+            "  -s, --section-headers  display the section headers\n"
+            "  -d, --dynamic          display the dynamic section\n"
+            "  --symtab               display the symbol table\n"
+            "  --dyn-syms             display the dynamic symbol table\n"
+            "  --sym-type=TYPE,...    only the symbols of these types (e.g. FUNC)\n"
+            "  --sym-bind=BIND,...    only the symbols of these bindings (e.g. GLOBAL)\n"
+            "  --sym-visibility=VIS,...\n"
+            "                         only the symbols of these visibilities\n"
+            "  --sym-section=[!]SECTION,...\n"
+            "                         only the symbols of (or not of) these sections\n"
+            "  --sym-name=PATTERN     only the symbols whose name matches a shell pattern\n"
+            "  --sym-regex=REGEX      only the symbols whose name matches a regex\n"
+            "  --sym-value=MIN:MAX    only the symbols whose value is in the range\n"
+            "  --sym-size=MIN:MAX     only the symbols whose size is in the range\n"
+            "  --fields=FIELD,...     symbol fields to display (name, type, bind,\n"
+            "                         visibility, section, value, size)\n"
+            "  --top=N                display the N largest symbols and sections\n"
+            "  --by=KEY               what --top ranks by: size (the default)\n"
+            "  --relocs               display the relocation entries\n"
+            "  --reloc-summary        count the relocation entries per type\n"
+            "  --relr                 display the RELR packed relocations\n"
+            "  --lookup=NAME          find a dynamic symbol through the hash table\n"
+            "  --hash-stats           display how well the hash tables are sized\n"
+            "  --compression          display the sizes of the compressed sections\n"
+            "  --size-report          attribute the bytes of the file and of memory to\n"
+            "                         segments, sections and symbols\n"
+            "  --hex-dump=SECTION     dump the contents of a section (name or index)\n"
+            "  --notes                display the notes\n"
+            "  --build-id             display the build id\n"
+            "  --deps                 resolve the needed libraries like the dynamic\n"
+            "                         linker, without running the file\n"
+            "  --addr2sym FILE [ADDR...]\n"
+            "                         resolve hex addresses to symbol+offset\n"
+            "                         (reads them from stdin when none given)\n"
+            "  --archive-index        display the symbol index of an archive\n"
+            "  --diff OLD NEW         compare two files table by table\n"
+            "  -a, --all              equivalent to -h -p -s -d --symtab --dyn-syms\n"
+            "  --no-color             disable colored output\n"
+            "  --no-mmap              read the file instead of mapping it\n"
+            "  --stats                display where the time and memory went on stderr\n"
+            "  --cache=DIR            keep the output of each file in DIR and reuse it\n"
+            "  --format=FORMAT        output format: text, json or ndjson\n"
+            "  -j, --jobs=N           display up to N files at the same time\n"
+            "  @LIST                  read file names from LIST (@- for stdin)\n"
+            "  -                      read the ELF file from stdin\n"
+            "  -r, --recursive=DIR    display every ELF file under DIR\n"
+            "  --help                 display this information\n"
+            "  --version              display the version number of elfy\n\n"
+            "Report bugs to <https://github.com/xfgusta/elfy/issues>\n");
+}
+
+// display the requested tables of an elf
+void show_elf(Elf *elf) {
+    int is_first = 1;
+
+    if(all_opt) {
+        stats_enter(STATS_FILE_HEADER);
+        show_file_header(elf);
+        print_separator();
+
+        stats_enter(STATS_PROGRAM_HEADERS);
+        show_program_headers(elf);
+        print_separator();
+
+        stats_enter(STATS_SECTION_HEADERS);
+        show_section_headers(elf);
+        print_separator();
+
+        stats_enter(STATS_DYNAMIC_SECTION);
+        show_dynamic_section(elf);
+        print_separator();
+
+        stats_enter(STATS_SYMTAB);
+        show_symtab(elf);
+        print_separator();
+
+        stats_enter(STATS_DYNAMIC_SYMTAB);
+        show_dynamic_symtab(elf);
+    } else {
+        if(file_header_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_FILE_HEADER);
+            show_file_header(elf);
+            is_first = 0;
+        }
+
+        if(program_headers_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_PROGRAM_HEADERS);
+            show_program_headers(elf);
+            is_first = 0;
+        }
+
+        if(section_headers_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_SECTION_HEADERS);
+            show_section_headers(elf);
+            is_first = 0;
+        }
+
+        if(dynamic_section_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_DYNAMIC_SECTION);
+            show_dynamic_section(elf);
+            is_first = 0;
+        }
+
+        if(symtab_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_SYMTAB);
+            show_symtab(elf);
+            is_first = 0;
+        }
+
+        if(dynamic_symtab_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_DYNAMIC_SYMTAB);
+            show_dynamic_symtab(elf);
+            is_first = 0;
+        }
+
+        if(relocs_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_RELOCS);
+            show_relocs(elf);
+            is_first = 0;
+        }
+
+        if(reloc_summary_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_RELOC_SUMMARY);
+            show_reloc_summary(elf);
+            is_first = 0;
+        }
+
+        if(relr_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_RELR);
+            show_relr(elf);
+            is_first = 0;
+        }
+
+        if(lookup_names_num) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_LOOKUP);
+            show_lookup(elf);
+            is_first = 0;
+        }
+
+        if(hash_stats_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_HASH_TABLE_STATS);
+            show_hash_table_stats(elf);
+            is_first = 0;
+        }
+
+        if(compression_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_COMPRESSION);
+            show_compression(elf);
+            is_first = 0;
+        }
+
+        if(hex_dump_sections_num) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_HEX_DUMP);
+            show_hex_dump(elf);
+            is_first = 0;
+        }
+
+        // with --size-report, --top is the number of symbols per section
+        if(top_opt && !size_report_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_TOP);
+            show_top(elf);
+            is_first = 0;
+        }
+
+        if(size_report_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_SIZE_REPORT);
+            show_size_report(elf);
+            is_first = 0;
+        }
+
+        if(notes_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_NOTES);
+            show_notes(elf);
+            is_first = 0;
+        }
+
+        if(build_id_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_BUILD_ID);
+            show_elf_build_id(elf);
+            is_first = 0;
+        }
+
+        if(deps_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_DEPS);
+            show_deps(elf);
+            is_first = 0;
+        }
+
+        if(addr2sym_opt) {
+            if(!is_first)
+                print_separator();
+
+            stats_enter(STATS_ADDR2SYM);
+            show_addr2sym(elf);
+        }
+    }
+
+    stats_enter(STATS_OTHER);
+}
+
+// whether anything but the build id is displayed for the elf files themselves
+// (every option but --archive-index and --build-id)
+int elf_tables_requested(void) {
+    return file_header_opt || program_headers_opt || section_headers_opt ||
+           dynamic_section_opt || symtab_opt || dynamic_symtab_opt ||
+           relocs_opt || reloc_summary_opt || relr_opt || lookup_names_num ||
+           hash_stats_opt || compression_opt || hex_dump_sections_num ||
+           top_opt || size_report_opt || notes_opt || deps_opt ||
+           addr2sym_opt || all_opt;
+}
+
+// whether only the elf header and the program and section header tables are
+// needed (options -h and -p)
+int headers_only(void) {
+    return !(all_opt || section_headers_opt || dynamic_section_opt ||
+             symtab_opt || dynamic_symtab_opt || relocs_opt ||
+             reloc_summary_opt || relr_opt || lookup_names_num ||
+             hash_stats_opt || compression_opt || hex_dump_sections_num ||
+             top_opt || size_report_opt || notes_opt || build_id_opt ||
+             deps_opt || addr2sym_opt);
+}
+
+// a part of a streamed file to keep
+struct stream_range {
+    uint64_t start;
+    uint64_t end;
+};
+
+// find where the header tables of a streamed file are (returns 0 when it
+// isn't an elf)
+int stream_ranges(const unsigned char *ident, size_t len,
+                  struct stream_range ranges[3]) {
+    uint64_t phoff, shoff;
+    uint16_t ehsize, phentsize, phnum, shentsize, shnum;
+    int swap;
+
+    if(len < EI_NIDENT || memcmp(ident, ELFMAG, SELFMAG) != 0)
+        return 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    swap = ident[EI_DATA] == ELFDATA2MSB;
+#else
+    swap = ident[EI_DATA] == ELFDATA2LSB;
+#endif
+
+    if(ident[EI_CLASS] == ELFCLASS64 && len >= sizeof(Elf64_Ehdr)) {
+        Elf64_Ehdr ehdr;
+
+        memcpy(&ehdr, ident, sizeof(ehdr));
+        phoff = swap ? __builtin_bswap64(ehdr.e_phoff) : ehdr.e_phoff;
+        shoff = swap ? __builtin_bswap64(ehdr.e_shoff) : ehdr.e_shoff;
+        ehsize = ehdr.e_ehsize;
+        phentsize = ehdr.e_phentsize;
+        phnum = ehdr.e_phnum;
+        shentsize = ehdr.e_shentsize;
+        shnum = ehdr.e_shnum;
+    } else if(ident[EI_CLASS] == ELFCLASS32 && len >= sizeof(Elf32_Ehdr)) {
+        Elf32_Ehdr ehdr;
+
+        memcpy(&ehdr, ident, sizeof(ehdr));
+        phoff = swap ? __builtin_bswap32(ehdr.e_phoff) : ehdr.e_phoff;
+        shoff = swap ? __builtin_bswap32(ehdr.e_shoff) : ehdr.e_shoff;
+        ehsize = ehdr.e_ehsize;
+        phentsize = ehdr.e_phentsize;
+        phnum = ehdr.e_phnum;
+        shentsize = ehdr.e_shentsize;
+        shnum = ehdr.e_shnum;
+    } else
+        return 0;
+
+    if(swap) {
+        ehsize = __builtin_bswap16(ehsize);
+        phentsize = __builtin_bswap16(phentsize);
+        phnum = __builtin_bswap16(phnum);
+        shentsize = __builtin_bswap16(shentsize);
+        shnum = __builtin_bswap16(shnum);
+    }
+
+    ranges[0].start = 0;
+    ranges[0].end = ehsize;
+
+    ranges[1].start = phoff;
+    ranges[1].end = phoff + (uint64_t) phentsize * phnum;
+
+    // with more sections than e_shnum holds, the first header has the count
+    ranges[2].start = shoff;
+    ranges[2].end = shoff + (uint64_t) shentsize * (shoff && !shnum ? 1 : shnum);
+
+    return 1;
+}
+
+// read everything the stream has to give, returns the number of bytes read
+size_t stream_read(int fd, unsigned char *buf, size_t size) {
+    size_t len = 0;
+
+    while(len < size) {
+        ssize_t n = read(fd, buf + len, size - len);
+
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n < 0) {
+            print_error("read() failed: %s\n", strerror(errno));
+            fail();
+        }
+
+        if(n == 0)
+            break;
+
+        len += n;
+    }
+
+    return len;
+}
+
+// write a part of the stream at its offset in the copy
+void stream_write(int fd, const unsigned char *buf, size_t len, uint64_t offset) {
+    while(len) {
+        ssize_t n = pwrite(fd, buf, len, offset);
+
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n < 0) {
+            print_error("pwrite() failed: %s\n", strerror(errno));
+            fail();
+        }
+
+        buf += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+// copy a stream (a pipe, a socket...) into an unlinked temporary file that
+// can be mapped like a regular one (its descriptor goes in *out). When only
+// the header tables are needed, everything else is read and dropped: it's
+// left as holes that take neither memory nor disk space, and reading stops
+// after the last table
+void stream_file(int in, volatile int *out) {
+    unsigned char buf[1 << 16];
+    struct stream_range ranges[3];
+    const char *tmpdir = getenv("TMPDIR");
+    char path[4096];
+    int keep_all = !headers_only();
+    uint64_t end = 0;
+    uint64_t pos;
+    size_t len;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/elfy.XXXXXX",
+             tmpdir && *tmpdir ? tmpdir : "/tmp");
+
+    fd = mkstemp(path);
+    if(fd < 0) {
+        print_error("mkstemp() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    unlink(path);
+    *out = fd;
+
+    // the elf header tells where the header tables are
+    len = stream_read(in, buf, sizeof(Elf64_Ehdr));
+    stream_write(fd, buf, len, 0);
+    pos = len;
+
+    // the members of an archive are all over it
+    if(len >= SARMAG && !memcmp(buf, ARMAG, SARMAG))
+        keep_all = 1;
+
+    if(!keep_all) {
+        if(!stream_ranges(buf, len, ranges)) {
+            // not an elf, there is nothing more to look at
+            ranges[0].start = ranges[0].end = 0;
+            ranges[1] = ranges[2] = ranges[0];
+        }
+
+        for(int i = 0; i < 3; i++) {
+            if(ranges[i].end > end)
+                end = ranges[i].end;
+        }
+    }
+
+    while(keep_all || pos < end) {
+        len = stream_read(in, buf, sizeof(buf));
+        if(len == 0)
+            break;
+
+        if(keep_all)
+            stream_write(fd, buf, len, pos);
+        else {
+            for(int i = 0; i < 3; i++) {
+                uint64_t start = ranges[i].start > pos ? ranges[i].start : pos;
+                uint64_t stop = ranges[i].end < pos + len ? ranges[i].end :
+                                pos + len;
+
+                if(start < stop)
+                    stream_write(fd, buf + (start - pos), stop - start, start);
+            }
+        }
+
+        pos += len;
+    }
+
+    // the holes up to the last table read as zeros
+    if(ftruncate(fd, !keep_all && end < pos ? end : pos) != 0) {
+        print_error("ftruncate() failed: %s\n", strerror(errno));
+        fail();
+    }
+}
+
+// display an elf of the current job (a file or a member of an archive)
+void display_elf(Elf *elf, char *filename) {
+    // everything goes into a single object
+    if(output_format == FORMAT_JSON)
+        json_file_open(filename);
+
+    show_elf(elf);
+
+    if(output_format == FORMAT_JSON)
+        json_file_close();
+}
+
+// same as display_elf but for the build id found by read_build_id
+void display_build_id(const char *id, char *filename) {
+    if(output_format == FORMAT_JSON)
+        json_file_open(filename);
+
+    show_build_id(id);
+
+    if(output_format == FORMAT_JSON)
+        json_file_close();
+}
+
+// open the member of an archive whose header is at offset
+Elf *open_member(Elf *archive, int fd, size_t offset) {
+    Elf *member;
+
+    if(elf_rand(archive, offset) != offset) {
+        print_error("elf_rand() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    if(file_map)
+        member = elf_begin(-1, ELF_C_READ_MMAP, archive);
+    else
+        member = elf_begin(fd, ELF_C_READ, archive);
+
+    if(!member) {
+        print_error("elf_begin() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    file_base = elf_getbase(member);
+
+    return member;
+}
+
+// the old and the new file given to --diff
+char **diff_files = NULL;
+
+// a file given to --diff, with its own section table
+struct diff_file {
+    char *filename;
+    int fd;
+    char *map;
+    size_t size;
+    Elf *elf;
+    GElf_Ehdr ehdr;
+    struct section *sections;
+    size_t sections_num;
+};
+
+// make a file given to --diff the current elf of the dumpers
+void diff_use(struct diff_file *file) {
+    sections = file->sections;
+    sections_num = file->sections_num;
+    file_map = file->map;
+    file_size = file->size;
+}
+
+// open a file given to --diff and read its section table
+void diff_open(struct diff_file *file, char *filename) {
+    struct stat st;
+
+    memset(file, 0, sizeof(*file));
+    file->filename = filename;
+
+    file->fd = open(filename, O_RDONLY);
+    if(file->fd < 0) {
+        print_error("Cannot open %s failed: %s\n", filename, strerror(errno));
+        fail();
+    }
+
+    if(!no_mmap_opt && fstat(file->fd, &st) == 0 && S_ISREG(st.st_mode) &&
+       st.st_size > 0) {
+        file->size = st.st_size;
+        file->map = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, file->fd,
+                         0);
+        if(file->map == MAP_FAILED)
+            file->map = NULL;
+        else if(stats_opt)
+            __atomic_fetch_add(&stats_mapped_bytes, file->size,
+                               __ATOMIC_RELAXED);
+    }
+
+    if(file->map) {
+        madvise(file->map, file->size, MADV_RANDOM);
+        file->elf = elf_memory(file->map, file->size);
+    } else
+        file->elf = elf_begin(file->fd, ELF_C_READ, NULL);
+
+    if(!file->elf) {
+        print_error("elf_begin() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    if(elf_kind(file->elf) != ELF_K_ELF) {
+        print_error("%s is not an ELF object\n", filename);
+        fail();
+    }
+
+    if(!gelf_getehdr(file->elf, &file->ehdr)) {
+        print_error("gelf_getehdr() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    if(!file->map && !elf_rawfile(file->elf, &file->size)) {
+        print_error("elf_rawfile() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
+
+    // load_sections fills the table of the current elf, keep it here
+    sections = NULL;
+    sections_num = 0;
+    load_sections(file->elf);
+
+    file->sections = sections;
+    file->sections_num = sections_num;
+    sections = NULL;
+    sections_num = 0;
+}
+
+void diff_close(struct diff_file *file) {
+    diff_use(file);
+    free_sections();
+    file_map = NULL;
+    file_size = 0;
+
+    elf_end(file->elf);
+
+    if(file->map)
+        munmap(file->map, file->size);
+
+    close(file->fd);
+}
+
+// an entry of a table compared by --diff, matched by name
+struct diff_entry {
+    const char *name;
+    uint32_t hash;
+    uint64_t value;
+    size_t index;
+};
+
+// the entries of a table in both files and how they match: match[i] is the
+// old entry of the i-th new one (DIFF_ADDED when there's none) and matched[i]
+// whether the i-th old one has a new one
+struct diff_table {
+    struct diff_entry *old;
+    size_t old_num;
+    size_t old_cap;
+    struct diff_entry *new;
+    size_t new_num;
+    size_t new_cap;
+    size_t *match;
+    unsigned char *matched;
+
+    // the names are allocated (freed by free_diff_table)
+    int own_names;
+};
+
+#define DIFF_ADDED ((size_t) -1)
+
+void diff_add(struct diff_entry **entries, size_t *num, size_t *cap,
+              const char *name, uint64_t value, size_t index) {
+    if(*num == *cap) {
+        *cap = *cap ? *cap * 2 : 64;
+
+        *entries = realloc(*entries, *cap * sizeof(**entries));
+        if(!*entries) {
+            print_error("realloc() failed: %s\n", strerror(errno));
+            fail();
+        }
+    }
+
+    (*entries)[(*num)++] = (struct diff_entry) {
+        name, gnu_hash(name), value, index
+    };
+}
+
+void free_diff_table(struct diff_table *table) {
+    if(table->own_names) {
+        for(size_t i = 0; i < table->old_num; i++)
+            free((char *) table->old[i].name);
+
+        for(size_t i = 0; i < table->new_num; i++)
+            free((char *) table->new[i].name);
+    }
+
+    free(table->old);
+    free(table->new);
+    free(table->match);
+    free(table->matched);
+    memset(table, 0, sizeof(*table));
+}
+
+// match the entries by name with a hash join: the old names go into an open
+// addressing table (the entries of a name are chained in order), then each
+// new entry takes the first old one of its name that isn't taken yet
+void diff_join(struct diff_table *table) {
+    size_t slots_num = 16;
+    size_t mask;
+    size_t *names;
+    size_t *cursors;
+    size_t *next;
+
+    while(slots_num < table->old_num * 2)
+        slots_num *= 2;
+
+    mask = slots_num - 1;
+
+    // names[s] is the first old entry of a name (+ 1, 0 for an empty slot)
+    // and cursors[s] the first one left
+    names = calloc(slots_num, sizeof(*names));
+    cursors = calloc(slots_num, sizeof(*cursors));
+    next = malloc((table->old_num + 1) * sizeof(*next));
+    table->match = malloc((table->new_num + 1) * sizeof(*table->match));
+    table->matched = calloc(table->old_num + 1, 1);
+    if(!names || !cursors || !next || !table->match || !table->matched) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    // in reverse, so each chain starts with the first entry of its name
+    for(size_t i = table->old_num; i-- > 0;) {
+        struct diff_entry *entry = &table->old[i];
+        size_t s = entry->hash & mask;
+
+        while(names[s] && (table->old[names[s] - 1].hash != entry->hash ||
+                           strcmp(table->old[names[s] - 1].name, entry->name)))
+            s = (s + 1) & mask;
+
+        next[i] = cursors[s];
+        names[s] = i + 1;
+        cursors[s] = i + 1;
+    }
+
+    for(size_t j = 0; j < table->new_num; j++) {
+        struct diff_entry *entry = &table->new[j];
+        size_t s = entry->hash & mask;
+
+        table->match[j] = DIFF_ADDED;
+
+        while(names[s] && (table->old[names[s] - 1].hash != entry->hash ||
+                           strcmp(table->old[names[s] - 1].name, entry->name)))
+            s = (s + 1) & mask;
+
+        if(cursors[s]) {
+            size_t i = cursors[s] - 1;
+
+            table->match[j] = i;
+            table->matched[i] = 1;
+            cursors[s] = next[i];
+        }
+    }
+
+    free(names);
+    free(cursors);
+    free(next);
+}
+
+// how a table of --diff is displayed
+struct diff_kind {
+    // json table and text title
+    const char *table;
+    const char *title;
+    // title of an entry (e.g. Elf_Sym)
+    const char *entry;
+    // whether the values are sizes (summed, with a delta) or just values
+    int is_size;
+};
+
+// display an entry that was added, removed or changed
+void show_diff_entry(const struct diff_kind *kind, const char *change,
+                     struct diff_entry *old, struct diff_entry *new,
+                     size_t *record) {
+    struct diff_entry *entry = new ? new : old;
+    const char *old_field = kind->is_size ? "old_size" : "old_value";
+    const char *new_field = kind->is_size ? "new_size" : "new_value";
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin(kind->table, (*record)++);
+        json_field_str("name", entry->name);
+        json_field_str("change", change);
+
+        if(old) {
+            json_field_uint("old_index", old->index);
+            json_field_uint(old_field, old->value);
+        }
+
+        if(new) {
+            json_field_uint("new_index", new->index);
+            json_field_uint(new_field, new->value);
+        }
+
+        if(kind->is_size)
+            json_field_int("delta", (new ? new->value : 0) -
+                                    (old ? old->value : 0));
+
+        json_record_end();
+        return;
+    }
+
+    if((*record)++)
+        out_char('\n');
+
+    print_title_index(kind->entry, entry->index);
+    print_field("name", "%s", entry->name);
+    print_field("change", "%s", change);
+
+    if(kind->is_size) {
+        if(old)
+            print_field_dec(old_field, old->value);
+
+        if(new)
+            print_field_dec(new_field, new->value);
+
+        print_field("delta", "%+ld", (long) ((new ? new->value : 0) -
+                                             (old ? old->value : 0)));
+    } else {
+        if(old)
+            print_field_hex(old_field, old->value);
+
+        if(new)
+            print_field_hex(new_field, new->value);
+    }
+}
+
+// display the entries added, removed and changed (resized for sizes), then
+// the totals
+void show_diff_table(const struct diff_kind *kind, struct diff_table *table) {
+    size_t added = 0, removed = 0, changed = 0;
+    uint64_t old_total = 0, new_total = 0;
+    size_t record = 0;
+
+    diff_join(table);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("%s\n", kind->title);
+
+    // strlen("old_entries")
+    field_max_len = 11;
+
+    json_table_begin(kind->table);
+
+    for(size_t j = 0; j < table->new_num; j++) {
+        struct diff_entry *new = &table->new[j];
+        size_t i = table->match[j];
+
+        new_total += new->value;
+
+        if(i == DIFF_ADDED) {
+            added++;
+            show_diff_entry(kind, "added", NULL, new, &record);
+        } else if(table->old[i].value != new->value) {
+            changed++;
+            show_diff_entry(kind, kind->is_size ? "resized" : "changed",
+                            &table->old[i], new, &record);
+        }
+    }
+
+    for(size_t i = 0; i < table->old_num; i++) {
+        old_total += table->old[i].value;
+
+        if(!table->matched[i]) {
+            removed++;
+            show_diff_entry(kind, "removed", &table->old[i], NULL, &record);
+        }
+    }
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin(kind->table, record);
+        json_field_str("change", "total");
+        json_field_uint("old_entries", table->old_num);
+        json_field_uint("new_entries", table->new_num);
+        json_field_uint("added", added);
+        json_field_uint("removed", removed);
+        json_field_uint(kind->is_size ? "resized" : "changed", changed);
+
+        if(kind->is_size) {
+            json_field_uint("old_size", old_total);
+            json_field_uint("new_size", new_total);
+            json_field_int("delta", new_total - old_total);
+        }
+
+        json_record_end();
+    } else {
+        if(record)
+            out_char('\n');
+
+        print_title("Total");
+        print_field_dec("old_entries", table->old_num);
+        print_field_dec("new_entries", table->new_num);
+        print_field_dec("added", added);
+        print_field_dec("removed", removed);
+        print_field_dec(kind->is_size ? "resized" : "changed", changed);
+
+        if(kind->is_size) {
+            print_field_dec("old_size", old_total);
+            print_field_dec("new_size", new_total);
+            print_field("delta", "%+ld", (long) (new_total - old_total));
+        }
+    }
+
+    json_table_end();
+}
+
+// a field of two entries compared by --diff
+struct diff_field {
+    const char *name;
+    uint64_t old;
+    uint64_t new;
+    int is_hex;
+};
+
+int diff_fields_differ(struct diff_field *fields, size_t num) {
+    for(size_t i = 0; i < num; i++) {
+        if(fields[i].old != fields[i].new)
+            return 1;
+    }
+
+    return 0;
+}
+
+// display the fields that differ: "old -> new" in text, old_<name> and
+// new_<name> members in json
+void show_diff_fields(struct diff_field *fields, size_t num) {
+    for(size_t i = 0; i < num; i++) {
+        struct diff_field *field = &fields[i];
+        char key[64];
+
+        if(field->old == field->new)
+            continue;
+
+        if(output_format != FORMAT_TEXT) {
+            snprintf(key, sizeof(key), "old_%s", field->name);
+            json_field_uint(key, field->old);
+            snprintf(key, sizeof(key), "new_%s", field->name);
+            json_field_uint(key, field->new);
+            continue;
+        }
+
+        print_field(field->name, NULL);
+
+        if(field->is_hex) {
+            print_value_hex(field->old);
+            out_str(" -> ");
+            print_value_hex(field->new);
+        } else {
+            print_value_dec(field->old);
+            out_str(" -> ");
+            print_value_dec(field->new);
+        }
+
+        out_char('\n');
+    }
+}
+
+void diff_file_header(struct diff_file *old, struct diff_file *new) {
+    GElf_Ehdr *a = &old->ehdr, *b = &new->ehdr;
+    struct diff_field fields[] = {
+        {"file_size", old->size, new->size, 0},
+        {"ei_class", a->e_ident[EI_CLASS], b->e_ident[EI_CLASS], 0},
+        {"ei_data", a->e_ident[EI_DATA], b->e_ident[EI_DATA], 0},
+        {"ei_osabi", a->e_ident[EI_OSABI], b->e_ident[EI_OSABI], 0},
+        {"e_type", a->e_type, b->e_type, 0},
+        {"e_machine", a->e_machine, b->e_machine, 0},
+        {"e_version", a->e_version, b->e_version, 0},
+        {"e_entry", a->e_entry, b->e_entry, 1},
+        {"e_phoff", a->e_phoff, b->e_phoff, 1},
+        {"e_shoff", a->e_shoff, b->e_shoff, 1},
+        {"e_flags", a->e_flags, b->e_flags, 1},
+        {"e_phnum", a->e_phnum, b->e_phnum, 0},
+        {"e_shnum", old->sections_num, new->sections_num, 0},
+        {"e_shstrndx", a->e_shstrndx, b->e_shstrndx, 0}
+    };
+    size_t num = sizeof(fields) / sizeof(fields[0]);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("File Header\n");
+
+    // strlen("e_shstrndx")
+    field_max_len = 10;
+
+    json_table_begin("diff_file_header");
+
+    if(output_format != FORMAT_TEXT) {
+        json_record_begin("diff_file_header", NO_INDEX);
+        json_field_str("change", diff_fields_differ(fields, num) ?
+                                 "changed" : "none");
+    } else if(!diff_fields_differ(fields, num))
+        print_field("change", "none");
+
+    show_diff_fields(fields, num);
+
+    if(output_format != FORMAT_TEXT)
+        json_record_end();
+
+    json_table_end();
+}
+
+// the segments are matched by type, in order
+void diff_program_headers(struct diff_file *old, struct diff_file *new) {
+    const struct diff_kind kind = {
+        "diff_program_headers", "Program Headers", "Elf_Phdr", 1
+    };
+    struct diff_table table = {0};
+    struct diff_file *files[2] = {old, new};
+    size_t record = 0;
+
+    for(int f = 0; f < 2; f++) {
+        size_t phnum;
+
+        if(elf_getphdrnum(files[f]->elf, &phnum) != 0) {
+            print_error("elf_getphdrnum() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        for(size_t i = 0; i < phnum; i++) {
+            GElf_Phdr phdr;
+            const char *name;
+
+            if(!gelf_getphdr(files[f]->elf, i, &phdr)) {
+                print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+                fail();
+            }
+
+            name = elf_name_str(&pt_names, phdr.p_type);
+            if(!name)
+                name = "unknown";
+
+            if(f == 0)
+                diff_add(&table.old, &table.old_num, &table.old_cap, name,
+                         phdr.p_memsz, i);
+            else
+                diff_add(&table.new, &table.new_num, &table.new_cap, name,
+                         phdr.p_memsz, i);
+        }
+    }
+
+    diff_join(&table);
+
+    if(output_format == FORMAT_TEXT)
+        print_title("%s\n", kind.title);
+
+    // strlen("old_entries")
+    field_max_len = 11;
+
+    json_table_begin(kind.table);
+
+    // the segments in both files whose fields differ
+    for(size_t j = 0; j < table.new_num; j++) {
+        size_t i = table.match[j];
+        GElf_Phdr a, b;
+
+        if(i == DIFF_ADDED) {
+            show_diff_entry(&kind, "added", NULL, &table.new[j], &record);
+            continue;
+        }
+
+        if(!gelf_getphdr(old->elf, table.old[i].index, &a) ||
+           !gelf_getphdr(new->elf, table.new[j].index, &b)) {
+            print_error("gelf_getphdr() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        {
+            struct diff_field fields[] = {
+                {"p_flags", a.p_flags, b.p_flags, 1},
+                {"p_offset", a.p_offset, b.p_offset, 1},
+                {"p_vaddr", a.p_vaddr, b.p_vaddr, 1},
+                {"p_paddr", a.p_paddr, b.p_paddr, 1},
+                {"p_filesz", a.p_filesz, b.p_filesz, 0},
+                {"p_memsz", a.p_memsz, b.p_memsz, 0},
+                {"p_align", a.p_align, b.p_align, 1}
+            };
+            size_t num = sizeof(fields) / sizeof(fields[0]);
+
+            if(!diff_fields_differ(fields, num))
+                continue;
+
+            if(output_format != FORMAT_TEXT) {
+                json_record_begin(kind.table, record++);
+                json_field_str("name", table.new[j].name);
+                json_field_str("change", "changed");
+                json_field_uint("old_index", table.old[i].index);
+                json_field_uint("new_index", table.new[j].index);
+            } else {
+                if(record++)
+                    out_char('\n');
+
+                print_title_index(kind.entry, table.new[j].index);
+                print_field("name", "%s", table.new[j].name);
+                print_field("change", "changed");
+            }
+
+            show_diff_fields(fields, num);
+
+            if(output_format != FORMAT_TEXT)
+                json_record_end();
+        }
+    }
+
+    for(size_t i = 0; i < table.old_num; i++) {
+        if(!table.matched[i])
+            show_diff_entry(&kind, "removed", &table.old[i], NULL, &record);
+    }
+
+    if(output_format == FORMAT_TEXT && !record)
+        print_field("change", "none");
+
+    json_table_end();
+
+    free_diff_table(&table);
+}
+
+void diff_section_headers(struct diff_file *old, struct diff_file *new) {
+    const struct diff_kind kind = {
+        "diff_section_headers", "Section Headers", "Elf_Shdr", 1
+    };
+    struct diff_table table = {0};
+
+    for(size_t j = 1; j < old->sections_num; j++) {
+        if(old->sections[j].name)
+            diff_add(&table.old, &table.old_num, &table.old_cap,
+                     old->sections[j].name, old->sections[j].shdr.sh_size, j);
+    }
+
+    for(size_t j = 1; j < new->sections_num; j++) {
+        if(new->sections[j].name)
+            diff_add(&table.new, &table.new_num, &table.new_cap,
+                     new->sections[j].name, new->sections[j].shdr.sh_size, j);
+    }
+
+    show_diff_table(&kind, &table);
+    free_diff_table(&table);
+}
+
+// whether the value of a dynamic entry is a string of the dynamic strtab
+int dyn_is_string(GElf_Sxword tag) {
+    return tag == DT_NEEDED || tag == DT_SONAME || tag == DT_RPATH ||
+           tag == DT_RUNPATH || tag == DT_AUXILIARY || tag == DT_FILTER;
+}
+
+// add the dynamic entries of a file: the strings are part of the name (e.g.
+// "DT_NEEDED libc.so.6") so they're matched as they are, the others are
+// matched by tag and compared by value
+void diff_add_dynamic(struct diff_file *file, struct diff_entry **entries,
+                      size_t *num, size_t *cap) {
+    size_t sh_entsize = gelf_fsize(file->elf, ELF_T_DYN, 1, EV_CURRENT);
+
+    for(size_t j = 1; j < file->sections_num; j++) {
+        GElf_Shdr *shdr = &file->sections[j].shdr;
+        Elf_Data *data;
+
+        if(shdr->sh_type != SHT_DYNAMIC)
+            continue;
+
+        data = elf_getdata(file->sections[j].scn, NULL);
+        if(!data) {
+            print_error("elf_getdata() failed: %s\n", elf_errmsg(-1));
+            fail();
+        }
+
+        for(size_t i = 0; i < shdr->sh_size / sh_entsize; i++) {
+            const char *tag;
+            const char *str = NULL;
+            char *name;
+            size_t len;
+            GElf_Dyn dyn;
+
+            if(!gelf_getdyn(data, i, &dyn)) {
+                print_error("gelf_getdyn() failed: %s\n", elf_errmsg(-1));
+                fail();
+            }
+
+            if(dyn.d_tag == DT_NULL)
+                continue;
+
+            tag = elf_name_str(&dt_names, dyn.d_tag);
+            if(!tag)
+                tag = "unknown";
+
+            if(dyn_is_string(dyn.d_tag))
+                str = elf_strptr(file->elf, shdr->sh_link, dyn.d_un.d_val);
+
+            len = strlen(tag) + (str ? strlen(str) + 1 : 0) + 1;
+
+            name = malloc(len);
+            if(!name) {
+                print_error("malloc() failed: %s\n", strerror(errno));
+                fail();
+            }
+
+            if(str)
+                snprintf(name, len, "%s %s", tag, str);
+            else
+                snprintf(name, len, "%s", tag);
+
+            diff_add(entries, num, cap, name, str ? 0 : dyn.d_un.d_val, i);
+        }
+    }
+}
+
+void diff_dynamic_section(struct diff_file *old, struct diff_file *new) {
+    const struct diff_kind kind = {
+        "diff_dynamic", "Dynamic Section", "Elf_Dyn", 0
+    };
+    struct diff_table table = {0};
+
+    table.own_names = 1;
+
+    diff_add_dynamic(old, &table.old, &table.old_num, &table.old_cap);
+    diff_add_dynamic(new, &table.new, &table.new_num, &table.new_cap);
+
+    show_diff_table(&kind, &table);
+    free_diff_table(&table);
+}
+
+// add the named symbols of the symbol tables of a type that the --sym-*
+// filters take (the names stay in the file)
+void diff_add_symbols(struct diff_file *file, GElf_Word type,
+                      struct diff_entry **entries, size_t *num, size_t *cap) {
+    diff_use(file);
+    load_sym_sections();
+
+    for(size_t j = 1; j < sections_num; j++) {
+        GElf_Shdr *shdr = &sections[j].shdr;
+        struct sym_table syms;
+
+        if(shdr->sh_type != type)
+            continue;
+
+        advise_section(shdr, MADV_SEQUENTIAL);
+        advise_section(shdr, MADV_WILLNEED);
+
+        load_sym_table(file->elf, j, &syms);
+
+        // one allocation for the whole table
+        if(*cap < *num + syms.num) {
+            *cap = *num + syms.num;
+
+            *entries = realloc(*entries, *cap * sizeof(**entries));
+            if(!*entries) {
+                print_error("realloc() failed: %s\n", strerror(errno));
+                fail();
+            }
+        }
+
+        SYM_LOOP(&syms, 1, i, sym,
+            const char *name;
+
+            if(GELF_ST_TYPE(sym.st_info) == STT_SECTION ||
+               GELF_ST_TYPE(sym.st_info) == STT_FILE)
+                continue;
+
+            name = get_sym_name(&syms, &sym);
+            if(!name || *name == '\0' || !sym_matches(&syms, &sym))
+                continue;
+
+            diff_add(entries, num, cap, name, sym.st_size, i);
+        );
+    }
+
+    free_sym_sections();
+    sections = NULL;
+    sections_num = 0;
+}
+
+void diff_symbols(struct diff_file *old, struct diff_file *new,
+                  GElf_Word type) {
+    const struct diff_kind symtab_kind = {
+        "diff_symtab", "Symbol Table", "Elf_Sym", 1
+    };
+    const struct diff_kind dynsym_kind = {
+        "diff_dyn_syms", "Dynamic Symbol Table", "Elf_Sym", 1
+    };
+    struct diff_table table = {0};
+
+    diff_add_symbols(old, type, &table.old, &table.old_num, &table.old_cap);
+    diff_add_symbols(new, type, &table.new, &table.new_num, &table.new_cap);
+
+    show_diff_table(type == SHT_SYMTAB ? &symtab_kind : &dynsym_kind, &table);
+    free_diff_table(&table);
+}
+
+// compare two elf files table by table (option --diff), only the tables of
+// -h, -p, -s, -d, --symtab and --dyn-syms when any is given
+void show_diff(char *old_filename, char *new_filename) {
+    struct diff_file old, new;
+    int all = !(file_header_opt || program_headers_opt ||
+                section_headers_opt || dynamic_section_opt || symtab_opt ||
+                dynamic_symtab_opt);
+    int is_first = 1;
+
+    stats_enter(STATS_ELF_BEGIN);
+
+    current_file = old_filename;
+    diff_open(&old, old_filename);
+    current_file = new_filename;
+    diff_open(&new, new_filename);
+
+    stats_enter(STATS_DIFF);
+
+    if(output_format == FORMAT_JSON) {
+        json_open('{');
+        json_field_str("old_file", old_filename);
+        json_field_str("new_file", new_filename);
+    }
+
+    if(all || file_header_opt) {
+        diff_file_header(&old, &new);
+        is_first = 0;
+    }
+
+    if(all || program_headers_opt) {
+        if(!is_first)
+            print_separator();
+
+        diff_program_headers(&old, &new);
+        is_first = 0;
+    }
+
+    if(all || section_headers_opt) {
+        if(!is_first)
+            print_separator();
+
+        diff_section_headers(&old, &new);
+        is_first = 0;
+    }
+
+    if(all || dynamic_section_opt) {
+        if(!is_first)
+            print_separator();
+
+        diff_dynamic_section(&old, &new);
+        is_first = 0;
+    }
+
+    if(all || symtab_opt) {
+        if(!is_first)
+            print_separator();
+
+        diff_symbols(&old, &new, SHT_SYMTAB);
+        is_first = 0;
+    }
+
+    if(all || dynamic_symtab_opt) {
+        if(!is_first)
+            print_separator();
+
+        diff_symbols(&old, &new, SHT_DYNSYM);
+    }
+
+    if(output_format == FORMAT_JSON) {
+        json_close('}');
+        out_char('\n');
+    }
+
+    stats_enter(STATS_OTHER);
+
+    diff_close(&old);
+    diff_close(&new);
+
+    out_flush();
+}
+
+// directory of the cache (option --cache) and what the output depends on
+// besides the file, both set in main
+char *cache_dir = NULL;
+char *cache_options = NULL;
+
+// keys of the current file in the cache: its inode and, when it has one, its
+// build id (NULL when the file isn't cached)
+__thread char *cache_keys[2];
+
+// build a cache key: the options, what tells the file apart and its name
+// when the output has it (json)
+char *cache_key(const char *id, const char *filename) {
+    const char *format = "elfy %s\n%s\n%s\n%s";
+    const char *name = output_format == FORMAT_TEXT ? "" : filename;
+    size_t len = snprintf(NULL, 0, format, ELFY_VERSION, cache_options, id,
+                          name);
+    char *key = malloc(len + 1);
+
+    if(!key) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        fail();
+    }
+
+    snprintf(key, len + 1, format, ELFY_VERSION, cache_options, id, name);
+
+    return key;
+}
+
+// path of the cache entry of a key, named after its fnv-1a hash (the keys
+// are kept in the entry to tell collisions apart)
+void cache_path(char *path, size_t size, const char *key) {
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for(; *key; key++)
+        hash = (hash ^ (unsigned char) *key) * 0x100000001b3;
+
+    snprintf(path, size, "%s/%016lx", cache_dir, (unsigned long) hash);
+}
+
+// start writing an entry under the given keys (the second one can be NULL)
+// to a temporary file, the output goes there through out_flush
+int cache_begin(char *key, char *other_key) {
+    // what was printed before isn't part of the entry
+    out_flush();
+
+    snprintf(cache_tmp, sizeof(cache_tmp), "%s/.elfy.XXXXXX", cache_dir);
+
+    cache_fd = mkstemp(cache_tmp);
+    if(cache_fd < 0)
+        return 0;
+
+    // an entry is the keys it's stored under, each ending with a nul, an
+    // empty key and the output
+    cache_write(key, strlen(key) + 1);
+
+    if(other_key)
+        cache_write(other_key, strlen(other_key) + 1);
+
+    cache_write("", 1);
+
+    return cache_fd >= 0;
+}
+
+// put the entry in place, or drop it when the output isn't complete
+void cache_end(char *key, char *other_key, int keep) {
+    char path[4096];
+
+    if(cache_fd < 0)
+        return;
+
+    close(cache_fd);
+    cache_fd = -1;
+
+    if(!keep) {
+        unlink(cache_tmp);
+        return;
+    }
+
+    // the same entry under both names
+    if(other_key) {
+        cache_path(path, sizeof(path), other_key);
+        unlink(path);
+
+        if(link(cache_tmp, path) != 0)
+            unlink(path);
+    }
+
+    cache_path(path, sizeof(path), key);
+
+    if(rename(cache_tmp, path) != 0)
+        unlink(cache_tmp);
+}
+
+// print the output stored under key (returns 0 when it isn't in the cache),
+// and store it under copy_key too when given
+int cache_output(const char *key, char *copy_key) {
+    char path[4096];
+    struct stat st;
+    char *map;
+    size_t pos = 0;
+    int found = 0;
+    int fd;
+
+    cache_path(path, sizeof(path), key);
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return 0;
+
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED)
+        return 0;
+
+    while(pos < (size_t) st.st_size && map[pos] != '\0') {
+        char *end = memchr(map + pos, '\0', st.st_size - pos);
+
+        if(!end)
+            break;
+
+        if(!strcmp(map + pos, key))
+            found = 1;
 
-            puts(" (unknown)");
+        pos = end - map + 1;
     }
 
-    // object file version
-    print_field("e_version", "%x", ehdr.e_version);
+    if(found && pos < (size_t) st.st_size) {
+        pos++;
 
-    // entry point virtual address
-    print_field("e_entry", "%#lx", ehdr.e_entry);
+        if(copy_key && cache_begin(copy_key, NULL)) {
+            cache_write(map + pos, st.st_size - pos);
+            cache_end(copy_key, NULL, 1);
+        }
 
-    // program header table file offset
-    print_field("e_phoff", "%#lx", ehdr.e_phoff);
+        out_write(map + pos, st.st_size - pos);
+    } else
+        found = 0;
 
-    // section header table file offset
-    print_field("e_shoff", "%#lx", ehdr.e_shoff);
+    munmap(map, st.st_size);
 
-    // processor-specific flags
-    print_field("e_flags", "%#x", ehdr.e_flags);
+    return found;
+}
 
-    // ELF header size in bytes
-    print_field("e_ehsize", "%d", ehdr.e_ehsize);
+// hash of the contents of a file, 8 bytes at a time, so a copy found by its
+// build id is known to be the same file (0 when it can't be read)
+uint64_t cache_checksum(int fd, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325;
+    const unsigned char *map;
+    size_t pos;
 
-    // program header table entry size
-    print_field("e_phentsize", "%d", ehdr.e_phentsize);
+    if(size == 0)
+        return hash;
 
-    // program header table entry count
-    print_field("e_phnum", NULL);
+    map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED)
+        return 0;
 
-    if(!no_color_opt)
-        printf("%s", C_GREEN);
+    if(stats_opt)
+        __atomic_fetch_add(&stats_mapped_bytes, size, __ATOMIC_RELAXED);
 
-    // handle when phnum is too large to fit into e_phnum
-    if(ehdr.e_phnum == PN_XNUM) {
-        Elf_Scn *section = NULL;
-        GElf_Shdr shdr;
+    for(pos = 0; size - pos >= 8; pos += 8) {
+        uint64_t word;
 
-        section = elf_getscn(elf, 0);
-        if(!section) {
-            print_error("elf_getscn() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
+        memcpy(&word, map + pos, 8);
+        hash = (hash ^ word) * 0x100000001b3;
+        hash ^= hash >> 29;
+    }
 
-        if(!gelf_getshdr(section, &shdr)) {
-            print_error("gelf_getshdr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
+    for(; pos < size; pos++)
+        hash = (hash ^ map[pos]) * 0x100000001b3;
 
-        printf("%d\n", shdr.sh_info);
-    } else
-        printf("%d\n", ehdr.e_phnum);
+    munmap((void *) map, size);
 
-    if(!no_color_opt)
-        printf("%s", C_END);
+    return hash;
+}
 
-    // section header table entry size
-    print_field("e_shentsize", "%d", ehdr.e_shentsize);
+// look for the output of a file in the cache, first by inode then by build
+// id, and print it (returns 0 when it isn't there, the keys to store it
+// under are then in cache_keys)
+int cache_lookup(int fd, const char *filename) {
+    char id[256];
+    char build_id[BUILD_ID_SIZE];
+    uint64_t checksum;
+    struct stat st;
 
-    // section header table entry count
-    print_field("e_shnum", "%d", ehdr.e_shnum);
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
 
-    // section header string table index
-    print_field("e_shstrndx", "%d", ehdr.e_shstrndx);
+    snprintf(id, sizeof(id), "file %lu %lu %lu %ld.%09ld",
+             (unsigned long) st.st_dev, (unsigned long) st.st_ino,
+             (unsigned long) st.st_size, (long) st.st_mtim.tv_sec,
+             st.st_mtim.tv_nsec);
 
-    putchar('\n');
+    cache_keys[0] = cache_key(id, filename);
 
-    // display the e_ident array in details
-    print_title("Elf_Ehdr.e_ident");
+    if(cache_output(cache_keys[0], NULL))
+        return 1;
 
-    // file identification byte 0..3 index
-    print_field("EI_MAG0", "%#x", ehdr.e_ident[EI_MAG0]);
-    print_field("EI_MAG1", "%c", ehdr.e_ident[EI_MAG1]);
-    print_field("EI_MAG2", "%c", ehdr.e_ident[EI_MAG2]);
-    print_field("EI_MAG3", "%c", ehdr.e_ident[EI_MAG3]);
+    // a copy of a file that was displayed before, the checksum of the
+    // contents tells apart a file edited in place that kept its build id and
+    // size (only then the entry is stored under the new inode too)
+    if(read_build_id(fd, NULL, 0, build_id) <= 0)
+        return 0;
 
-    // file class byte index
-    print_field("EI_CLASS", NULL);
-    switch(ehdr.e_ident[EI_CLASS]) {
-        case ELFCLASSNONE:
-            print_field_info("ELFCLASSNONE", "invalid class");
-            break;
-        case ELFCLASS32:
-            print_field_info("ELFCLASS32", "32-bit object");
-            break;
-        case ELFCLASS64:
-            print_field_info("ELFCLASS64", "64-bit object");
-            break;
-        default:
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, ehdr.e_ident[EI_CLASS]);
-            else
-                printf("%#x", ehdr.e_ident[EI_CLASS]);
+    checksum = cache_checksum(fd, st.st_size);
+    if(!checksum)
+        return 0;
+
+    snprintf(id, sizeof(id), "build-id %s %lu %016lx", build_id,
+             (unsigned long) st.st_size, (unsigned long) checksum);
+
+    cache_keys[1] = cache_key(id, filename);
 
-            puts(" (unknown)");
+    return cache_output(cache_keys[1], cache_keys[0]);
+}
+
+// everything the output depends on besides the file, for the cache keys
+char *cache_options_string(void) {
+    size_t len = 0;
+    char *options;
+    int opts[] = {
+        file_header_opt, program_headers_opt, section_headers_opt,
+        dynamic_section_opt, symtab_opt, dynamic_symtab_opt, relocs_opt,
+        reloc_summary_opt, relr_opt, hash_stats_opt, compression_opt,
+        notes_opt, build_id_opt, archive_index_opt, all_opt, no_color_opt,
+        output_format, sym_fields, top_opt, top_by, size_report_opt, deps_opt
+    };
+
+    for(size_t i = 0; i < lookup_names_num; i++)
+        len += strlen(lookup_names[i]) + 8;
+
+    for(size_t i = 0; i < hex_dump_sections_num; i++)
+        len += strlen(hex_dump_sections[i]) + 10;
+
+    for(size_t i = 0; i < sym_filter_opts_num; i++)
+        len += strlen(sym_filter_opts[i]) + 1;
+
+    options = malloc(len + sizeof(opts) / sizeof(*opts) * 12 + 1);
+    if(!options) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
     }
 
-    // data encoding byte index
-    print_field("EI_DATA", NULL);
-    switch(ehdr.e_ident[EI_DATA]) {
-        case ELFDATANONE:
-            print_field_info("ELFDATANONE", "invalid data encoding");
-            break;
-        case ELFDATA2LSB:
-            print_field_info("ELFDATA2LSB", "2's complement, little endian");
-            break;
-        case ELFDATA2MSB:
-            print_field_info("ELFDATA2MSB", "2's complement, big endian");
-            break;
-        default:
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, ehdr.e_ident[EI_DATA]);
-            else
-                printf("%#x", ehdr.e_ident[EI_DATA]);
+    len = 0;
+
+    for(size_t i = 0; i < sizeof(opts) / sizeof(*opts); i++)
+        len += sprintf(options + len, "%d ", opts[i]);
 
-            puts(" (unknown)");
+    for(size_t i = 0; i < lookup_names_num; i++)
+        len += sprintf(options + len, "\nlookup %s", lookup_names[i]);
+
+    for(size_t i = 0; i < hex_dump_sections_num; i++)
+        len += sprintf(options + len, "\nhex-dump %s", hex_dump_sections[i]);
+
+    for(size_t i = 0; i < sym_filter_opts_num; i++)
+        len += sprintf(options + len, "\n%s", sym_filter_opts[i]);
+
+    return options;
+}
+
+// open a file and display it, any failure only gives up on this file
+void display_file(struct job *job) {
+    jmp_buf env;
+    Elf *volatile archive = NULL;
+    Elf *volatile elf = NULL;
+    volatile int fd = -1;
+    volatile int stream_fd = -1;
+    char *path = job->archive ? job->archive : job->filename;
+    char member_file[4096];
+
+    current_job = job;
+    current_file = job->filename;
+    json_files = 0;
+
+    if(setjmp(env)) {
+        job->failed = 1;
+        json_close_all();
+        goto done;
     }
 
-    // file version byte index
-    print_field("EI_VERSION", NULL);
-    switch(ehdr.e_ident[EI_VERSION]) {
-        case EV_NONE:
-            print_field_info("EV_NONE", "invalid ELF version");
-            break;
-        case EV_CURRENT:
-            print_field_info("EV_CURRENT", "current version");
-            break;
-        default:
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, ehdr.e_ident[EI_VERSION]);
-            else
-                printf("%#x", ehdr.e_ident[EI_VERSION]);
+    fail_jmp = &env;
 
-            puts(" (unknown)");
+    // label each file when there is more than one (an archive member is
+    // always labeled)
+    if((jobs_num > 1 || job->archive) && output_format == FORMAT_TEXT) {
+        if(job != jobs)
+            print_separator();
+
+        print_title("File: %s\n", job->filename);
     }
 
-    // OS ABI identification
-    print_field("EI_OSABI", NULL);
-    switch(ehdr.e_ident[EI_OSABI]) {
-        case ELFOSABI_SYSV:
-            print_field_info("ELFOSABI_SYSV", "UNIX System V");
-            break;
-        case ELFOSABI_HPUX:
-            print_field_info("ELFOSABI_HPUX", "HP-UX");
-            break;
-        case ELFOSABI_NETBSD:
-            print_field_info("ELFOSABI_NETBSD", "NetBSD");
-            break;
-        case ELFOSABI_GNU:
-            print_field_info("ELFOSABI_GNU", "object uses GNU ELF extensions");
-            break;
-        case ELFOSABI_SOLARIS:
-            print_field_info("ELFOSABI_SOLARIS", "Sun Solaris");
-            break;
-        case ELFOSABI_AIX:
-            print_field_info("ELFOSABI_AIX", "IBM AIX");
-            break;
-        case ELFOSABI_IRIX:
-            print_field_info("ELFOSABI_IRIX", "SGI Irix");
-            break;
-        case ELFOSABI_FREEBSD:
-            print_field_info("ELFOSABI_FREEBSD", "FreeBSD");
-            break;
-        case ELFOSABI_TRU64:
-            print_field_info("ELFOSABI_TRU64", "Compaq TRU64 UNIX");
-            break;
-        case ELFOSABI_MODESTO:
-            print_field_info("ELFOSABI_MODESTO", "Novell Modesto");
-            break;
-        case ELFOSABI_OPENBSD:
-            print_field_info("ELFOSABI_OPENBSD", "OpenBSD");
-            break;
-        case ELFOSABI_ARM_AEABI:
-            print_field_info("ELFOSABI_ARM_AEABI", "ARM EABI");
-            break;
-        case ELFOSABI_ARM:
-            print_field_info("ELFOSABI_ARM", "ARM");
-            break;
-        case ELFOSABI_STANDALONE:
-            print_field_info("ELFOSABI_STANDALONE", "standalone (embedded) application");
-            break;
-        default:
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, ehdr.e_ident[EI_OSABI]);
-            else
-                printf("%#x", ehdr.e_ident[EI_OSABI]);
+    stats_enter(STATS_ELF_BEGIN);
 
-            puts(" (unknown)");
+    // - is the standard input
+    if(!strcmp(path, "-"))
+        fd = dup(STDIN_FILENO);
+    else
+        fd = open(path, O_RDONLY);
+
+    if(fd < 0) {
+        print_error("Cannot open %s failed: %s\n", path, strerror(errno));
+        fail();
     }
 
-    // ABI version
-    print_field("EI_ABIVERSION", "%#x", ehdr.e_ident[EI_ABIVERSION]);
+    // only the build id: read the few bytes it takes instead of the whole
+    // elf (archives and pipes go through libelf)
+    if(build_id_opt && !job->archive && !elf_tables_requested()) {
+        char id[BUILD_ID_SIZE];
+        int found;
 
-    // byte index of padding bytes
-    print_field("EI_PAD", "%#x", ehdr.e_ident[EI_PAD]);
-}
+        stats_enter(STATS_BUILD_ID);
+        found = read_build_id(fd, NULL, 0, id);
 
-// display the program headers (option -p)
-void show_program_headers(Elf *elf) {
-    size_t num;
+        if(found >= 0) {
+            display_build_id(found ? id : NULL, job->filename);
+            goto done;
+        }
+    }
 
-    print_title("Program Headers\n");
+    // the output of a file displayed before is in the cache
+    if(cache_dir && !job->archive) {
+        out_flush();
 
-    // strlen("p_filesz")
-    field_max_len = 8;
+        stats_enter(STATS_CACHE);
+        if(cache_lookup(fd, job->filename))
+            goto done;
 
-    // get the number of program headers
-    if(elf_getphdrnum(elf, &num) != 0) {
-        print_error("elf_getphdrnum() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
+        stats_enter(STATS_ELF_BEGIN);
     }
 
-    for(size_t i = 0; i < num; i++) {
-        GElf_Phdr phdr;
+    // a pipe can only be read once and in order, keep what's needed of it
+    if(lseek(fd, 0, SEEK_CUR) < 0 && errno == ESPIPE) {
+        stream_fd = fd;
+        fd = -1;
+        stream_file(stream_fd, &fd);
+    }
 
-        // get the program header
-        if(!gelf_getphdr(elf, i, &phdr)) {
-            print_error("gelf_getphdr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
+    // map the whole file so libelf uses the sections in place instead of
+    // copying them into heap buffers
+    if(!no_mmap_opt) {
+        struct stat st;
+
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            file_size = st.st_size;
+            file_map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(file_map == MAP_FAILED)
+                file_map = NULL;
+            else if(stats_opt)
+                __atomic_fetch_add(&stats_mapped_bytes, file_size,
+                                   __ATOMIC_RELAXED);
         }
+    }
 
-        print_title("Elf_Phdr %zu", i);
+    // read the elf
+    if(file_map) {
+        // the dumpers jump between tables, so don't read ahead by default
+        madvise(file_map, file_size, MADV_RANDOM);
+        elf = elf_memory(file_map, file_size);
+    } else
+        elf = elf_begin(fd, ELF_C_READ, NULL);
 
-        // segment type
-        print_field("p_type", NULL);
-        switch(phdr.p_type) {
-            case PT_LOAD:
-                print_field_info("PT_LOAD", "loadable program segment");
-                break;
-            case PT_DYNAMIC:
-                print_field_info("PT_DYNAMIC", "dynamic linking information");
-                break;
-            case PT_INTERP:
-                print_field_info("PT_INTERP", "program interpreter");
-                break;
-            case PT_NOTE:
-                print_field_info("PT_NOTE", "auxiliary information");
-                break;
-            case PT_SHLIB:
-                print_field_info("PT_SHLIB", "reserved");
-                break;
-            case PT_PHDR:
-                print_field_info("PT_PHDR", "entry for the header table itself");
-                break;
-            case PT_TLS:
-                print_field_info("PT_TLS", "thread-local storage segment");
-                break;
-            case PT_GNU_EH_FRAME:
-                print_field_info("PT_GNU_EH_FRAME", "GCC .eh_frame_hdr segment");
-                break;
-            case PT_GNU_STACK:
-                print_field_info("PT_GNU_STACK", "indicates stack executability");
-                break;
-            case PT_GNU_RELRO:
-                print_field_info("PT_GNU_RELRO", "read-only after relocation");
-                break;
-            case PT_GNU_PROPERTY:
-                print_field_info("PT_GNU_PROPERTY", "GNU property");
-                break;
-            default:
-                if(!no_color_opt)
-                    printf(C_GREEN "%#x" C_END, phdr.p_type);
-                else
-                    printf("%#x", phdr.p_type);
+    if(!elf) {
+        print_error("elf_begin() failed: %s\n", elf_errmsg(-1));
+        fail();
+    }
 
-                if((phdr.p_type >= PT_LOOS) && (phdr.p_type <= PT_HIOS))
-                    puts(" (os-specific)");
-                else if(phdr.p_type >= PT_LOPROC)
-                    puts(" (processor-specific)");
-                else
-                    puts(" (unknown)");
-        }
+    // an archive member is an elf of its own inside the archive
+    if(job->archive) {
+        archive = elf;
+        elf = open_member(archive, fd, job->member_offset);
+    }
 
-        // segment flags
-        print_field("p_flags", NULL);
-        switch(phdr.p_flags) {
-            case PF_R:
-                print_field_info("PF_R", "segment is readable");
-                break;
-            case PF_W:
-                print_field_info("PF_W", "segment is writable");
-                break;
-            case PF_X:
-                print_field_info("PF_X", "segment is executable");
-                break;
-            case PF_R | PF_W:
-                print_field_info("PF_R | PF_W", "segment is readable and writable");
-                break;
-            case PF_R | PF_X:
-                print_field_info("PF_R | PF_X", "segment is readable and executable");
-                break;
-            case PF_W | PF_X:
-                print_field_info("PF_W | PF_X", "segment is writable and executable");
-                break;
-            case PF_R | PF_W | PF_X:
-                print_field_info("PF_R | PF_W | PF_X", "segment is readable, writable and executable");
-                break;
-            default:
-                if(!no_color_opt)
-                    printf(C_GREEN "%#x" C_END, phdr.p_flags);
-                else
-                    printf("%#x", phdr.p_flags);
+    if(elf_kind(elf) == ELF_K_AR) {
+        archive = elf;
+        elf = NULL;
 
-                if(phdr.p_flags & PF_MASKOS)
-                    puts(" (os-specific)");
-                else if(phdr.p_flags & PF_MASKPROC)
-                    puts(" (processor-specific)");
-                else
-                    puts(" (unknown)");
+        // the members of an archive that is the only file are the elements
+        // of the array when they are displayed here (only one job prints)
+        if(output_format == FORMAT_JSON && !json_array &&
+           !job->members_split && (elf_tables_requested() || build_id_opt)) {
+            json_array = 1;
+            out_str("[\n");
         }
 
-        // segment file offset
-        print_field("p_offset", "%#lx", phdr.p_offset);
-
-        // segment virtual address
-        print_field("p_vaddr", "%#lx", phdr.p_vaddr);
+        if(archive_index_opt) {
+            if(output_format == FORMAT_JSON)
+                json_file_open(job->filename);
 
-        // segment physical address
-        print_field("p_paddr", "%#lx", phdr.p_paddr);
+            stats_enter(STATS_ARCHIVE_INDEX);
+            show_archive_index(archive);
+            stats_enter(STATS_OTHER);
 
-        // segment size in file
-        print_field("p_filesz", "%#lx", phdr.p_filesz);
+            if(output_format == FORMAT_JSON)
+                json_file_close();
+        }
 
-        // segment size in memory
-        print_field("p_memsz", "%#lx", phdr.p_memsz);
+        // members that couldn't be split into jobs (e.g. the archive comes
+        // from a pipe) are displayed here, one after the other
+        if(!job->members_split && (elf_tables_requested() || build_id_opt)) {
+            Elf_Cmd cmd = file_map ? ELF_C_READ_MMAP : ELF_C_READ;
+            int is_first = !archive_index_opt;
 
-        // segment alignment
-        print_field("p_align", "%#lx", phdr.p_align);
+            stats_enter(STATS_ELF_BEGIN);
 
-        if(i + 1 != num)
-            putchar('\n');
-    }
-}
+            while((elf = elf_begin(file_map ? -1 : fd, cmd, archive))) {
+                Elf_Arhdr *hdr = elf_getarhdr(elf);
 
-// display the section headers (option -s)
-void show_section_headers(Elf *elf) {
-    size_t num;
-    size_t shstrndx;
+                // the symbol tables and the long names aren't files, and
+                // only elf members are displayed
+                if(hdr && hdr->ar_name[0] != '/' &&
+                   elf_kind(elf) == ELF_K_ELF) {
+                    snprintf(member_file, sizeof(member_file), "%s(%s)",
+                             job->filename, hdr->ar_name);
+                    current_file = member_file;
+                    file_base = elf_getbase(elf);
 
-    print_title("Section Headers\n");
+                    if(output_format == FORMAT_TEXT) {
+                        if(!is_first)
+                            print_separator();
 
-    // strlen("sh_addralign")
-    field_max_len = 12;
+                        print_title("File: %s\n", member_file);
+                    }
 
-    // get the number of section headers
-    if(elf_getshdrnum(elf, &num) != 0) {
-        print_error("elf_getshdrnum() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
-    }
+                    display_elf(elf, member_file);
+                    is_first = 0;
+                }
 
-    // get the section index of the strtab
-    if(elf_getshdrstrndx(elf, &shstrndx) != 0) {
-        print_error("elf_getshdrstrndx() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
-    }
+                stats_enter(STATS_ELF_BEGIN);
 
-    for(size_t i = 0; i < num; i++) {
-        Elf_Scn *section = NULL;
-        GElf_Shdr shdr;
-        char *name = NULL;
+                cmd = elf_next(elf);
+                free_sections();
+                elf_end(elf);
+                elf = NULL;
+            }
 
-        // get the section
-        section = elf_getscn(elf, i);
-        if(!section) {
-            print_error("elf_getscn() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
+            stats_enter(STATS_OTHER);
         }
+    } else if(elf_kind(elf) != ELF_K_ELF) {
+        print_error("%s is not an ELF object\n", job->filename);
+        fail();
+    } else {
+        stats_enter(STATS_OTHER);
 
-        // get the section header
-        if(!gelf_getshdr(section, &shdr)) {
-            print_error("gelf_getshdr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
+        if(cache_keys[0]) {
+            stats_enter(STATS_CACHE);
+            cache_begin(cache_keys[0], cache_keys[1]);
+            stats_enter(STATS_OTHER);
         }
 
-        // get the section name from strtab
-        name = elf_strptr(elf, shstrndx, shdr.sh_name);
-        if(!name) {
-            print_error("elf_strptr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
+        display_elf(elf, job->filename);
+    }
 
-        print_title("Elf_Shdr %zu", i);
+done:
+    fail_jmp = NULL;
+    stats_enter(STATS_OTHER);
 
-        // section name
-        print_field("sh_name", NULL);
-        if(!no_color_opt)
-            printf(C_GREEN "%d" C_END, shdr.sh_name);
-        else
-            printf("%d", shdr.sh_name);
+    if(cache_keys[0]) {
+        out_flush();
 
-        if(*name == '\0')
-            putchar('\n');
-        else
-            printf(" (%s)\n", name);
+        stats_enter(STATS_CACHE);
+        cache_end(cache_keys[0], cache_keys[1], !job->failed);
+        stats_enter(STATS_OTHER);
 
-        // section type
-        print_field("sh_type", NULL);
-        switch(shdr.sh_type) {
-            case SHT_NULL:
-                print_field_info("SHT_NULL", "section header table entry unused");
-                break;
-            case SHT_PROGBITS:
-                print_field_info("SHT_PROGBITS", "program data");
-                break;
-            case SHT_SYMTAB:
-                print_field_info("SHT_SYMTAB", "symbol table");
-                break;
-            case SHT_STRTAB:
-                print_field_info("SHT_STRTAB", "string table");
-                break;
-            case SHT_RELA:
-                print_field_info("SHT_RELA", "relocation entries with addends");
-                break;
-            case SHT_HASH:
-                print_field_info("SHT_HASH", "symbol hash table");
-                break;
-            case SHT_DYNAMIC:
-                print_field_info("SHT_DYNAMIC", "dynamic linking information");
-                break;
-            case SHT_NOTE:
-                print_field_info("SHT_NOTE", "notes");
-                break;
-            case SHT_NOBITS:
-                print_field_info("SHT_NOBITS", "program space with no data (bss)");
-                break;
-            case SHT_REL:
-                print_field_info("SHT_REL", "relocation entries, no addends");
-                break;
-            case SHT_SHLIB:
-                print_field_info("SHT_SHLIB", "reserved");
-                break;
-            case SHT_DYNSYM:
-                print_field_info("SHT_DYNSYM", "dynamic linker symbol table");
-                break;
-            case SHT_INIT_ARRAY:
-                print_field_info("SHT_INIT_ARRAY", "array of constructors");
-                break;
-            case SHT_FINI_ARRAY:
-                print_field_info("SHT_FINI_ARRAY", "array of destructors");
-                break;
-            case SHT_PREINIT_ARRAY:
-                print_field_info("SHT_PREINIT_ARRAY", "array of pre-constructors");
-                break;
-            case SHT_GROUP:
-                print_field_info("SHT_GROUP", "section group");
-                break;
-            case SHT_SYMTAB_SHNDX:
-                print_field_info("SHT_SYMTAB_SHNDX", "extended section indices");
-                break;
-            case SHT_GNU_ATTRIBUTES:
-                print_field_info("SHT_GNU_ATTRIBUTES", "object attributes");
-                break;
-            case SHT_GNU_HASH:
-                print_field_info("SHT_GNU_HASH", "GNU-style hash table");
-                break;
-            case SHT_GNU_LIBLIST:
-                print_field_info("SHT_GNU_LIBLIST", "prelink library list");
-                break;
-            case SHT_CHECKSUM:
-                print_field_info("SHT_CHECKSUM", "checksum for DSO content");
-                break;
-            case SHT_GNU_verdef:
-                print_field_info("SHT_GNU_verdef", "version definition section");
-                break;
-            case SHT_GNU_verneed:
-                print_field_info("SHT_GNU_verneed", "version needs section");
-                break;
-            case SHT_GNU_versym:
-                print_field_info("SHT_GNU_versym", "version symbol table");
-                break;
-            default:
-                if(!no_color_opt)
-                    printf(C_GREEN "%#x" C_END, shdr.sh_type);
-                else
-                    printf("%#x", shdr.sh_type);
-
-                if((shdr.sh_type >= SHT_LOPROC) && (shdr.sh_type <= SHT_HIPROC))
-                    puts(" (processor-specific)");
-                else if((shdr.sh_type >= SHT_LOOS) && (shdr.sh_type <= SHT_HIOS))
-                    puts(" (OS-specific)");
-                else if((shdr.sh_type >= SHT_LOUSER) && (shdr.sh_type <= SHT_HIUSER))
-                    puts(" (application-specific)");
-                else
-                    puts(" (unknown)");
-        }
+        free(cache_keys[0]);
+        free(cache_keys[1]);
+        cache_keys[0] = cache_keys[1] = NULL;
+    }
 
-        // section flags
-        print_field("sh_flags", NULL);
-        {
-            int first = 1;
-            unsigned long flags = shdr.sh_flags;
+    out_flush();
+    job_finish(job);
+    current_job = NULL;
+    current_file = NULL;
 
-            if(!no_color_opt)
-                printf("%s", C_GREEN);
+    free_sections();
 
-            if(flags == 0)
-                printf("%#lx", flags);
+    if(elf)
+        elf_end(elf);
 
-            while(flags) {
-                unsigned long flag;
+    if(archive)
+        elf_end(archive);
 
-                flag = flags & -flags;
-                flags &= ~flag;
+    file_base = 0;
 
-                if(first)
-                    first = 0;
-                else
-                    printf(" | ");
-
-                switch(flag) {
-                    // writable
-                    case SHF_WRITE:
-                        printf("SHF_WRITE");
-                        break;
-                    // occupies memory during execution
-                    case SHF_ALLOC:
-                        printf("SHF_ALLOC");
-                        break;
-                    // executable
-                    case SHF_EXECINSTR:
-                        printf("SHF_EXECINSTR");
-                        break;
-                    // might be merged
-                    case SHF_MERGE:
-                        printf("SHF_MERGE");
-                        break;
-                    // contains nul-terminated strings
-                    case SHF_STRINGS:
-                        printf("SHF_STRINGS");
-                        break;
-                    // `sh_info' contains SHT index
-                    case SHF_INFO_LINK:
-                        printf("SHF_INFO_LINK");
-                        break;
-                    // preserve order after combining
-                    case SHF_LINK_ORDER:
-                        printf("SHF_LINK_ORDER");
-                        break;
-                    // non-standard OS specific handling required
-                    case SHF_OS_NONCONFORMING:
-                        printf("SHF_OS_NONCONFORMING");
-                        break;
-                    // section is member of a group
-                    case SHF_GROUP:
-                        printf("SHF_GROUP");
-                        break;
-                    // section hold thread-local data
-                    case SHF_TLS:
-                        printf("SHF_TLS");
-                        break;
-                    // special ordering requirement
-                    case SHF_ORDERED:
-                        printf("SHF_ORDERED");
-                        break;
-                    // section is excluded unless referenced or allocated
-                    case SHF_EXCLUDE:
-                        printf("SHF_EXCLUDE");
-                        break;
-                    // section with compressed data
-                    case SHF_COMPRESSED:
-                        printf("SHF_COMPRESSED");
-                        break;
-                    // not to be GCed by linker
-                    case SHF_GNU_RETAIN:
-                        printf("SHF_GNU_RETAIN");
-                        break;
-                    default:
-                        // the flag is unknown
-                        printf("%#lx", flag);
-                }
-            }
+    if(file_map) {
+        munmap(file_map, file_size);
+        file_map = NULL;
+    }
 
-            if(!no_color_opt)
-                printf("%s", C_END);
+    if(fd >= 0)
+        close(fd);
 
-            putchar('\n');
-        }
+    if(stream_fd >= 0)
+        close(stream_fd);
+}
 
-        // section virtual addr at execution
-        print_field("sh_addr", "%#lx", shdr.sh_addr);
+// display files until there are no jobs left
+void *worker(void *arg) {
+    (void) arg;
 
-        // section file offset
-        print_field("sh_offset", "%#lx", shdr.sh_offset);
+    stats_enter(STATS_OTHER);
 
-        // section size in bytes
-        print_field("sh_size", "%#lx", shdr.sh_size);
+    for(;;) {
+        struct job *job = NULL;
 
-        // link to another section
-        print_field("sh_link", "%#x", shdr.sh_link);
+        pthread_mutex_lock(&jobs_lock);
 
-        // additional section information
-        print_field("sh_info", "%#x", shdr.sh_info);
+        if(next_job < jobs_num)
+            job = &jobs[next_job++];
 
-        // section alignment
-        print_field("sh_addralign", "%#lx", shdr.sh_addralign);
+        pthread_mutex_unlock(&jobs_lock);
 
-        // entry size if section holds table
-        print_field("sh_entsize", "%#lx", shdr.sh_entsize);
+        if(!job)
+            break;
 
-        if(i + 1 != num)
-            putchar('\n');
+        display_file(job);
     }
+
+    // the time of the last phase
+    stats_enter(STATS_OTHER);
+
+    return NULL;
 }
 
-// display the dynamic section (option -d)
-void show_dynamic_section(Elf *elf) {
-    Elf_Scn *section = NULL;
-    size_t sh_entsize;
+// add a file to display
+void add_job(char *filename) {
+    if(jobs_num == jobs_cap) {
+        jobs_cap = jobs_cap ? jobs_cap * 2 : 16;
 
-    print_title("Dynamic Section\n");
+        jobs = realloc(jobs, jobs_cap * sizeof(*jobs));
+        if(!jobs) {
+            print_error("realloc() failed: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
 
-    // strlen("d_val")
-    field_max_len = 5;
+    memset(&jobs[jobs_num], 0, sizeof(*jobs));
+    jobs[jobs_num++].filename = filename;
+}
 
-    sh_entsize = gelf_fsize(elf, ELF_T_DYN, 1, EV_CURRENT);
+// add a file to display, or a job for each elf member when it's an archive
+// (so the members are displayed in parallel too). Returns 0 when no job
+// refers to filename (an archive without elf members), so it can be freed
+int add_file(char *filename) {
+    size_t first_job = jobs_num;
+    struct ar_image image;
+    char magic[SARMAG];
+    struct stat st;
+    char *map;
+    int fd;
 
-    while((section = elf_nextscn(elf, section))) {
-        GElf_Shdr shdr;
-        Elf_Data *data = NULL;
-        size_t num = 0;
+    if(!strcmp(filename, "-") || (fd = open(filename, O_RDONLY)) < 0) {
+        add_job(filename);
+        return 1;
+    }
 
-        // get the section header
-        if(!gelf_getshdr(section, &shdr)) {
-            print_error("gelf_getshdr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
+    if(pread(fd, magic, sizeof(magic), 0) != SARMAG ||
+       memcmp(magic, ARMAG, SARMAG) != 0 || fstat(fd, &st) != 0 ||
+       !S_ISREG(st.st_mode)) {
+        close(fd);
+        add_job(filename);
+        return 1;
+    }
 
-        // if it's not a dynamic section, skip the section
-        if(shdr.sh_type != SHT_DYNAMIC)
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    // display_file can still go through the members one by one
+    if(map == MAP_FAILED) {
+        add_job(filename);
+        return 1;
+    }
+
+    // the archive itself is only displayed for its index
+    if(archive_index_opt) {
+        add_job(filename);
+        jobs[jobs_num - 1].members_split = 1;
+    }
+
+    load_ar_image(&image, map, st.st_size);
+
+    for(size_t offset = SARMAG;
+        (elf_tables_requested() || build_id_opt) &&
+        ar_member_size(&image, offset) != (size_t) -1;
+        offset = ar_next(&image, offset)) {
+        const char *data = map + offset + sizeof(struct ar_hdr);
+        char name[4096];
+        char *path;
+
+        if(ar_special(&image, offset) ||
+           ar_member_size(&image, offset) < SELFMAG ||
+           memcmp(data, ELFMAG, SELFMAG) != 0)
             continue;
 
-        num = shdr.sh_size / sh_entsize;
+        ar_member_name(&image, offset, name, sizeof(name));
 
-        // get data from section
-        data = elf_getdata(section, data);
-        if(!data) {
-            print_error("elf_getdata() failed: %s", elf_errmsg(-1));
+        path = malloc(strlen(filename) + strlen(name) + 3);
+        if(!path) {
+            print_error("malloc() failed: %s\n", strerror(errno));
             exit(EXIT_FAILURE);
         }
 
-        for(size_t i = 0; i < num; i++) {
-            GElf_Dyn dyn;
-            char *name = NULL;
+        sprintf(path, "%s(%s)", filename, name);
 
-            // get information from the dynamic table 
-            if(!gelf_getdyn(data, i, &dyn)) {
-                print_error("gelf_getdyn() failed: %s", elf_errmsg(-1));
-                exit(EXIT_FAILURE);
-            }
+        add_job(path);
+        jobs[jobs_num - 1].archive = filename;
+        jobs[jobs_num - 1].member_offset = offset;
+    }
 
-            print_title("Elf_Dyn %zu", i);
+    munmap(map, st.st_size);
 
-            // dynamic entry type
-            print_field("d_tag", NULL);
-            switch(dyn.d_tag) {
-                case DT_NULL:
-                    print_field_info("DT_NULL", "marks end of dynamic section");
-                    break;
-                case DT_NEEDED:
-                    print_field_info("DT_NEEDED", "name of needed library");
-                    break;
-                case DT_PLTRELSZ:
-                    print_field_info("DT_PLTRELSZ", "size in bytes of PLT relocs");
-                    break;
-                case DT_PLTGOT:
-                    print_field_info("DT_PLTGOT", "processor defined value");
-                    break;
-                case DT_HASH:
-                    print_field_info("DT_HASH", "address of symbol hash table");
-                    break;
-                case DT_STRTAB:
-                    print_field_info("DT_STRTAB", "address of string table");
-                    break;
-                case DT_SYMTAB:
-                    print_field_info("DT_SYMTAB", "address of symbol table");
-                    break;
-                case DT_RELA:
-                    print_field_info("DT_RELA", "address of Rela relocs");
-                    break;
-                case DT_RELASZ:
-                    print_field_info("DT_RELASZ", "total size of Rela relocs");
-                    break;
-                case DT_RELAENT:
-                    print_field_info("DT_RELAENT", "size of one Rela reloc");
-                    break;
-                case DT_STRSZ:
-                    print_field_info("DT_STRSZ", "size of string table");
-                    break;
-                case DT_SYMENT:
-                    print_field_info("DT_SYMENT", "size of one symbol table entry");
-                    break;
-                case DT_INIT:
-                    print_field_info("DT_INIT", "address of init function");
-                    break;
-                case DT_FINI:
-                    print_field_info("DT_FINI", "address of termination function");
-                    break;
-                case DT_SONAME:
-                    print_field_info("DT_SONAME", "name of shared object");
-                    break;
-                case DT_RPATH:
-                    print_field_info("DT_RPATH", "library search path (deprecated)");
-                    break;
-                case DT_SYMBOLIC:
-                    print_field_info("DT_SYMBOLIC", "start symbol search here");
-                    break;
-                case DT_REL:
-                    print_field_info("DT_REL", "address of Rel relocs");
-                    break;
-                case DT_RELSZ:
-                    print_field_info("DT_RELSZ", "total size of Rel relocs");
-                    break;
-                case DT_RELENT:
-                    print_field_info("DT_RELENT", "size of one Rel reloc");
-                    break;
-                case DT_PLTREL:
-                    print_field_info("DT_PLTREL", "type of reloc in PLT");
-                    break;
-                case DT_DEBUG:
-                    print_field_info("DT_DEBUG", "for debugging; unspecified");
-                    break;
-                case DT_TEXTREL:
-                    print_field_info("DT_TEXTREL", "Reloc might modify .text");
-                    break;
-                case DT_JMPREL:
-                    print_field_info("DT_JMPREL", "address of PLT relocs");
-                    break;
-                case DT_BIND_NOW:
-                    print_field_info("DT_BIND_NOW", "process relocations of object");
-                    break;
-                case DT_INIT_ARRAY:
-                    print_field_info("DT_INIT_ARRAY", "array with addresses of init fct");
-                    break;
-                case DT_FINI_ARRAY:
-                    print_field_info("DT_FINI_ARRAY", "array with addresses of fini fct");
-                    break;
-                case DT_INIT_ARRAYSZ:
-                    print_field_info("DT_INIT_ARRAYSZ", "size in bytes of DT_INIT_ARRAY");
-                    break;
-                case DT_FINI_ARRAYSZ:
-                    print_field_info("DT_FINI_ARRAYSZ", "size in bytes of DT_FINI_ARRAY");
-                    break;
-                case DT_RUNPATH:
-                    print_field_info("DT_RUNPATH", "library search path");
-                    break;
-                case DT_FLAGS:
-                    print_field_info("DT_FLAGS", "flags for the object being loaded");
-                    break;
-                case DT_PREINIT_ARRAY:
-                    print_field_info("DT_PREINIT_ARRAY", "array with addresses of preinit fct");
-                    break;
-                case DT_PREINIT_ARRAYSZ:
-                    print_field_info("DT_PREINIT_ARRAYSZ", "size in bytes of DT_PREINIT_ARRAY");
-                    break;
-                case DT_SYMTAB_SHNDX:
-                    print_field_info("DT_SYMTAB_SHNDX", "address of SYMTAB_SHNDX section");
-                    break;
-                case DT_CHECKSUM:
-                    if(!no_color_opt)
-                        printf(C_GREEN "DT_CHECKSUM" C_END "\n");
-                    else
-                        puts("DT_CHECKSUM");
-                    break;
-                case DT_PLTPADSZ:
-                    if(!no_color_opt)
-                        printf(C_GREEN "DT_PLTPADSZ" C_END "\n");
-                    else
-                        puts("DT_PLTPADSZ");
-                    break;
-                case DT_MOVEENT:
-                    print_field_info("DT_MOVEENT", "size in bytes of DT_MOVETAB");
-                    break;
-                case DT_MOVESZ:
-                    print_field_info("DT_MOVESZ", "total size of DT_MOVETAB");
-                    break;
-                case DT_VERSYM:
-                    if(!no_color_opt)
-                        printf(C_GREEN "DT_VERSYM" C_END "\n");
-                    else
-                        puts("DT_VERSYM");
-                    break;
-                case DT_TLSDESC_GOT:
-                    if(!no_color_opt)
-                        printf(C_GREEN "DT_TLSDESC_GOT" C_END "\n");
-                    else
-                        puts("DT_TLSDESC_GOT");
-                    break;
-                case DT_TLSDESC_PLT:
-                    if(!no_color_opt)
-                        printf(C_GREEN "DT_TLSDESC_PLT" C_END "\n");
-                    else
-                        puts("DT_TLSDESC_PLT");
-                    break;
-                case DT_RELACOUNT:
-                    print_field_info("DT_RELACOUNT", "Rela reloc count");
-                    break;
-                case DT_RELCOUNT:
-                    print_field_info("DT_RELCOUNT", "Rel reloc count");
-                    break;
-                case DT_GNU_PRELINKED:
-                    print_field_info("DT_GNU_PRELINKED", "prelinking timestamp");
-                    break;
-                case DT_GNU_CONFLICTSZ:
-                    print_field_info("DT_GNU_CONFLICTSZ", "size of conflict section");
-                    break;
-                case DT_GNU_LIBLISTSZ:
-                    print_field_info("DT_GNU_LIBLISTSZ", "size of library list");
-                    break;
-                case DT_FEATURE_1:
-                    print_field_info("DT_FEATURE_1", "feature selection (DTF_*)");
-                    break;
-                case DT_SYMINSZ:
-                    print_field_info("DT_SYMINSZ", "size of syminfo table (in bytes)");
-                    break;
-                case DT_SYMINENT:
-                    print_field_info("DT_SYMINENT", "entry size of syminfo");
-                    break;
-                case DT_GNU_HASH:
-                    print_field_info("DT_GNU_HASH", "GNU-style hash table");
-                    break;
-                case DT_GNU_CONFLICT:
-                    print_field_info("DT_GNU_CONFLICT", "start of conflict section");
-                    break;
-                case DT_GNU_LIBLIST:
-                    print_field_info("DT_GNU_LIBLIST", "library list");
-                    break;
-                case DT_CONFIG:
-                    print_field_info("DT_CONFIG", "configuration information");
-                    break;
-                case DT_DEPAUDIT:
-                    print_field_info("DT_DEPAUDIT", "dependency auditing");
-                    break;
-                case DT_AUDIT:
-                    print_field_info("DT_AUDIT", "object auditing");
-                    break;
-                case DT_PLTPAD:
-                    print_field_info("DT_PLTPAD", "PLT padding");
-                    break;
-                case DT_MOVETAB:
-                    print_field_info("DT_MOVETAB", "address of move table");
-                    break;
-                case DT_SYMINFO:
-                    print_field_info("DT_SYMINFO", "address of syminfo table");
-                    break;
-                case DT_FLAGS_1:
-                    print_field_info("DT_FLAGS_1", "state flags");
-                    break;
-                case DT_VERDEF:
-                    print_field_info("DT_VERDEF", "address of version definition");
-                    break;
-                case DT_VERDEFNUM:
-                    print_field_info("DT_VERDEFNUM", "number of version definitions");
-                    break;
-                case DT_VERNEED:
-                    print_field_info("DT_VERNEED", "address of table with needed versions");
-                    break;
-                case DT_VERNEEDNUM:
-                    print_field_info("DT_VERNEEDNUM", "number of needed versions");
-                    break;
-                case DT_AUXILIARY:
-                    print_field_info("DT_AUXILIARY", "shared object to load before self");
-                    break;
-                case DT_FILTER:
-                    print_field_info("DT_FILTER", "shared object to get values from");
-                    break;
-                default:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%#lx" C_END, dyn.d_tag);
-                    else
-                        printf("%#lx", dyn.d_tag);
-
-                    if((dyn.d_tag >= DT_LOPROC) && (dyn.d_tag <= DT_HIPROC))
-                        puts(" (processor-specific)");
-                    else if((dyn.d_tag >= DT_LOOS) && (dyn.d_tag <= DT_HIOS))
-                        puts(" (OS-specific)");
-                    else
-                        puts(" (unknown)");
-            }
+    return jobs_num > first_job;
+}
 
-            // integer value
-            print_field("d_val", NULL);
-            switch(dyn.d_tag) {
-                // print library name
-                case DT_NEEDED:
-                case DT_SONAME:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%#lx" C_END, dyn.d_un.d_val);
-                    else
-                        printf("%#lx", dyn.d_un.d_val);
+// add the files listed in a file, one per line ("-" reads the list from stdin)
+void add_jobs_from_list(char *list) {
+    FILE *stream = stdin;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+
+    if(strcmp(list, "-")) {
+        stream = fopen(list, "r");
+        if(!stream) {
+            print_error("Cannot open %s failed: %s\n", list, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
 
-                    if(dyn.d_tag == DT_NEEDED || dyn.d_tag == DT_SONAME) {
-                        name = elf_strptr(elf, shdr.sh_link, dyn.d_un.d_val);
-                        if(!name || *name == '\0')
-                            putchar('\n');
-                        else
-                            printf(" (%s)\n", name);
-                    } else
-                        putchar('\n');
+    while((len = getline(&line, &size, stream)) != -1) {
+        if(len > 0 && line[len - 1] == '\n')
+            line[--len] = '\0';
 
-                    break;
-                // print size/count/version/number of ...
-                case DT_PLTRELSZ:
-                case DT_RELASZ:
-                case DT_RELAENT:
-                case DT_STRSZ:
-                case DT_SYMENT:
-                case DT_RELSZ:
-                case DT_RELENT:
-                case DT_INIT_ARRAYSZ:
-                case DT_FINI_ARRAYSZ:
-                case DT_PREINIT_ARRAYSZ:
-                case DT_MOVEENT:
-                case DT_MOVESZ:
-                case DT_RELACOUNT:
-                case DT_RELCOUNT:
-                case DT_GNU_CONFLICTSZ:
-                case DT_GNU_LIBLISTSZ:
-                case DT_SYMINSZ:
-                case DT_SYMINENT:
-                case DT_VERDEFNUM:
-                case DT_VERNEEDNUM:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%ld\n" C_END, dyn.d_un.d_val);
-                    else
-                        printf("%ld\n", dyn.d_un.d_val);
-                    break;
-                // parse flags
-                case DT_FLAGS:
-                    {
-                        int first = 1;
-                        unsigned long flags = dyn.d_un.d_val;
-
-                        if(!no_color_opt)
-                            printf("%s", C_GREEN);
-
-                        if(flags == 0)
-                            printf("%#lx", flags);
-
-                        while(flags) {
-                            unsigned long flag;
-
-                            flag = flags & -flags;
-                            flags &= ~flag;
-
-                            if(first)
-                                first = 0;
-                            else
-                                printf(" | ");
-
-                            switch(flag) {
-                                // object may use DF_ORIGIN
-                                case DF_ORIGIN:
-                                    printf("DF_ORIGIN");
-                                    break;
-                                // symbol resolutions starts here
-                                case DF_SYMBOLIC:
-                                    printf("DF_SYMBOLIC");
-                                    break;
-                                // object contains text relocations
-                                case DF_TEXTREL:
-                                    printf("DF_TEXTREL");
-                                    break;
-                                // no lazy binding for this object
-                                case DF_BIND_NOW:
-                                    printf("DF_BIND_NOW");
-                                    break;
-                                // module uses the static TLS model
-                                case DF_STATIC_TLS:
-                                    printf("DF_STATIC_TLS");
-                                    break;
-                                default:
-                                    // the flag is unknown
-                                    printf("%#lx", flag);
-                            }
-                        }
-
-                        if(!no_color_opt)
-                            printf("%s", C_END);
-
-                        putchar('\n');
-                    }
-                    break;
-                // parse feature_1
-                case DT_FEATURE_1:
-                    {
-                        int first = 1;
-                        unsigned long flags = dyn.d_un.d_val;
-
-                        if(!no_color_opt)
-                            printf("%s", C_GREEN);
-
-                        if(flags == 0)
-                            printf("%#lx", flags);
-
-                        while(flags) {
-                            unsigned long flag;
-
-                            flag = flags & -flags;
-                            flags &= ~flag;
-
-                            if(first)
-                                first = 0;
-                            else
-                                printf(" | ");
-
-                            switch(flag) {
-                                case DTF_1_PARINIT:
-                                    printf("DTF_1_PARINIT");
-                                    break;
-                                case DTF_1_CONFEXP:
-                                    printf("DTF_1_CONFEXP");
-                                    break;
-                                default:
-                                    // the flag is unknown
-                                    printf("%#lx", flag);
-                            }
-                        }
-
-                        if(!no_color_opt)
-                            printf("%s", C_END);
-
-                        putchar('\n');
-                    }
-                    break;
-                // parse flags_1
-                case DT_FLAGS_1:
-                    {
-                        int first = 1;
-                        unsigned long flags = dyn.d_un.d_val;
-
-                        if(!no_color_opt)
-                            printf("%s", C_GREEN);
-
-                        if(flags == 0)
-                            printf("%#lx", flags);
-
-                        while(flags) {
-                            unsigned long flag;
-
-                            flag = flags & -flags;
-                            flags &= ~flag;
-
-                            if(first)
-                                first = 0;
-                            else
-                                printf(" | ");
-
-                            switch(flag) {
-                                // set RTLD_NOW for this object
-                                case DF_1_NOW:
-                                    printf("DF_1_NOW");
-                                    break;
-                                // set RTLD_GLOBAL for this object
-                                case DF_1_GLOBAL:
-                                    printf("DF_1_GLOBAL");
-                                    break;
-                                // set RTLD_GROUP for this object
-                                case DF_1_GROUP:
-                                    printf("DF_1_GROUP");
-                                    break;
-                                // set RTLD_NODELETE for this object
-                                case DF_1_NODELETE:
-                                    printf("DF_1_NODELETE");
-                                    break;
-                                // trigger filtee loading at runtime
-                                case DF_1_LOADFLTR:
-                                    printf("DF_1_LOADFLTR");
-                                    break;
-                                // set RTLD_INITFIRST for this object
-                                case DF_1_INITFIRST:
-                                    printf("DF_1_INITFIRST");
-                                    break;
-                                // set RTLD_NOOPEN for this object
-                                case DF_1_NOOPEN:
-                                    printf("DF_1_NOOPEN");
-                                    break;
-                                // $ORIGIN must be handled
-                                case DF_1_ORIGIN:
-                                    printf("DF_1_ORIGIN");
-                                    break;
-                                // direct binding enabled
-                                case DF_1_DIRECT:
-                                    printf("DF_1_DIRECT");
-                                    break;
-                                case DF_1_TRANS:
-                                    printf("DF_1_TRANS");
-                                    break;
-                                // object is used to interpose
-                                case DF_1_INTERPOSE:
-                                    printf("DF_1_INTERPOSE");
-                                    break;
-                                // ignore default lib search path
-                                case DF_1_NODEFLIB:
-                                    printf("DF_1_NODEFLIB");
-                                    break;
-                                // object can't be dldump'ed
-                                case DF_1_NODUMP:
-                                    printf("DF_1_NODUMP");
-                                    break;
-                                // configuration alternative created
-                                case DF_1_CONFALT:
-                                    printf("DF_1_CONFALT");
-                                    break;
-                                // filtee terminates filters search
-                                case DF_1_ENDFILTEE:
-                                    printf("DF_1_ENDFILTEE");
-                                    break;
-                                // disp reloc applied at build time
-                                case DF_1_DISPRELDNE:
-                                    printf("DF_1_DISPRELDNE");
-                                    break;
-                                // disp reloc applied at run-time
-                                case DF_1_DISPRELPND:
-                                    printf("DF_1_DISPRELPND");
-                                    break;
-                                // object has no-direct binding
-                                case DF_1_NODIRECT:
-                                    printf("DF_1_NODIRECT");
-                                    break;
-                                case DF_1_IGNMULDEF:
-                                    printf("DF_1_IGNMULDEF");
-                                    break;
-                                case DF_1_NOKSYMS:
-                                    printf("DF_1_NOKSYMS");
-                                    break;
-                                case DF_1_NOHDR:
-                                    printf("DF_1_NOHDR");
-                                    break;
-                                // object is modified after built
-                                case DF_1_EDITED:
-                                    printf("DF_1_EDITED");
-                                    break;
-                                case DF_1_NORELOC:
-                                    printf("DF_1_NORELOC");
-                                    break;
-                                // object has individual interposers
-                                case DF_1_SYMINTPOSE:
-                                    printf("DF_1_SYMINTPOSE");
-                                    break;
-                                // global auditing required
-                                case DF_1_GLOBAUDIT:
-                                    printf("DF_1_GLOBAUDIT");
-                                    break;
-                                // singleton symbols are used
-                                case DF_1_SINGLETON:
-                                    printf("DF_1_SINGLETON");
-                                    break;
-                                case DF_1_STUB:
-                                    printf("DF_1_STUB");
-                                    break;
-                                case DF_1_PIE:
-                                    printf("DF_1_PIE");
-                                    break;
-                                case DF_1_KMOD:
-                                    printf("DF_1_KMOD");
-                                    break;
-                                case DF_1_WEAKFILTER:
-                                    printf("DF_1_WEAKFILTER");
-                                    break;
-                                case DF_1_NOCOMMON:
-                                    printf("DF_1_NOCOMMON");
-                                    break;
-                                default:
-                                    // the flag is unknown
-                                    printf("%#lx", flag);
-                            }
-                        }
-
-                        if(!no_color_opt)
-                            printf("%s", C_END);
-
-                        putchar('\n');
-                    }
-                    break;
-                default:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%#lx\n" C_END, dyn.d_un.d_val);
-                    else
-                        printf("%#lx\n", dyn.d_un.d_val);
-            }
+        if(len == 0)
+            continue;
 
-            // stop when it's the end of the dynamic section
-            if(dyn.d_tag == DT_NULL)
-                break;
+        char *filename = strdup(line);
 
-            putchar('\n');
+        if(!filename) {
+            print_error("strdup() failed: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
         }
 
+        if(!add_file(filename))
+            free(filename);
     }
+
+    free(line);
+
+    if(stream != stdin)
+        fclose(stream);
 }
 
-// display the symbol table (option --symtab)
-void show_symtab(Elf *elf) {
-    Elf_Scn *section = NULL;
-    size_t shstrndx;
+// directories waiting to be scanned (option -r), shared by the scanners
+char **scan_dirs = NULL;
+size_t scan_dirs_num = 0;
+size_t scan_dirs_cap = 0;
 
-    print_title("Symbol Table\n");
+// directories queued or being scanned, the scan is over when it reaches 0
+size_t scan_pending = 0;
 
-    // strlen("st_shndx")
-    field_max_len = 8;
+// elf files found by the scanners
+char **scan_files = NULL;
+size_t scan_files_num = 0;
+size_t scan_files_cap = 0;
 
-    // get the section index of the strtab
-    if(elf_getshdrstrndx(elf, &shstrndx) != 0) {
-        print_error("elf_getshdrstrndx() failed: %s", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
-    }
+// whether a directory couldn't be read, for the exit status
+int scan_failed = 0;
 
-    while((section = elf_nextscn(elf, section))) {
-        GElf_Shdr shdr;
-        Elf_Data *data = NULL;
-        size_t num = 0;
+pthread_mutex_t scan_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t scan_cond = PTHREAD_COND_INITIALIZER;
 
-        // get the section header
-        if(!gelf_getshdr(section, &shdr)) {
-            print_error("gelf_getshdr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
-        // if it's not the symbol table section, skip the section
-        if(shdr.sh_type != SHT_SYMTAB)
-            continue;
+// entry returned by getdents64
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
 
-        // get data from section
-        data = elf_getdata(section, data);
-        if(!data) {
-            print_error("elf_getdata() failed: %s", elf_errmsg(-1));
+// grow an array of strings and append str to it (with scan_lock held)
+void scan_append(char ***array, size_t *num, size_t *cap, char *str) {
+    if(*num == *cap) {
+        *cap = *cap ? *cap * 2 : 256;
+
+        *array = realloc(*array, *cap * sizeof(**array));
+        if(!*array) {
+            print_error("realloc() failed: %s\n", strerror(errno));
             exit(EXIT_FAILURE);
         }
+    }
+
+    (*array)[(*num)++] = str;
+}
+
+// join a directory path and an entry name
+char *scan_path(const char *dir, const char *name) {
+    size_t len = strlen(dir);
+    char *path = malloc(len + strlen(name) + 2);
 
-        num = shdr.sh_size / gelf_fsize(elf, ELF_T_SYM, 1, data->d_version);
+    if(!path) {
+        print_error("malloc() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
-        for(size_t i = 0; i < num; i++) {
-            GElf_Sym sym;
-            char *name = NULL;
+    if(len > 0 && dir[len - 1] == '/')
+        sprintf(path, "%s%s", dir, name);
+    else
+        sprintf(path, "%s/%s", dir, name);
 
-            // get information from the dynamic symbol table
-            if(!gelf_getsym(data, i, &sym)) {
-                print_error("gelf_getsym() failed: %s", elf_errmsg(-1));
-                exit(EXIT_FAILURE);
-            }
+    return path;
+}
 
-            print_title("Elf_Sym %zu", i);
+// check the magic number without going through libelf (archives count, their
+// members are elf files)
+int is_elf_file(int dir_fd, const char *name) {
+    char magic[SARMAG];
+    int fd = openat(dir_fd, name, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    ssize_t len;
 
-            // symbol name
-            print_field("st_name", NULL);
+    if(fd < 0)
+        return 0;
 
-            if(!no_color_opt)
-                printf(C_GREEN "%d" C_END, sym.st_name);
-            else
-                printf("%d", sym.st_name);
+    len = pread(fd, magic, sizeof(magic), 0);
+    close(fd);
 
-            name = elf_strptr(elf, shdr.sh_link, sym.st_name);
-            if(!name || *name == '\0')
-                putchar('\n');
-            else
-                printf(" (%s)\n", name);
+    return (len >= SELFMAG && !memcmp(magic, ELFMAG, SELFMAG)) ||
+           (len == SARMAG && !memcmp(magic, ARMAG, SARMAG));
+}
 
-            // symbol type and binding
-            print_field("st_info", NULL);
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, sym.st_info);
-            else
-                printf("%#x", sym.st_info);
+// scan one directory: queue its subdirectories and keep its elf files
+void scan_dir(char *dir) {
+    char buf[1 << 15];
+    long len;
+    int fd;
 
-            printf(" (");
+    fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if(fd < 0) {
+        print_error("Cannot open %s failed: %s\n", dir, strerror(errno));
+        __atomic_store_n(&scan_failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
-            // parse symbol type
-            switch(GELF_ST_TYPE(sym.st_info)) {
-                case STT_NOTYPE:
-                    printf("STT_NOTYPE");
-                    break;
-                case STT_OBJECT:
-                    printf("STT_OBJECT");
-                    break;
-                case STT_FUNC:
-                    printf("STT_FUNC");
-                    break;
-                case STT_SECTION:
-                    printf("STT_SECTION");
-                    break;
-                case STT_FILE:
-                    printf("STT_FILE");
-                    break;
-                case STT_COMMON:
-                    printf("STT_COMMON");
-                    break;
-                case STT_TLS:
-                    printf("STT_TLS");
-                    break;
-                default:
-                    printf("%#x", GELF_ST_TYPE(sym.st_info));
-
-                    if((sym.st_info >= STT_LOPROC) && (sym.st_info <= STT_HIPROC))
-                        printf(" processor-specific");
-                    else if((sym.st_info >= STT_LOOS) && (sym.st_info <= STT_HIOS))
-                        printf(" OS-specific");
-                    else
-                        printf(" unknown");
-            }
+    while((len = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0) {
+        for(long pos = 0; pos < len;) {
+            struct linux_dirent64 *entry = (void *) (buf + pos);
+            unsigned char type = entry->d_type;
+            char *name = entry->d_name;
 
-            printf(", ");
+            pos += entry->d_reclen;
 
-            // parse symbol binding
-            switch(GELF_ST_BIND(sym.st_info)) {
-                case STB_LOCAL:
-                    printf("STB_LOCAL");
-                    break;
-                case STB_GLOBAL:
-                    printf("STB_GLOBAL");
-                    break;
-                case STB_WEAK:
-                    printf("STB_WEAK");
-                    break;
-                default:
-                    printf("%#x", GELF_ST_BIND(sym.st_info));
-
-                    if((sym.st_info >= STB_LOPROC) && (sym.st_info <= STB_HIPROC))
-                        printf(" processor-specific");
-                    else if((sym.st_info >= STB_LOOS) && (sym.st_info <= STB_HIOS))
-                        printf(" OS-specific");
-                    else
-                        printf(" unknown");
-            }
+            if(!strcmp(name, ".") || !strcmp(name, ".."))
+                continue;
 
-            puts(")");
+            // not every filesystem fills d_type
+            if(type == DT_UNKNOWN) {
+                struct stat st;
 
-            // symbol visibility
-            print_field("st_other", NULL);
-            switch(GELF_ST_VISIBILITY(sym.st_other)) {
-                case STV_DEFAULT:
-                    print_field_info("STV_DEFAULT", "default symbol visibility rules");
-                    break;
-                case STV_INTERNAL:
-                    print_field_info("STV_INTERNAL", "processor specific hidden class");
-                    break;
-                case STV_HIDDEN:
-                    print_field_info("STV_HIDDEN", "sym unavailable in other modules");
-                    break;
-                case STV_PROTECTED:
-                    print_field_info("STV_PROTECTED", "not preemptible, not exported");
-                    break;
-                default:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%#x" C_END, GELF_ST_VISIBILITY(sym.st_other));
-                    else
-                        printf("%#x", GELF_ST_VISIBILITY(sym.st_other));
+                if(fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                    continue;
 
-                    puts(" (unknown)");
+                if(S_ISDIR(st.st_mode))
+                    type = DT_DIR;
+                else if(S_ISREG(st.st_mode))
+                    type = DT_REG;
             }
 
-            // section index
-            print_field("st_shndx", NULL);
-            // parse special section indices
-            switch(sym.st_shndx) {
-                case SHN_UNDEF:
-                    print_field_info("SHN_UNDEF", "undefined section");
-                    break;
-                case SHN_BEFORE:
-                    print_field_info("SHN_BEFORE", "order section before all others (Solaris)");
-                    break;
-                case SHN_AFTER:
-                    print_field_info("SHN_AFTER", "order section after all others (Solaris)");
-                    break;
-                case SHN_ABS:
-                    print_field_info("SHN_ABS", "associated symbol is absolute");
-                    break;
-                case SHN_COMMON:
-                    print_field_info("SHN_COMMON", "associated symbol is common");
-                    break;
-                case SHN_XINDEX:
-                    print_field_info("SHN_XINDEX", "index is in extra table");
-                    break;
-                default:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%d" C_END, sym.st_shndx);
-                    else
-                        printf("%d", sym.st_shndx);
-
-                    if((sym.st_shndx >= SHN_LOPROC) && (sym.st_shndx <= SHN_HIPROC))
-                        puts(" (processor-specific)");
-                    else if((sym.st_shndx >= SHN_LOOS) && (sym.st_shndx <= SHN_HIOS))
-                        puts(" (OS-specific)");
-                    else if(sym.st_shndx >= SHN_LORESERVE)
-                        puts(" (reserved indices)");
-                    else {
-                        Elf_Scn *section;
-                        GElf_Shdr shdr;
-                        char *name = NULL;
-
-                        // get the section
-                        section = elf_getscn(elf, sym.st_shndx);
-                        if(!section) {
-                            print_error("elf_getscn() failed: %s",
-                                        elf_errmsg(-1));
-                            exit(EXIT_FAILURE);
-                        }
-
-                        // get the section header
-                        if(!gelf_getshdr(section, &shdr)) {
-                            print_error("gelf_getshdr() failed: %s",
-                                        elf_errmsg(-1));
-                            exit(EXIT_FAILURE);
-                        }
-
-                        name = elf_strptr(elf, shstrndx, shdr.sh_name);
-                        if(!name || *name == '\0')
-                            putchar('\n');
-                        else
-                            printf(" (%s)\n", name);
-                    }
+            // symbolic links are not followed
+            if(type == DT_DIR) {
+                char *path = scan_path(dir, name);
+
+                pthread_mutex_lock(&scan_lock);
+                scan_append(&scan_dirs, &scan_dirs_num, &scan_dirs_cap, path);
+                scan_pending++;
+                pthread_cond_signal(&scan_cond);
+                pthread_mutex_unlock(&scan_lock);
+            } else if(type == DT_REG && is_elf_file(fd, name)) {
+                char *path = scan_path(dir, name);
+
+                pthread_mutex_lock(&scan_lock);
+                scan_append(&scan_files, &scan_files_num, &scan_files_cap,
+                            path);
+                pthread_mutex_unlock(&scan_lock);
             }
+        }
+    }
 
-            // symbol value
-            print_field("st_value", "%#lx", sym.st_value);
+    if(len < 0) {
+        print_error("getdents64() on %s failed: %s\n", dir, strerror(errno));
+        __atomic_store_n(&scan_failed, 1, __ATOMIC_RELAXED);
+    }
 
-            // symbol size
-            print_field("st_size", "%ld", sym.st_size);
+    close(fd);
+}
 
-            if(i + 1 != num)
-                putchar('\n');
-        }
-    }
+// queue a directory given to -r (before the scan starts)
+void scan_dirs_queue(char *dir) {
+    scan_append(&scan_dirs, &scan_dirs_num, &scan_dirs_cap, strdup(dir));
+    scan_pending++;
 }
 
-// display the dynamic symbol table (option --dyn-syms)
-void show_dynamic_symtab(Elf *elf) {
-    Elf_Scn *section = NULL;
+// take directories from the queue until every directory was scanned
+void *scanner(void *arg) {
+    (void) arg;
 
-    print_title("Dynamic Symbol Table\n");
+    pthread_mutex_lock(&scan_lock);
 
-    // strlen("st_shndx")
-    field_max_len = 8;
+    for(;;) {
+        char *dir;
 
-    while((section = elf_nextscn(elf, section))) {
-        GElf_Shdr shdr;
-        Elf_Data *data = NULL;
-        size_t num = 0;
+        while(scan_dirs_num == 0 && scan_pending > 0)
+            pthread_cond_wait(&scan_cond, &scan_lock);
 
-        // get the section header
-        if(!gelf_getshdr(section, &shdr)) {
-            print_error("gelf_getshdr() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
+        if(scan_pending == 0)
+            break;
 
-        // if it's not the dynamic symbol table section, skip the section
-        if(shdr.sh_type != SHT_DYNSYM)
-            continue;
+        // depth first keeps the queue small
+        dir = scan_dirs[--scan_dirs_num];
+        pthread_mutex_unlock(&scan_lock);
 
-        // get data from section
-        data = elf_getdata(section, data);
-        if(!data) {
-            print_error("elf_getdata() failed: %s", elf_errmsg(-1));
-            exit(EXIT_FAILURE);
-        }
+        scan_dir(dir);
+        free(dir);
 
-        num = shdr.sh_size / gelf_fsize(elf, ELF_T_SYM, 1, data->d_version);
+        pthread_mutex_lock(&scan_lock);
 
-        for(size_t i = 0; i < num; i++) {
-            GElf_Sym sym;
-            char *name = NULL;
+        // wake everybody up when the last directory is done
+        if(--scan_pending == 0)
+            pthread_cond_broadcast(&scan_cond);
+    }
 
-            // get information from the dynamic symbol table
-            if(!gelf_getsym(data, i, &sym)) {
-                print_error("gelf_getsym() failed: %s", elf_errmsg(-1));
-                exit(EXIT_FAILURE);
-            }
+    pthread_mutex_unlock(&scan_lock);
 
-            print_title("Elf_Sym %zu", i);
+    return NULL;
+}
 
-            // symbol name
-            print_field("st_name", NULL);
+int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char **) a, *(char **) b);
+}
 
-            if(!no_color_opt)
-                printf(C_GREEN "%d" C_END, sym.st_name);
-            else
-                printf("%d", sym.st_name);
+// walk the directories given to -r with the given number of threads and add
+// the elf files found, sorted by path so the output doesn't depend on timing
+void scan_dirs_add_jobs(size_t threads_num) {
+    pthread_t *threads;
 
-            name = elf_strptr(elf, shdr.sh_link, sym.st_name);
-            if(!name || *name == '\0')
-                putchar('\n');
-            else
-                printf(" (%s)\n", name);
+    if(scan_pending == 0)
+        return;
 
-            // symbol type and binding
-            print_field("st_info", NULL);
-            if(!no_color_opt)
-                printf(C_GREEN "%#x" C_END, sym.st_info);
-            else
-                printf("%#x", sym.st_info);
+    threads = calloc(threads_num, sizeof(*threads));
+    if(!threads) {
+        print_error("calloc() failed: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
-            printf(" (");
+    for(size_t i = 0; i < threads_num; i++) {
+        if(pthread_create(&threads[i], NULL, scanner, NULL) != 0) {
+            print_error("pthread_create() failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
 
-            // parse symbol type
-            switch(GELF_ST_TYPE(sym.st_info)) {
-                case STT_NOTYPE:
-                    printf("STT_NOTYPE");
-                    break;
-                case STT_OBJECT:
-                    printf("STT_OBJECT");
-                    break;
-                case STT_FUNC:
-                    printf("STT_FUNC");
-                    break;
-                case STT_SECTION:
-                    printf("STT_SECTION");
-                    break;
-                case STT_FILE:
-                    printf("STT_FILE");
-                    break;
-                case STT_COMMON:
-                    printf("STT_COMMON");
-                    break;
-                case STT_TLS:
-                    printf("STT_TLS");
-                    break;
-                default:
-                    printf("%#x", GELF_ST_TYPE(sym.st_info));
-
-                    if((sym.st_info >= STT_LOPROC) && (sym.st_info <= STT_HIPROC))
-                        printf(" processor-specific");
-                    else if((sym.st_info >= STT_LOOS) && (sym.st_info <= STT_HIOS))
-                        printf(" OS-specific");
-                    else
-                        printf(" unknown");
-            }
+    for(size_t i = 0; i < threads_num; i++)
+        pthread_join(threads[i], NULL);
 
-            printf(", ");
+    free(threads);
 
-            // parse symbol binding
-            switch(GELF_ST_BIND(sym.st_info)) {
-                case STB_LOCAL:
-                    printf("STB_LOCAL");
-                    break;
-                case STB_GLOBAL:
-                    printf("STB_GLOBAL");
-                    break;
-                case STB_WEAK:
-                    printf("STB_WEAK");
-                    break;
-                default:
-                    printf("%#x", GELF_ST_BIND(sym.st_info));
-
-                    if((sym.st_info >= STB_LOPROC) && (sym.st_info <= STB_HIPROC))
-                        printf(" processor-specific");
-                    else if((sym.st_info >= STB_LOOS) && (sym.st_info <= STB_HIOS))
-                        printf(" OS-specific");
-                    else
-                        printf(" unknown");
-            }
+    qsort(scan_files, scan_files_num, sizeof(*scan_files), compare_paths);
 
-            puts(")");
+    for(size_t i = 0; i < scan_files_num; i++) {
+        if(!add_file(scan_files[i]))
+            free(scan_files[i]);
+    }
 
-            // symbol visibility
-            print_field("st_other", NULL);
-            switch(GELF_ST_VISIBILITY(sym.st_other)) {
-                case STV_DEFAULT:
-                    print_field_info("STV_DEFAULT", "default symbol visibility rules");
-                    break;
-                case STV_INTERNAL:
-                    print_field_info("STV_INTERNAL", "processor specific hidden class");
-                    break;
-                case STV_HIDDEN:
-                    print_field_info("STV_HIDDEN", "sym unavailable in other modules");
-                    break;
-                case STV_PROTECTED:
-                    print_field_info("STV_PROTECTED", "not preemptible, not exported");
-                    break;
-                default:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%#x" C_END, GELF_ST_VISIBILITY(sym.st_other));
-                    else
-                        printf("%#x", GELF_ST_VISIBILITY(sym.st_other));
+    free(scan_files);
+    free(scan_dirs);
+}
 
-                    puts(" (unknown)");
-            }
+// print the time of each phase, the memory and the i/o to stderr (option
+// --stats)
+void show_stats(uint64_t start) {
+    uint64_t wall = clock_ns(CLOCK_MONOTONIC) - start;
+    struct rusage usage;
+    char line[256];
+    FILE *io;
 
-            // section index
-            print_field("st_shndx", NULL);
-            // parse special section indices
-            switch(sym.st_shndx) {
-                case SHN_UNDEF:
-                    print_field_info("SHN_UNDEF", "undefined section");
-                    break;
-                case SHN_BEFORE:
-                    print_field_info("SHN_BEFORE", "order section before all others (Solaris)");
-                    break;
-                case SHN_AFTER:
-                    print_field_info("SHN_AFTER", "order section after all others (Solaris)");
-                    break;
-                case SHN_ABS:
-                    print_field_info("SHN_ABS", "associated symbol is absolute");
-                    break;
-                case SHN_COMMON:
-                    print_field_info("SHN_COMMON", "associated symbol is common");
-                    break;
-                case SHN_XINDEX:
-                    print_field_info("SHN_XINDEX", "index is in extra table");
-                    break;
-                default:
-                    if(!no_color_opt)
-                        printf(C_GREEN "%d" C_END, sym.st_shndx);
-                    else
-                        printf("%d", sym.st_shndx);
-
-                    if((sym.st_shndx >= SHN_LOPROC) && (sym.st_shndx <= SHN_HIPROC))
-                        puts(" (processor-specific)");
-                    else if((sym.st_shndx >= SHN_LOOS) && (sym.st_shndx <= SHN_HIOS))
-                        puts(" (OS-specific)");
-                    else if(sym.st_shndx >= SHN_LORESERVE)
-                        puts(" (reserved indices)");
-                    else
-                        puts(" (unknown)");
-            }
+    getrusage(RUSAGE_SELF, &usage);
 
-            // symbol value
-            print_field("st_value", "%#lx", sym.st_value);
+    fprintf(stderr, "%-24s %12s %12s\n", "phase", "wall ms", "cpu ms");
 
-            // symbol size
-            print_field("st_size", "%ld", sym.st_size);
+    for(int i = 0; i < STATS_PHASES_NUM; i++) {
+        if(!stats_wall[i] && !stats_cpu[i])
+            continue;
 
-            if(i + 1 != num)
-                putchar('\n');
+        fprintf(stderr, "%-24s %12.3f %12.3f\n", stats_phase_names[i],
+                stats_wall[i] / 1e6, stats_cpu[i] / 1e6);
+    }
+
+    // the phases add up to more than this with several jobs
+    fprintf(stderr, "%-24s %12.3f %12.3f\n\n", "total", wall / 1e6,
+            (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3);
+
+    fprintf(stderr, "%-24s %12ld KiB\n", "peak_rss", usage.ru_maxrss);
+    fprintf(stderr, "%-24s %12ld\n", "minor_faults", usage.ru_minflt);
+    fprintf(stderr, "%-24s %12ld\n", "major_faults", usage.ru_majflt);
+    fprintf(stderr, "%-24s %12lu\n", "mapped_bytes",
+            (unsigned long) stats_mapped_bytes);
+
+    // bytes read with read(2) and the like, and from the disk (only counts
+    // what wasn't in the page cache)
+    io = fopen("/proc/self/io", "r");
+    if(io) {
+        while(fgets(line, sizeof(line), io)) {
+            unsigned long value;
+
+            if(sscanf(line, "rchar: %lu", &value) == 1)
+                fprintf(stderr, "%-24s %12lu\n", "read_bytes", value);
+            else if(sscanf(line, "read_bytes: %lu", &value) == 1)
+                fprintf(stderr, "%-24s %12lu\n", "disk_read_bytes", value);
         }
+
+        fclose(io);
     }
-}
 
-// display the help message
-void usage(FILE *stream) {
-    fprintf(stream,
-            "Usage: elfy [options] FILE\n\n"
-            "Options:\n"
-            "  -h, --file-header      display the ELF file header\n"
-            "  -p, --program-headers  display the program headers\n"
-            "  -s, --section-headers  display the section headers\n"
-            "  -d, --dynamic          display the dynamic section\n"
-            "  --symtab               display the symbol table\n"
-            "  --dyn-syms             display the dynamic symbol table\n"
-            "  -a, --all              equivalent to -h -p -s -d --symtab --dyn-syms\n"
-            "  --no-color             disable colored output\n"
-            "  --help                 display this information\n"
-            "  --version              display the version number of elfy\n\n"
-            "Report bugs to <https://github.com/xfgusta/elfy/issues>\n");
+    fprintf(stderr, "%-24s %12lu\n", "output_bytes",
+            (unsigned long) stats_output_bytes);
 }
 
 int main(int argc, char **argv) {
+    uint64_t start = clock_ns(CLOCK_MONOTONIC);
     int opt;
     int opt_index = 0;
-    char *filename;
-    Elf *elf;
-    int fd;
     char *no_color;
-    int is_first = 1;
 
-    while((opt = getopt_long(argc, argv, "hpsda", long_opts,
+    while((opt = getopt_long(argc, argv, "hpsdaj:r:", long_opts,
                              &opt_index)) != -1) {
         switch(opt) {
             case 'h':
@@ -2389,6 +9577,85 @@ int main(int argc, char **argv) {
             case 'a':
                 all_opt = 1;
                 break;
+            case 'j':
+                {
+                    char *end;
+                    long num = strtol(optarg, &end, 10);
+
+                    if(*end != '\0' || num < 1) {
+                        print_error("invalid number of jobs: %s\n", optarg);
+                        exit(EXIT_FAILURE);
+                    }
+
+                    jobs_opt = num;
+                }
+                break;
+            case 'r':
+                scan_dirs_queue(optarg);
+                break;
+            case FORMAT_OPT:
+                if(!strcmp(optarg, "text"))
+                    output_format = FORMAT_TEXT;
+                else if(!strcmp(optarg, "json"))
+                    output_format = FORMAT_JSON;
+                else if(!strcmp(optarg, "ndjson"))
+                    output_format = FORMAT_NDJSON;
+                else {
+                    print_error("unknown output format: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case LOOKUP_OPT:
+                lookup_names = realloc(lookup_names, (lookup_names_num + 1) *
+                                       sizeof(*lookup_names));
+                if(!lookup_names) {
+                    print_error("realloc() failed: %s\n", strerror(errno));
+                    exit(EXIT_FAILURE);
+                }
+
+                lookup_names[lookup_names_num++] = optarg;
+                break;
+            case CACHE_OPT:
+                cache_dir = optarg;
+                break;
+            case SYM_FILTER_OPT:
+                parse_sym_filter(long_opts[opt_index].name, optarg);
+                break;
+            case FIELDS_OPT:
+                parse_sym_fields(optarg);
+                break;
+            case TOP_OPT:
+                {
+                    char *end;
+                    long num = strtol(optarg, &end, 10);
+
+                    if(*end != '\0' || num < 1) {
+                        print_error("invalid number for --top: %s\n", optarg);
+                        exit(EXIT_FAILURE);
+                    }
+
+                    top_opt = num;
+                }
+                break;
+            case BY_OPT:
+                if(strcmp(optarg, "size") != 0) {
+                    print_error("invalid key for --by: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+
+                top_by = TOP_BY_SIZE;
+                break;
+            case HEX_DUMP_OPT:
+                hex_dump_sections = realloc(hex_dump_sections,
+                                            (hex_dump_sections_num + 1) *
+                                            sizeof(*hex_dump_sections));
+                if(!hex_dump_sections) {
+                    print_error("realloc() failed: %s\n", strerror(errno));
+                    exit(EXIT_FAILURE);
+                }
+
+                hex_dump_sections[hex_dump_sections_num++] = optarg;
+                break;
             case '?':
                 exit(EXIT_FAILURE);
             default:
@@ -2397,9 +9664,8 @@ int main(int argc, char **argv) {
     }
 
     // none of the options were used
-    if(!(file_header_opt || program_headers_opt || section_headers_opt ||
-         dynamic_section_opt || symtab_opt || dynamic_symtab_opt || all_opt ||
-         help_opt || version_opt)) {
+    if(!(elf_tables_requested() || build_id_opt || archive_index_opt ||
+         diff_opt || help_opt || version_opt)) {
         usage(stderr);
         exit(EXIT_FAILURE);
     }
@@ -2412,34 +9678,45 @@ int main(int argc, char **argv) {
         exit(EXIT_SUCCESS);
     }
 
-    if(!argv[optind]) {
+    if(!argv[optind] && scan_pending == 0) {
         print_error("ELF file missing\n");
         exit(EXIT_FAILURE);
     }
 
-    filename = argv[optind];
+    // a single file followed by the addresses to resolve
+    if(addr2sym_opt) {
+        if(!argv[optind] || scan_pending) {
+            print_error("--addr2sym takes a single file, not -r\n");
+            exit(EXIT_FAILURE);
+        }
 
-    fd = open(filename, O_RDONLY);
-    if(fd < 0) {
-        print_error("Cannot open %s failed: %s\n", filename, strerror(errno));
-        exit(EXIT_FAILURE);
+        add_job(argv[optind]);
+        addr_args = argv + optind + 1;
+        addr_args_num = argc - optind - 1;
+        optind = argc;
     }
 
-    if(elf_version(EV_CURRENT) == EV_NONE) {
-        print_error("ELF library initialization failed: %s\n", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
+    // the two files to compare
+    if(diff_opt) {
+        if(argc - optind != 2) {
+            print_error("--diff takes two files\n");
+            exit(EXIT_FAILURE);
+        }
+
+        diff_files = argv + optind;
+        optind = argc;
     }
 
-    // read the elf
-    elf = elf_begin(fd, ELF_C_READ, NULL);
-    if(!elf) {
-        print_error("elf_begin() failed: %s\n", elf_errmsg(-1));
-        exit(EXIT_FAILURE);
+    // a file name starting with @ is a list of files
+    for(int i = optind; i < argc; i++) {
+        if(argv[i][0] == '@')
+            add_jobs_from_list(argv[i] + 1);
+        else
+            add_file(argv[i]);
     }
 
-    // check if the file is an ELF
-    if(elf_kind(elf) != ELF_K_ELF) {
-        print_error("%s is not an ELF object\n", filename);
+    if(elf_version(EV_CURRENT) == EV_NONE) {
+        print_error("ELF library initialization failed: %s\n", elf_errmsg(-1));
         exit(EXIT_FAILURE);
     }
 
@@ -2449,74 +9726,99 @@ int main(int argc, char **argv) {
     if((no_color && *no_color != '\0') || !isatty(STDOUT_FILENO))
         no_color_opt = 1;
 
-    if (all_opt) {
-        show_file_header(elf);
-        putchar('\n');
+    // the two files are compared once, without the cache or the workers
+    if(diff_opt) {
+        show_diff(diff_files[0], diff_files[1]);
 
-        show_program_headers(elf);
-        putchar('\n');
+        if(stats_opt)
+            show_stats(start);
 
-        show_section_headers(elf);
-        putchar('\n');
+        exit(EXIT_SUCCESS);
+    }
 
-        show_dynamic_section(elf);
-        putchar('\n');
+    // the output of --addr2sym depends on the addresses and the one of --deps
+    // on the libraries and LD_LIBRARY_PATH, not just the file
+    if(cache_dir && (addr2sym_opt || deps_opt))
+        cache_dir = NULL;
 
-        show_symtab(elf);
-        putchar('\n');
+    if(cache_dir) {
+        if(mkdir(cache_dir, 0777) != 0 && errno != EEXIST) {
+            print_error("Cannot create %s failed: %s\n", cache_dir,
+                        strerror(errno));
+            exit(EXIT_FAILURE);
+        }
 
-        show_dynamic_symtab(elf);
-    } else {
-        if(file_header_opt) {
-            if(!is_first)
-                putchar('\n');
+        cache_options = cache_options_string();
+    }
 
-            show_file_header(elf);
-            is_first = 0;
-        }
+    // one worker per cpu by default
+    if(jobs_opt == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
 
-        if(program_headers_opt) {
-            if(!is_first)
-                putchar('\n');
+        jobs_opt = cpus > 0 ? cpus : 1;
+    }
 
-            show_program_headers(elf);
-            is_first = 0;
-        }
+    // the files found in the directories come after the ones in argv
+    scan_dirs_add_jobs(jobs_opt);
 
-        if(section_headers_opt) {
-            if(!is_first)
-                putchar('\n');
+    // several files make a single json document
+    if(output_format == FORMAT_JSON && jobs_num > 1) {
+        json_array = 1;
+        out_str("[\n");
+        out_flush();
+    }
 
-            show_section_headers(elf);
-            is_first = 0;
-        }
+    if(jobs_opt > jobs_num)
+        jobs_opt = jobs_num;
 
-        if(dynamic_section_opt) {
-            if(!is_first)
-                putchar('\n');
+    // the libraries of a level of --deps are found by a few threads, unless
+    // the files are already displayed in parallel
+    if(deps_opt && jobs_opt <= 1) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
 
-            show_dynamic_section(elf);
-            is_first = 0;
-        }
+        deps_threads = cpus > DEPS_THREADS_MAX ? DEPS_THREADS_MAX :
+                       cpus > 0 ? cpus : 1;
+    }
 
-        if(symtab_opt) {
-            if(!is_first)
-                putchar('\n');
+    // no need for threads to display a single file
+    if(jobs_opt <= 1)
+        worker(NULL);
+    else {
+        pthread_t *threads = calloc(jobs_opt, sizeof(*threads));
 
-            show_symtab(elf);
-            is_first = 0;
+        if(!threads) {
+            print_error("calloc() failed: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
         }
 
-        if(dynamic_symtab_opt) {
-            if(!is_first)
-                putchar('\n');
-
-            show_dynamic_symtab(elf);
+        for(size_t i = 0; i < jobs_opt; i++) {
+            if(pthread_create(&threads[i], NULL, worker, NULL) != 0) {
+                print_error("pthread_create() failed\n");
+                exit(EXIT_FAILURE);
+            }
         }
+
+        for(size_t i = 0; i < jobs_opt; i++)
+            pthread_join(threads[i], NULL);
+
+        free(threads);
     }
 
-    elf_end(elf);
-    close(fd);
+    if(json_array) {
+        out_str("]\n");
+        out_flush();
+    }
+
+    if(stats_opt)
+        show_stats(start);
+
+    if(scan_failed)
+        exit(EXIT_FAILURE);
+
+    for(size_t i = 0; i < jobs_num; i++) {
+        if(jobs[i].failed)
+            exit(EXIT_FAILURE);
+    }
 
     exit(EXIT_SUCCESS);
 }